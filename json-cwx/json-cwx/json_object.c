@@ -22,6 +22,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(HAVE_FCNTL_H) && defined(HAVE_UNISTD_H) && !defined(_WIN32)
+# define JSON_C_HAVE_MMAP 1
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
 #include "debug.h"
 #include "printbuf.h"
 #include "linkhash.h"
@@ -55,6 +62,7 @@ const char *json_hex_chars = "0123456789abcdefABCDEF";
 
 static void json_object_generic_delete(struct json_object* jso);
 static struct json_object* json_object_new(enum json_type o_type);
+static void json_object_extarr_free_data(struct json_object* jso);
 
 static json_object_to_json_string_fn json_object_object_to_json_string;
 static json_object_to_json_string_fn json_object_boolean_to_json_string;
@@ -97,6 +105,233 @@ static void json_object_fini(void) {
 #endif /* REFCOUNT_DEBUG */
 
 
+/* arena allocation */
+
+#define JSON_ARENA_ALIGN 16
+#define JSON_ARENA_ROUND(n) (((n) + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1))
+
+#if defined(_MSC_VER)
+# define JSON_ARENA_THREAD __declspec(thread)
+#else
+# define JSON_ARENA_THREAD __thread
+#endif
+
+struct json_arena_block
+{
+  struct json_arena_block *next;
+  size_t size;
+  size_t used;
+};
+
+/* an arena object owning memory that is not from the arena */
+struct json_arena_fini
+{
+  struct json_arena_fini *next;
+  struct json_object *jso;
+};
+
+struct json_arena
+{
+  struct json_arena_block *blocks; /* head is the block being filled */
+  struct json_arena_fini *finis;
+  size_t block_size;
+};
+
+static JSON_ARENA_THREAD struct json_arena *json_arena_in_use = NULL;
+
+struct json_arena* json_arena_new(size_t block_size)
+{
+  struct json_arena *arena;
+
+  arena = (struct json_arena*)calloc(1, sizeof(struct json_arena));
+  if(!arena) return NULL;
+  arena->block_size = block_size ? block_size : JSON_C_ARENA_BLOCK;
+  return arena;
+}
+
+struct json_arena* json_arena_use(struct json_arena *arena)
+{
+  struct json_arena *prev = json_arena_in_use;
+  json_arena_in_use = arena;
+  return prev;
+}
+
+struct json_arena* json_arena_current(void)
+{
+  return json_arena_in_use;
+}
+
+static void* json_arena_alloc(struct json_arena *arena, size_t size)
+{
+  struct json_arena_block *b = arena->blocks;
+  size_t hdr = JSON_ARENA_ROUND(sizeof(struct json_arena_block));
+  void *p;
+
+  size = JSON_ARENA_ROUND(size);
+  if(!b || b->size - b->used < size)
+  {
+    /* big requests get a block of their own behind the one being filled */
+    int own = size > arena->block_size / 4;
+    size_t bsize = own ? size : arena->block_size;
+
+    if(!(b = (struct json_arena_block*)malloc(hdr + bsize))) return NULL;
+    b->size = bsize;
+    b->used = 0;
+    if(own && arena->blocks)
+    {
+      b->next = arena->blocks->next;
+      arena->blocks->next = b;
+    }
+    else
+    {
+      b->next = arena->blocks;
+      arena->blocks = b;
+    }
+  }
+  p = (char*)b + hdr + b->used;
+  b->used += size;
+  return p;
+}
+
+void* json_arena_calloc(struct json_arena *arena, size_t nmemb, size_t size)
+{
+  void *p;
+
+  if(!arena) return calloc(nmemb, size);
+  if(size && nmemb > (size_t)-1 / size) return NULL;
+  if(!(p = json_arena_alloc(arena, nmemb * size))) return NULL;
+  return memset(p, 0, nmemb * size);
+}
+
+void* json_arena_realloc(struct json_arena *arena, void *ptr, size_t old_size, size_t size)
+{
+  void *p;
+
+  if(!arena) return realloc(ptr, size);
+  if(!(p = json_arena_alloc(arena, size))) return NULL;
+  if(ptr) memcpy(p, ptr, old_size < size ? old_size : size);
+  return p;
+}
+
+char* json_arena_strndup(struct json_arena *arena, const char *s, size_t len)
+{
+  char *p = arena ? (char*)json_arena_alloc(arena, len + 1) : (char*)malloc(len + 1);
+
+  if(!p) return NULL;
+  memcpy(p, s, len);
+  p[len] = '\0';
+  return p;
+}
+
+void json_arena_release(struct json_arena *arena, void *ptr)
+{
+  if(!arena) free(ptr);
+}
+
+/* Remember to free what jso owns outside its arena when the arena is freed.
+   Tracking an object more than once is harmless. */
+static void json_arena_track(struct json_object *jso)
+{
+  struct json_arena_fini *f;
+
+  if(!jso->_arena) return;
+  f = (struct json_arena_fini*)json_arena_alloc(jso->_arena, sizeof(struct json_arena_fini));
+  if(!f) return;
+  f->jso = jso;
+  f->next = jso->_arena->finis;
+  jso->_arena->finis = f;
+}
+
+void json_arena_free(struct json_arena *arena)
+{
+  struct json_arena_fini *f;
+  struct json_arena_block *b, *next;
+
+  if(!arena) return;
+  if(json_arena_in_use == arena) json_arena_in_use = NULL;
+  for(f = arena->finis; f; f = f->next)
+  {
+    struct json_object *jso = f->jso;
+    if(jso->_user_delete)
+      jso->_user_delete(jso, jso->_userdata);
+    jso->_user_delete = NULL;
+    printbuf_free(jso->_pb);
+    jso->_pb = NULL;
+    if(jso->o_type == json_type_extarr)
+      json_object_extarr_free_data(jso);
+  }
+  for(b = arena->blocks; b; b = next)
+  {
+    next = b->next;
+    free(b);
+  }
+  free(arena);
+}
+
+
+/* size accounting caches */
+
+/* Bumped to invalidate all cached sizes when an object with more than
+   one parent changes */
+static unsigned json_nbytes_gen = 0;
+
+static int json_object_nbytes_cached(struct json_object *jso)
+{
+  return jso->_nbytes_gen == json_nbytes_gen &&
+         (jso->_nbytes[0] >= 0 || jso->_nbytes[1] >= 0);
+}
+
+/* Note jso's size changed. An ancestor's size can only be cached if
+   jso's was, so the walk up stops at the first object without one. */
+static void json_object_nbytes_changed(struct json_object *jso)
+{
+  int first = 1;
+
+  while(jso)
+  {
+    if(jso->o_type == json_type_object || jso->o_type == json_type_array)
+    {
+      if(!json_object_nbytes_cached(jso) && !first) return;
+      jso->_nbytes[0] = jso->_nbytes[1] = -1;
+    }
+    if(jso->_nparents > 1)
+    {
+      json_nbytes_gen++;
+      return;
+    }
+    jso = jso->_parent;
+    first = 0;
+  }
+}
+
+/* Note child was put into parent. Objects in more than one parent or from
+   another arena are never walked up from. */
+static void json_object_link(struct json_object *child, struct json_object *parent)
+{
+  if(!child) return;
+  if(child->_nparents == 0 && child->_arena == parent->_arena)
+  {
+    child->_parent = parent;
+    child->_nparents = 1;
+  }
+  else
+  {
+    child->_parent = NULL;
+    child->_nparents = 2;
+  }
+}
+
+/* Note child was taken out of parent */
+static void json_object_unlink(struct json_object *child, struct json_object *parent)
+{
+  if(child && child->_nparents == 1 && child->_parent == parent)
+  {
+    child->_parent = NULL;
+    child->_nparents = 0;
+  }
+}
+
+
 /* string escaping */
 
 static int json_escape_str(struct printbuf *pb, char *str, int len)
@@ -160,6 +395,9 @@ int json_object_put(struct json_object *jso)
 		jso->_ref_count--;
 		if(!jso->_ref_count)
 		{
+			/* left for json_arena_free() */
+			if (jso->_arena)
+				return 1;
 			if (jso->_user_delete)
 				jso->_user_delete(jso, jso->_userdata);
 			jso->_delete(jso);
@@ -186,11 +424,14 @@ static void json_object_generic_delete(struct json_object* jso)
 static struct json_object* json_object_new(enum json_type o_type)
 {
   struct json_object *jso;
+  struct json_arena *arena = json_arena_in_use;
 
-  jso = (struct json_object*)calloc(sizeof(struct json_object), 1);
+  jso = (struct json_object*)json_arena_calloc(arena, 1, sizeof(struct json_object));
   if(!jso) return NULL;
+  jso->_arena = arena;
   jso->o_type = o_type;
   jso->_ref_count = 1;
+  jso->_nbytes[0] = jso->_nbytes[1] = -1;
   jso->_delete = &json_object_generic_delete;
 #ifdef REFCOUNT_DEBUG
   lh_table_insert(json_object_table, jso, jso);
@@ -270,6 +511,8 @@ void json_object_set_serializer(json_object *jso,
 	jso->_to_json_string = to_string_func;
 	jso->_userdata = userdata;
 	jso->_user_delete = user_delete;
+	if (user_delete)
+		json_arena_track(jso);
 }
 
 
@@ -280,8 +523,12 @@ const char* json_object_to_json_string_ext(struct json_object *jso, int flags)
 	if (!jso)
 		return "null";
 
-	if ((!jso->_pb) && !(jso->_pb = printbuf_new()))
-		return NULL;
+	if (!jso->_pb)
+	{
+		if (!(jso->_pb = printbuf_new()))
+			return NULL;
+		json_arena_track(jso);
+	}
 
 	printbuf_reset(jso->_pb);
 
@@ -291,6 +538,32 @@ const char* json_object_to_json_string_ext(struct json_object *jso, int flags)
 	return jso->_pb->buf;
 }
 
+int json_object_to_json_sink(struct json_object *jso, int flags,
+                             json_object_sink_fn *sink, void *data)
+{
+	struct printbuf *pb;
+	int ret;
+
+	if (!jso)
+		return sink(data, "null", 4);
+
+	if (!(pb = printbuf_new()))
+		return -1;
+
+	pb->sink = sink;
+	pb->sink_data = data;
+	pb->sink_chunk = JSON_C_SINK_CHUNK;
+
+	ret = jso->_to_json_string(jso, pb, 0, flags);
+	if (printbuf_flush(pb))
+		ret = pb->sink_err;
+	else if (ret > 0)
+		ret = 0;
+
+	printbuf_free(pb);
+	return ret;
+}
+
 /* backwards-compatible conversion to string */
 
 const char* json_object_to_json_string(struct json_object *jso)
@@ -361,8 +634,17 @@ static void json_object_lh_entry_free(struct lh_entry *ent)
   json_object_put((struct json_object*)ent->v);
 }
 
+/* keys of arena tables are from the arena too */
+static void json_object_lh_arena_entry_free(struct lh_entry *ent)
+{
+  json_object_put((struct json_object*)ent->v);
+}
+
 static void json_object_object_delete(struct json_object* jso)
 {
+  struct lh_entry *ent;
+  lh_foreach(jso->o.c_object, ent)
+    json_object_unlink((struct json_object*)ent->v, jso);
   lh_table_free(jso->o.c_object);
   json_object_generic_delete(jso);
 }
@@ -373,8 +655,9 @@ struct json_object* json_object_new_object(void)
   if(!jso) return NULL;
   jso->_delete = &json_object_object_delete;
   jso->_to_json_string = &json_object_object_to_json_string;
-  jso->o.c_object = lh_kchar_table_new(JSON_OBJECT_DEF_HASH_ENTRIES,
-					NULL, &json_object_lh_entry_free);
+  jso->o.c_object = lh_table_new_arena(jso->_arena, JSON_OBJECT_DEF_HASH_ENTRIES, NULL,
+					jso->_arena ? &json_object_lh_arena_entry_free : &json_object_lh_entry_free,
+					lh_char_hash, lh_char_equal);
   return jso;
 }
 
@@ -397,14 +680,19 @@ void json_object_object_add(struct json_object* jso, const char *key,
 	json_object *existing_value = NULL;
 	struct lh_entry *existing_entry;
 	existing_entry = lh_table_lookup_entry(jso->o.c_object, (void*)key);
+	json_object_link(val, jso);
+	json_object_nbytes_changed(jso);
 	if (!existing_entry)
 	{
-		lh_table_insert(jso->o.c_object, strdup(key), val);
+		lh_table_insert(jso->o.c_object, json_arena_strndup(jso->_arena, key, strlen(key)), val);
 		return;
 	}
 	existing_value = (json_object *)existing_entry->v;
 	if (existing_value)
+	{
+		json_object_unlink(existing_value, jso);
 		json_object_put(existing_value);
+	}
 	existing_entry->v = val;
 }
 
@@ -441,7 +729,11 @@ json_bool json_object_object_get_ex(struct json_object* jso, const char *key, st
 
 void json_object_object_del(struct json_object* jso, const char *key)
 {
-	lh_table_delete(jso->o.c_object, key);
+	struct lh_entry *e = lh_table_lookup_entry(jso->o.c_object, key);
+	if (!e) return;
+	json_object_unlink((struct json_object*)e->v, jso);
+	json_object_nbytes_changed(jso);
+	lh_table_delete_entry(jso->o.c_object, e);
 }
 
 
@@ -637,7 +929,8 @@ struct json_object* json_object_new_double_s(double d, const char *ds)
 		return NULL;
 
 	json_object_set_serializer(jso, json_object_userdata_to_json_string,
-	    strdup(ds), json_object_free_userdata);
+	    json_arena_strndup(jso->_arena, ds, strlen(ds)),
+	    jso->_arena ? NULL : json_object_free_userdata);
 	return jso;
 }
 
@@ -731,8 +1024,8 @@ struct json_object* json_object_new_string(const char *s)
   if(!jso) return NULL;
   jso->_delete = &json_object_string_delete;
   jso->_to_json_string = &json_object_string_to_json_string;
-  jso->o.c_string.str = strdup(s);
   jso->o.c_string.len = strlen(s);
+  jso->o.c_string.str = json_arena_strndup(jso->_arena, s, jso->o.c_string.len);
   return jso;
 }
 
@@ -742,9 +1035,7 @@ struct json_object* json_object_new_string_len(const char *s, int len)
   if(!jso) return NULL;
   jso->_delete = &json_object_string_delete;
   jso->_to_json_string = &json_object_string_to_json_string;
-  jso->o.c_string.str = (char*)malloc(len + 1);
-  memcpy(jso->o.c_string.str, (void *)s, len);
-  jso->o.c_string.str[len] = '\0';
+  jso->o.c_string.str = json_arena_strndup(jso->_arena, s, len);
   jso->o.c_string.len = len;
   return jso;
 }
@@ -822,6 +1113,9 @@ static void json_object_array_entry_free(void *data)
 
 static void json_object_array_delete(struct json_object* jso)
 {
+  int i;
+  for(i = 0; i < array_list_length(jso->o.c_array); i++)
+    json_object_unlink((struct json_object*)array_list_get_idx(jso->o.c_array, i), jso);
   array_list_free(jso->o.c_array);
   json_object_generic_delete(jso);
 }
@@ -832,7 +1126,7 @@ struct json_object* json_object_new_array(void)
   if(!jso) return NULL;
   jso->_delete = &json_object_array_delete;
   jso->_to_json_string = &json_object_array_to_json_string;
-  jso->o.c_array = array_list_new(&json_object_array_entry_free);
+  jso->o.c_array = array_list_new_arena(jso->_arena, &json_object_array_entry_free);
   return jso;
 }
 
@@ -859,12 +1153,17 @@ int json_object_array_length(struct json_object *jso)
 
 int json_object_array_add(struct json_object *jso,struct json_object *val)
 {
+  json_object_link(val, jso);
+  json_object_nbytes_changed(jso);
   return array_list_add(jso->o.c_array, val);
 }
 
 int json_object_array_put_idx(struct json_object *jso, int idx,
 			      struct json_object *val)
 {
+  json_object_unlink((struct json_object*)array_list_get_idx(jso->o.c_array, idx), jso);
+  json_object_link(val, jso);
+  json_object_nbytes_changed(jso);
   return array_list_put_idx(jso->o.c_array, idx, val);
 }
 
@@ -874,6 +1173,352 @@ struct json_object* json_object_array_get_idx(struct json_object *jso,
   return (struct json_object*)array_list_get_idx(jso->o.c_array, idx);
 }
 
+/*
+ * Fast numeric formatting for extarr values
+ *
+ * Formatting each element of an extarr by creating a temporary json_object
+ * and calling sprintbuf() on it dominates the cost of serializing large arrays.
+ * Instead, values are formatted directly to chars. Integers are converted with
+ * a simple digit loop. Doubles are converted to the shortest decimal string that
+ * parses back to the identical double using the Ryu algorithm (Ulf Adams, "Ryu:
+ * Fast Float-to-String Conversion", PLDI 2018). The digits are laid out like
+ * printf's "%.17g" (fixed notation for decimal exponents in [-4,17), exponential
+ * notation otherwise). Where no 128 bit integer type is available, "%.17g" is
+ * used instead.
+ */
+
+static int json_u64toa(uint64_t v, char *buf)
+{
+  char tmp[24];
+  int n = 0, i;
+  do {
+    tmp[n++] = (char) ('0' + v % 10);
+    v /= 10;
+  } while (v);
+  for (i = 0; i < n; i++)
+    buf[i] = tmp[n-1-i];
+  return n;
+}
+
+static int json_i64toa(int64_t v, char *buf)
+{
+  if (v < 0)
+  {
+    buf[0] = '-';
+    return 1 + json_u64toa((uint64_t) 0 - (uint64_t) v, buf+1);
+  }
+  return json_u64toa((uint64_t) v, buf);
+}
+
+#if defined(__SIZEOF_INT128__)
+
+#define JSON_DTOA_MANTISSA_BITS      52
+#define JSON_DTOA_EXPONENT_BITS      11
+#define JSON_DTOA_BIAS               1023
+#define JSON_DTOA_POW5_INV_BITCOUNT  125
+#define JSON_DTOA_POW5_BITCOUNT      125
+#define JSON_DTOA_POW5_INV_TABLE_SIZE 342
+#define JSON_DTOA_POW5_TABLE_SIZE    326
+
+typedef unsigned __int128 json_uint128_t;
+
+static uint64_t json_dtoa_pow5_inv_split[JSON_DTOA_POW5_INV_TABLE_SIZE][2];
+static uint64_t json_dtoa_pow5_split[JSON_DTOA_POW5_TABLE_SIZE][2];
+
+/* ceil(log2(5^e)) for e > 0 and 1 for e == 0 */
+static int json_dtoa_pow5bits(int e) { return (int) (((uint32_t) e * 1217359) >> 19) + 1; }
+/* floor(log10(2^e)) */
+static int json_dtoa_log10pow2(int e) { return (int) (((uint32_t) e * 78913) >> 18); }
+/* floor(log10(5^e)) */
+static int json_dtoa_log10pow5(int e) { return (int) (((uint32_t) e * 732923) >> 20); }
+
+/* Low 128 bits of (big >> shift) (or << -shift) for a little-endian bignum of nlimbs 32 bit limbs */
+static void json_dtoa_big_to_128(uint32_t const *big, int nlimbs, int shift, uint64_t *out)
+{
+  uint32_t w[4];
+  int i;
+  for (i = 0; i < 4; i++)
+  {
+    /* bit position in big of bit 32*i of the result */
+    int pos = 32 * i + shift;
+    int limb = pos >= 0 ? pos / 32 : -((-pos + 31) / 32);
+    int off = pos - 32 * limb;
+    uint64_t lo = (limb >= 0 && limb < nlimbs) ? big[limb] : 0;
+    uint64_t hi = (limb+1 >= 0 && limb+1 < nlimbs) ? big[limb+1] : 0;
+    w[i] = (uint32_t) (((hi << 32) | lo) >> off);
+  }
+  out[0] = ((uint64_t) w[1] << 32) | w[0];
+  out[1] = ((uint64_t) w[3] << 32) | w[2];
+}
+
+/* Computes the tables Ryu uses. This runs when the library is loaded, before any thread
+   can format a double, so readers need no synchronization. */
+static void json_dtoa_init_tables(void) __attribute__ ((constructor));
+static void json_dtoa_init_tables(void)
+{
+  uint32_t big[48];
+  int i, j, nlimbs;
+
+  /* 5^i, keeping the top 125 bits */
+  memset(big, 0, sizeof(big));
+  big[0] = 1;
+  nlimbs = 1;
+  for (i = 0; i < JSON_DTOA_POW5_TABLE_SIZE; i++)
+  {
+    uint64_t carry = 0;
+    json_dtoa_big_to_128(big, nlimbs, json_dtoa_pow5bits(i) - JSON_DTOA_POW5_BITCOUNT,
+                         json_dtoa_pow5_split[i]);
+    for (j = 0; j < nlimbs; j++)
+    {
+      uint64_t t = (uint64_t) big[j] * 5 + carry;
+      big[j] = (uint32_t) t;
+      carry = t >> 32;
+    }
+    if (carry) big[nlimbs++] = (uint32_t) carry;
+  }
+
+  /* floor(2^k / 5^i) + 1 with k = pow5bits(i) - 1 + POW5_INV_BITCOUNT */
+  for (i = 0; i < JSON_DTOA_POW5_INV_TABLE_SIZE; i++)
+  {
+    int k = json_dtoa_pow5bits(i) - 1 + JSON_DTOA_POW5_INV_BITCOUNT;
+    memset(big, 0, sizeof(big));
+    nlimbs = k / 32 + 1;
+    big[k / 32] = (uint32_t) 1 << (k % 32);
+    for (j = 0; j < i; j++)
+    {
+      uint64_t rem = 0;
+      int l;
+      for (l = nlimbs-1; l >= 0; l--)
+      {
+        uint64_t t = (rem << 32) | big[l];
+        big[l] = (uint32_t) (t / 5);
+        rem = t % 5;
+      }
+    }
+    for (j = 0; j < nlimbs && ++big[j] == 0; j++) ;
+    json_dtoa_big_to_128(big, nlimbs, 0, json_dtoa_pow5_inv_split[i]);
+  }
+}
+
+static int json_dtoa_pow5factor(uint64_t v)
+{
+  int count = 0;
+  for (;;) {
+    if (v % 5 != 0) return count;
+    v /= 5;
+    ++count;
+  }
+}
+
+static int json_dtoa_multiple_of_pow5(uint64_t v, int p) { return json_dtoa_pow5factor(v) >= p; }
+static int json_dtoa_multiple_of_pow2(uint64_t v, int p) { return (v & (((uint64_t) 1 << p) - 1)) == 0; }
+
+/* (m * mul) >> j for a 128 bit mul and j >= 64 */
+static uint64_t json_dtoa_mulshift(uint64_t m, uint64_t const *mul, int j)
+{
+  json_uint128_t b0 = (json_uint128_t) m * mul[0];
+  json_uint128_t b2 = (json_uint128_t) m * mul[1];
+  return (uint64_t) (((b0 >> 64) + b2) >> (j - 64));
+}
+
+/* Shortest decimal representation, output * 10^exp10, of a finite, positive double */
+static void json_dtoa_d2d(uint64_t ieee_mantissa, uint32_t ieee_exponent, uint64_t *output, int *exp10)
+{
+  int e2, e10, removed = 0;
+  uint64_t m2, mv, vr, vp, vm;
+  int even, accept_bounds, mm_shift;
+  int vm_trailing_zeros = 0, vr_trailing_zeros = 0;
+  uint8_t last_removed_digit = 0;
+
+  if (ieee_exponent == 0)
+  {
+    e2 = 1 - JSON_DTOA_BIAS - JSON_DTOA_MANTISSA_BITS - 2;
+    m2 = ieee_mantissa;
+  }
+  else
+  {
+    e2 = (int) ieee_exponent - JSON_DTOA_BIAS - JSON_DTOA_MANTISSA_BITS - 2;
+    m2 = ((uint64_t) 1 << JSON_DTOA_MANTISSA_BITS) | ieee_mantissa;
+  }
+  even = (m2 & 1) == 0;
+  accept_bounds = even;
+
+  /* interval of decimal values that round to this double is (4m2 - 1 - mm_shift, 4m2 + 2) * 2^e2 / 4 */
+  mv = 4 * m2;
+  mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+  if (e2 >= 0)
+  {
+    int q = json_dtoa_log10pow2(e2) - (e2 > 3);
+    int k = JSON_DTOA_POW5_INV_BITCOUNT + json_dtoa_pow5bits(q) - 1;
+    int i = -e2 + q + k;
+    e10 = q;
+    vr = json_dtoa_mulshift(4 * m2, json_dtoa_pow5_inv_split[q], i);
+    vp = json_dtoa_mulshift(4 * m2 + 2, json_dtoa_pow5_inv_split[q], i);
+    vm = json_dtoa_mulshift(4 * m2 - 1 - mm_shift, json_dtoa_pow5_inv_split[q], i);
+    if (q <= 21)
+    {
+      if (mv % 5 == 0)
+        vr_trailing_zeros = json_dtoa_multiple_of_pow5(mv, q);
+      else if (accept_bounds)
+        vm_trailing_zeros = json_dtoa_multiple_of_pow5(mv - 1 - mm_shift, q);
+      else
+        vp -= json_dtoa_multiple_of_pow5(mv + 2, q);
+    }
+  }
+  else
+  {
+    int q = json_dtoa_log10pow5(-e2) - (-e2 > 1);
+    int i = -e2 - q;
+    int k = json_dtoa_pow5bits(i) - JSON_DTOA_POW5_BITCOUNT;
+    int j = q - k;
+    e10 = q + e2;
+    vr = json_dtoa_mulshift(4 * m2, json_dtoa_pow5_split[i], j);
+    vp = json_dtoa_mulshift(4 * m2 + 2, json_dtoa_pow5_split[i], j);
+    vm = json_dtoa_mulshift(4 * m2 - 1 - mm_shift, json_dtoa_pow5_split[i], j);
+    if (q <= 1)
+    {
+      vr_trailing_zeros = 1;
+      if (accept_bounds)
+        vm_trailing_zeros = mm_shift == 1;
+      else
+        --vp;
+    }
+    else if (q < 63)
+    {
+      vr_trailing_zeros = json_dtoa_multiple_of_pow2(mv, q);
+    }
+  }
+
+  /* remove digits while the interval still holds a unique shortest representation */
+  if (vm_trailing_zeros || vr_trailing_zeros)
+  {
+    for (;;)
+    {
+      uint64_t vp_div10 = vp / 10, vm_div10 = vm / 10;
+      if (vp_div10 <= vm_div10) break;
+      vm_trailing_zeros &= vm % 10 == 0;
+      vr_trailing_zeros &= last_removed_digit == 0;
+      last_removed_digit = (uint8_t) (vr % 10);
+      vr /= 10; vp = vp_div10; vm = vm_div10;
+      ++removed;
+    }
+    if (vm_trailing_zeros)
+    {
+      while (vm % 10 == 0)
+      {
+        vr_trailing_zeros &= last_removed_digit == 0;
+        last_removed_digit = (uint8_t) (vr % 10);
+        vr /= 10; vp /= 10; vm /= 10;
+        ++removed;
+      }
+    }
+    /* round to even on an exact tie */
+    if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+      last_removed_digit = 4;
+    *output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed_digit >= 5);
+  }
+  else
+  {
+    int round_up = 0;
+    if (vp / 100 > vm / 100)
+    {
+      round_up = vr % 100 >= 50;
+      vr /= 100; vp /= 100; vm /= 100;
+      removed += 2;
+    }
+    for (;;)
+    {
+      if (vp / 10 <= vm / 10) break;
+      round_up = vr % 10 >= 5;
+      vr /= 10; vp /= 10; vm /= 10;
+      ++removed;
+    }
+    *output = vr + (vr == vm || round_up);
+  }
+  *exp10 = e10 + removed;
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/* Format a double into buf (at least 32 chars), returning the length */
+static int json_dtoa(double d, char *buf)
+{
+#if defined(__SIZEOF_INT128__)
+  uint64_t bits, ieee_mantissa, output;
+  uint32_t ieee_exponent;
+  char digits[24];
+  int n = 0, ndigits, exp10, sci, i;
+
+  if (isnan(d))
+    return sprintf(buf, "NaN");
+  if (isinf(d))
+    return sprintf(buf, d > 0 ? "Infinity" : "-Infinity");
+
+  memcpy(&bits, &d, sizeof(bits));
+  ieee_mantissa = bits & (((uint64_t) 1 << JSON_DTOA_MANTISSA_BITS) - 1);
+  ieee_exponent = (uint32_t) ((bits >> JSON_DTOA_MANTISSA_BITS) & ((1u << JSON_DTOA_EXPONENT_BITS) - 1));
+  if (bits >> 63)
+    buf[n++] = '-';
+  if (ieee_exponent == 0 && ieee_mantissa == 0)
+  {
+    buf[n++] = '0';
+    return n;
+  }
+
+  json_dtoa_d2d(ieee_mantissa, ieee_exponent, &output, &exp10);
+  ndigits = json_u64toa(output, digits);
+  sci = exp10 + ndigits - 1; /* exponent in scientific notation */
+
+  if (sci < -4 || sci >= 17)
+  {
+    buf[n++] = digits[0];
+    if (ndigits > 1)
+    {
+      buf[n++] = '.';
+      memcpy(buf+n, digits+1, ndigits-1);
+      n += ndigits-1;
+    }
+    buf[n++] = 'e';
+    buf[n++] = sci < 0 ? '-' : '+';
+    if (sci < 0) sci = -sci;
+    if (sci < 10) buf[n++] = '0';
+    n += json_u64toa((uint64_t) sci, buf+n);
+  }
+  else if (exp10 >= 0)
+  {
+    memcpy(buf+n, digits, ndigits);
+    n += ndigits;
+    for (i = 0; i < exp10; i++)
+      buf[n++] = '0';
+  }
+  else if (sci >= 0)
+  {
+    memcpy(buf+n, digits, sci+1);
+    n += sci+1;
+    buf[n++] = '.';
+    memcpy(buf+n, digits+sci+1, ndigits-sci-1);
+    n += ndigits-sci-1;
+  }
+  else
+  {
+    buf[n++] = '0';
+    buf[n++] = '.';
+    for (i = 0; i < -sci-1; i++)
+      buf[n++] = '0';
+    memcpy(buf+n, digits, ndigits);
+    n += ndigits;
+  }
+  return n;
+#else
+  if (isnan(d))
+    return sprintf(buf, "NaN");
+  if (isinf(d))
+    return sprintf(buf, d > 0 ? "Infinity" : "-Infinity");
+  return sprintf(buf, "%.17g", d);
+#endif
+}
+
 static int json_object_extarr_to_json_string(struct json_object* jso,
                                              struct printbuf *pb,
                                              int level,
@@ -881,7 +1526,9 @@ static int json_object_extarr_to_json_string(struct json_object* jso,
 {
         int do_vals = !(flags & JSON_C_TO_STRING_NO_EXTARR_VALS);
 	int had_children = 0;
-	int ii;
+	int ii, nvals = json_object_extarr_nvals(jso);
+	enum json_extarr_type etype = json_object_extarr_type(jso);
+	void const *data = json_object_extarr_data(jso);
         if (do_vals)
 	    sprintbuf(pb, "( %d, %d, ",
                 (int) json_object_extarr_type(jso), json_object_extarr_ndims(jso));
@@ -896,63 +1543,45 @@ static int json_object_extarr_to_json_string(struct json_object* jso,
 	    sprintbuf(pb, "%d", json_object_extarr_dim(jso, ii));
 	if (flags & JSON_C_TO_STRING_PRETTY)
 		sprintbuf(pb, "\n");
-	for(ii=0; ii < json_object_extarr_nvals(jso) && do_vals; ii++)
+	for(ii=0; ii < nvals && do_vals; ii++)
 	{
-		struct json_object *val = 0;
+		/* separator, indentation and value are formatted here and appended at once */
+		char buf[64];
+		int n = 0;
 		if (had_children)
 		{
-			sprintbuf(pb, ",");
+			buf[n++] = ',';
 			if (flags & JSON_C_TO_STRING_PRETTY)
-				sprintbuf(pb, "\n");
+				buf[n++] = '\n';
 		}
 		had_children = 1;
 		if (flags & JSON_C_TO_STRING_SPACED)
-			sprintbuf(pb, " ");
+			buf[n++] = ' ';
+		printbuf_memappend_fast(pb, buf, n);
 		indent(pb, level + 1, flags);
-                switch (json_object_extarr_type(jso))
-                {
-                  case json_extarr_type_null:
-                  case json_extarr_type_bit01:
-                  {
-                    val = NULL;
-                    break;
-                  }
-                  case json_extarr_type_byt08:
-                  {
-                    unsigned char dval = *((unsigned char*)json_object_extarr_data(jso)+ii);
-                    val = json_object_new_int(dval);
-                    break;
-                  }
-                  case json_extarr_type_int32:
-                  {
-                    int dval = *((int*)json_object_extarr_data(jso)+ii);
-                    val = json_object_new_int(dval);
-                    break;
-                  }
-                  case json_extarr_type_int64:
-                  {
-                    int64_t dval = *((int64_t*)json_object_extarr_data(jso)+ii);
-                    val = json_object_new_int64(dval);
-                    break;
-                  }
-                  case json_extarr_type_flt32:
-                  {
-                    float dval = *((float*)json_object_extarr_data(jso)+ii);
-                    val = json_object_new_double(dval);
-                    break;
-                  }
-                  case json_extarr_type_flt64:
-                  {
-                    double dval = *((double*)json_object_extarr_data(jso)+ii);
-                    val = json_object_new_double(dval);
-                    break;
-                  }
-                }
-		if(val == NULL)
-			sprintbuf(pb, "null");
-		else
-			val->_to_json_string(val, pb, level+1, flags);
-                json_object_put(val);
+		switch (etype)
+		{
+		  case json_extarr_type_byt08:
+		    n = json_u64toa(((unsigned char const*)data)[ii], buf);
+		    break;
+		  case json_extarr_type_int32:
+		    n = json_i64toa(((int const*)data)[ii], buf);
+		    break;
+		  case json_extarr_type_int64:
+		    n = json_i64toa(((int64_t const*)data)[ii], buf);
+		    break;
+		  case json_extarr_type_flt32:
+		    n = json_dtoa(((float const*)data)[ii], buf);
+		    break;
+		  case json_extarr_type_flt64:
+		    n = json_dtoa(((double const*)data)[ii], buf);
+		    break;
+		  default:
+		    memcpy(buf, "null", 4);
+		    n = 4;
+		    break;
+		}
+		printbuf_memappend_fast(pb, buf, n);
 	}
 	if (flags & JSON_C_TO_STRING_PRETTY)
 	{
@@ -977,12 +1606,30 @@ static int json_object_extarr_to_json_string(struct json_object* jso,
         }
 }
 
+/* Releases an extarr's buffer unless the caller kept ownership of it. A
+   mapped buffer starts (offset % page size) bytes into its mapping. */
+static void json_object_extarr_free_data(struct json_object* jso)
+{
+  char *data = (char*) jso->o.c_extarr.data;
+  if (!data || (jso->o.c_extarr.flags & JSON_C_EXTARR_DONT_FREE))
+      return;
+#ifdef JSON_C_HAVE_MMAP
+  if (jso->o.c_extarr.flags & JSON_C_EXTARR_MMAP)
+  {
+      size_t delta = (size_t) data % (size_t) sysconf(_SC_PAGESIZE);
+      munmap(data - delta, (size_t) json_object_extarr_nbytes(jso) + delta);
+  }
+  else
+#endif
+      free(data);
+  jso->o.c_extarr.data = NULL;
+}
+
 static void json_object_extarr_delete(struct json_object* jso)
 {
   assert(jso && json_object_is_type(jso, json_type_extarr));
+  json_object_extarr_free_data(jso);
   array_list_free(jso->o.c_extarr.dims);
-  if (!(jso->o.c_extarr.flags & JSON_C_EXTARR_DONT_FREE))
-      free((void*)jso->o.c_extarr.data);
   json_object_generic_delete(jso);
 }
 
@@ -1103,7 +1750,8 @@ json_object_new_extarr(
   jso->o.c_extarr.data = data;
   jso->o.c_extarr.flags = flags;
   jso->o.c_extarr.type = type;
-  jso->o.c_extarr.dims = array_list_new(&json_object_array_entry_free);
+  jso->o.c_extarr.dims = array_list_new_arena(jso->_arena, &json_object_array_entry_free);
+  json_arena_track(jso);
   for (i = 0; i < ndims; i++)
     array_list_put_idx(jso->o.c_extarr.dims, i, json_object_new_int(dims[i])); 
   return jso;
@@ -1132,7 +1780,8 @@ json_object_new_extarr_alloc(
   jso->_to_json_string = &json_object_extarr_to_json_string;
   jso->o.c_extarr.flags = flags;
   jso->o.c_extarr.type = etype;
-  jso->o.c_extarr.dims = array_list_new(&json_object_array_entry_free);
+  jso->o.c_extarr.dims = array_list_new_arena(jso->_arena, &json_object_array_entry_free);
+  json_arena_track(jso);
   for (i = 0, nvals = 1; i < ndims; i++)
   {
     array_list_put_idx(jso->o.c_extarr.dims, i, json_object_new_int(dims[i])); 
@@ -1147,6 +1796,91 @@ json_object_new_extarr_alloc(
   return jso;
 }
 
+/** Create new external array object mapping a region of an open file
+ *
+ * The region of \c fd starting at byte \c offset and holding the array's
+ * values is mapped read-only with mmap() rather than read into memory so
+ * that loading a large array costs no copy and pages are brought in from
+ * the page cache only as they are touched. The buffer is never written.
+ * The mapping does not depend on \c fd remaining open.
+ *
+ * The extarr object owns the mapping and unmaps it when it is deleted
+ * with json_object_put(), unless JSON_C_EXTARR_DONT_FREE is passed in
+ * \c flags, in which case the caller must munmap() it, starting from
+ * json_object_extarr_data() rounded down to a page boundary.
+ *
+ * Returns NULL if the region could not be mapped or on systems without
+ * mmap().
+ */
+struct json_object*
+json_object_new_extarr_mmap_fd(
+    int fd,                      /**< [in] File descriptor of a file open for reading */
+    int64_t offset,              /**< [in] Offset in bytes of the array's first value in the file */
+    enum json_extarr_type etype, /**< [in] The type of data in the array */
+    int ndims,                   /**< [in] The number of dimensions in the array */
+    int const *dims,             /**< [in] Array of length \c ndims of integer values holding the size
+                                      in each dimension */
+    unsigned flags               /**< [in] Flags controlling behavior. */
+)
+{
+#ifdef JSON_C_HAVE_MMAP
+  struct json_object *jso;
+  int64_t nbytes, delta;
+  void *base;
+
+  if (fd < 0 || offset < 0) return NULL;
+  jso = json_object_new_extarr(NULL, etype, ndims, dims, flags | JSON_C_EXTARR_MMAP);
+  if (!jso) return NULL;
+  nbytes = json_object_extarr_nbytes(jso);
+  if (nbytes <= 0) return jso;
+  delta = offset % sysconf(_SC_PAGESIZE);
+  base = mmap(NULL, (size_t) (nbytes + delta), PROT_READ, MAP_PRIVATE,
+              fd, (off_t) (offset - delta));
+  if (base == MAP_FAILED)
+  {
+    json_object_put(jso);
+    return NULL;
+  }
+  jso->o.c_extarr.data = (char*) base + delta;
+  return jso;
+#else
+  return NULL;
+#endif
+}
+
+/** Create new external array object mapping a region of a file
+ *
+ * Opens \c path, maps the region as json_object_new_extarr_mmap_fd() does
+ * and closes it again.
+ */
+struct json_object*
+json_object_new_extarr_mmap(
+    char const *path,            /**< [in] Name of the file holding the array */
+    int64_t offset,              /**< [in] Offset in bytes of the array's first value in the file */
+    enum json_extarr_type etype, /**< [in] The type of data in the array */
+    int ndims,                   /**< [in] The number of dimensions in the array */
+    int const *dims,             /**< [in] Array of length \c ndims of integer values holding the size
+                                      in each dimension */
+    unsigned flags               /**< [in] Flags controlling behavior. */
+)
+{
+#ifdef JSON_C_HAVE_MMAP
+  struct json_object *jso;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    MC_ERROR("json_object_new_extarr_mmap: error opening file %s: %s\n",
+             path, strerror(errno));
+    return NULL;
+  }
+  jso = json_object_new_extarr_mmap_fd(fd, offset, etype, ndims, dims, flags);
+  close(fd);
+  return jso;
+#else
+  return NULL;
+#endif
+}
+
 enum json_extarr_type json_object_extarr_type(struct json_object* jso)
 {
     if (!jso || !json_object_is_type(jso, json_type_extarr)) return json_extarr_type_null;
@@ -1320,8 +2054,9 @@ struct json_object* json_object_new_enum(void)
   if(!jso) return NULL;
   jso->_delete = &json_object_enum_delete;
   jso->_to_json_string = &json_object_enum_to_json_string;
-  jso->o.c_enum.choices = lh_kchar_table_new(JSON_OBJECT_DEF_HASH_ENTRIES,
-                                        NULL, &json_object_lh_entry_free);
+  jso->o.c_enum.choices = lh_table_new_arena(jso->_arena, JSON_OBJECT_DEF_HASH_ENTRIES, NULL,
+                                        jso->_arena ? &json_object_lh_arena_entry_free : &json_object_lh_entry_free,
+                                        lh_char_hash, lh_char_equal);
   jso->o.c_enum.choice = 0;
   return jso;
 }
@@ -1348,6 +2083,7 @@ json_object_enum_add(
 
   if (selected)
       jso->o.c_enum.choice = val;
+  json_object_nbytes_changed(jso);
   /* We lookup the entry and replace the value, rather than just deleting
      and re-adding it, so the existing key remains valid.  */
   json_object *existing_value = NULL;
@@ -1355,7 +2091,8 @@ json_object_enum_add(
   existing_entry = lh_table_lookup_entry(jso->o.c_enum.choices, (void*)name);
   if (!existing_entry)
   {
-    lh_table_insert(jso->o.c_enum.choices, strdup(name), json_object_new_int(val));
+    lh_table_insert(jso->o.c_enum.choices, json_arena_strndup(jso->_arena, name, strlen(name)),
+        json_object_new_int(val));
     return;
   }
   existing_value = (json_object *)existing_entry->v;
@@ -1624,9 +2361,10 @@ json_bool json_object_set_double(struct json_object *double_obj, double val)
 json_bool json_object_set_string(struct json_object *string_obj, char const *val)
 {
     if (!string_obj || !json_object_is_type(string_obj, json_type_string)) return JSON_C_FALSE;
-    if (string_obj->o.c_string.str) free(string_obj->o.c_string.str);
-    string_obj->o.c_string.str = strdup(val);
+    if (string_obj->o.c_string.str) json_arena_release(string_obj->_arena, string_obj->o.c_string.str);
     string_obj->o.c_string.len = strlen(val);
+    string_obj->o.c_string.str = json_arena_strndup(string_obj->_arena, val, string_obj->o.c_string.len);
+    json_object_nbytes_changed(string_obj);
     return JSON_C_TRUE;
 }
 /**@} Set Primitive Object Value */
@@ -1716,14 +2454,9 @@ static struct json_object* json_object_apath_get_leafobj(struct json_object *obj
  @{
  */
 
-/**
- * \brief Query boolean value at specified path
- *
- * For return and type corecion, see json_object_path_get_boolean().
- */
-json_bool json_object_apath_get_boolean(struct json_object *obj, char const *key_path)
+/* Coercions of a leaf object shared by the apath and compiled path queries */
+static json_bool json_object_leaf_get_boolean(struct json_object *leafobj)
 {
-    struct json_object *leafobj = json_object_apath_get_leafobj(obj, key_path);
     if (leafobj)
     {
         switch (json_object_get_type(leafobj))
@@ -1754,13 +2487,17 @@ json_bool json_object_apath_get_boolean(struct json_object *obj, char const *key
 }
 
 /**
- * \brief Query int64_t value at specified path
+ * \brief Query boolean value at specified path
  *
- * For return and type corecion, see json_object_path_get_int64().
+ * For return and type corecion, see json_object_path_get_boolean().
  */
-int64_t json_object_apath_get_int64(struct json_object *obj, char const *key_path)
+json_bool json_object_apath_get_boolean(struct json_object *obj, char const *key_path)
+{
+    return json_object_leaf_get_boolean(json_object_apath_get_leafobj(obj, key_path));
+}
+
+static int64_t json_object_leaf_get_int64(struct json_object *leafobj)
 {
-    struct json_object *leafobj = json_object_apath_get_leafobj(obj, key_path);
     if (leafobj)
     {
         switch (json_object_get_type(leafobj))
@@ -1783,6 +2520,7 @@ int64_t json_object_apath_get_int64(struct json_object *obj, char const *key_pat
                     if (errno == 0 && ep != str)
                         return (int64_t) val;
                 }
+                return 0;
             }
             case json_type_extarr:
             {
@@ -1796,6 +2534,16 @@ int64_t json_object_apath_get_int64(struct json_object *obj, char const *key_pat
     return 0;
 }
 
+/**
+ * \brief Query int64_t value at specified path
+ *
+ * For return and type corecion, see json_object_path_get_int64().
+ */
+int64_t json_object_apath_get_int64(struct json_object *obj, char const *key_path)
+{
+    return json_object_leaf_get_int64(json_object_apath_get_leafobj(obj, key_path));
+}
+
 /**
  * \brief Query int value at specified path
  *
@@ -1810,14 +2558,8 @@ int json_object_apath_get_int(struct json_object *obj, char const *key_path)
         return 0;
 }
 
-/**
- * \brief Query double value at specified path
- *
- * For return and type corecion, see json_object_path_get_double().
- */
-double json_object_apath_get_double(struct json_object *obj, char const *key_path)
+static double json_object_leaf_get_double(struct json_object *leafobj)
 {
-    struct json_object *leafobj = json_object_apath_get_leafobj(obj, key_path);
     if (leafobj)
     {
         switch (json_object_get_type(leafobj))
@@ -1840,6 +2582,7 @@ double json_object_apath_get_double(struct json_object *obj, char const *key_pat
                     if (errno == 0 && ep != str)
                         return val;
                 }
+                return 0.0;
             }
             case json_type_extarr:
             {
@@ -1853,6 +2596,16 @@ double json_object_apath_get_double(struct json_object *obj, char const *key_pat
     return 0.0;
 }
 
+/**
+ * \brief Query double value at specified path
+ *
+ * For return and type corecion, see json_object_path_get_double().
+ */
+double json_object_apath_get_double(struct json_object *obj, char const *key_path)
+{
+    return json_object_leaf_get_double(json_object_apath_get_leafobj(obj, key_path));
+}
+
 #define CIRCBUF_SIZE 1024 
 #define CIRCBUF_CLEAR "__json_c_clear_circbuf__"
 static char const *circbuf_return(char const *str)
@@ -2024,6 +2777,183 @@ char const *json_paste_apath(
 }
 /**@} Alternative Path Queries */
 
+/**
+ * \addtogroup compiledpaths Compiled Path Queries
+ * \brief Repeated JSON object hierarchy path queries
+ *
+ * The path and apath query methods copy and re-tokenize their key path on every
+ * call. For queries made repeatedly, for example for each mesh part or each variable,
+ * the key path can instead be compiled once with json_path_compile(). Each component
+ * of a compiled path holds its key, the key's hash and, when the component consists
+ * entirely of digits, its value as an array index. A query then simply walks one
+ * pointer per component without allocating any memory.
+ *
+ * Compiled paths follow the apath conventions for intermediate arrays and, for the
+ * value methods, the apath type coercions. A compiled path is never modified by a
+ * query and so it may be shared by many threads. Likewise, queries do not modify the
+ * object hierarchy except that json_path_get_string() on a leaf that is not a string
+ * serializes it to the leaf's own printbuf.
+ @{
+ */
+
+struct json_path_comp {
+    char *key;
+    unsigned long hash;
+    int idx;               /* array index or -1 */
+};
+
+struct json_path {
+    int ncomps;
+    struct json_path_comp comps[1];
+};
+
+/**
+ * \brief Compile a key path for repeated queries
+ *
+ * Leading, trailing and repeated slashes are ignored.
+ *
+ * \return The compiled path to be freed with json_path_free() or null if out of memory.
+ */
+struct json_path *json_path_compile(char const *key_path)
+{
+    struct json_path *path;
+    char const *p;
+    char *keys;
+    int n = 0, len = (int) strlen(key_path);
+
+    for (p = key_path; *p; p++)
+        if (*p != '/' && (p == key_path || p[-1] == '/')) n++;
+
+    /* one allocation holds the components and all their keys */
+    path = (struct json_path *) malloc(sizeof(struct json_path) +
+        n * sizeof(struct json_path_comp) + len + 1);
+    if (!path) return 0;
+    keys = (char *) &path->comps[n > 0 ? n : 1];
+    memcpy(keys, key_path, len + 1);
+
+    path->ncomps = 0;
+    while (*keys)
+    {
+        struct json_path_comp *comp;
+        char *d;
+
+        if (*keys == '/') { keys++; continue; }
+
+        comp = &path->comps[path->ncomps++];
+        comp->key = keys;
+        while (*keys && *keys != '/') keys++;
+        for (d = comp->key; '0' <= *d && *d <= '9'; d++) ;
+        comp->idx = (d == keys && d - comp->key < 10) ? atoi(comp->key) : -1;
+        if (*keys) *keys++ = '\0';
+        comp->hash = lh_char_hash(comp->key);
+    }
+
+    return path;
+}
+
+void json_path_free(struct json_path *path)
+{
+    free(path);
+}
+
+/**
+ * \brief Query any object at a compiled path
+ *
+ * \return The object or null if there is none at the path.
+ */
+struct json_object *json_path_get_object(struct json_object *src, struct json_path const *path)
+{
+    int i;
+
+    for (i = 0; src && i < path->ncomps; i++)
+    {
+        struct json_path_comp const *comp = &path->comps[i];
+
+        if (src->o_type == json_type_array && 0 <= comp->idx &&
+            comp->idx < array_list_length(src->o.c_array))
+        {
+            src = (struct json_object *) array_list_get_idx(src->o.c_array, comp->idx);
+        }
+        else if (src->o_type == json_type_object)
+        {
+            struct lh_entry *e = lh_table_lookup_entry_w_hash(src->o.c_object, comp->key, comp->hash);
+            src = e ? (struct json_object *) e->v : 0;
+        }
+        else
+        {
+            src = 0;
+        }
+    }
+
+    return src;
+}
+
+/**
+ * \brief Query boolean value at a compiled path
+ *
+ * For return and type corecion, see json_object_path_get_boolean().
+ */
+json_bool json_path_get_boolean(struct json_object *src, struct json_path const *path)
+{
+    return json_object_leaf_get_boolean(json_path_get_object(src, path));
+}
+
+/**
+ * \brief Query int64_t value at a compiled path
+ *
+ * For return and type corecion, see json_object_path_get_int64().
+ */
+int64_t json_path_get_int64(struct json_object *src, struct json_path const *path)
+{
+    return json_object_leaf_get_int64(json_path_get_object(src, path));
+}
+
+/**
+ * \brief Query int value at a compiled path
+ *
+ * For return and type corecion, see json_object_path_get_int().
+ */
+int json_path_get_int(struct json_object *src, struct json_path const *path)
+{
+    int64_t val64 = json_path_get_int64(src, path);
+    if (INT_MIN <= val64 && val64 <= INT_MAX)
+        return (int) val64;
+    else
+        return 0;
+}
+
+/**
+ * \brief Query double value at a compiled path
+ *
+ * For return and type corecion, see json_object_path_get_double().
+ */
+double json_path_get_double(struct json_object *src, struct json_path const *path)
+{
+    return json_object_leaf_get_double(json_path_get_object(src, path));
+}
+
+/**
+ * \brief Query string value at a compiled path
+ *
+ * Unlike json_object_apath_get_string(), the returned string is not copied to a cache.
+ * For a string leaf, it is the string held by the leaf itself, unescaped. For any other
+ * leaf, it is the leaf serialized to the leaf's printbuf. Either way, it remains valid
+ * until the leaf is modified or freed.
+ *
+ * \return The string or \c "null" if there is no object at the path.
+ */
+char const *json_path_get_string(struct json_object *src, struct json_path const *path)
+{
+    struct json_object *leafobj = json_path_get_object(src, path);
+
+    if (!leafobj)
+        return "null";
+    if (leafobj->o_type == json_type_string)
+        return leafobj->o.c_string.str;
+    return json_object_to_json_string_ext(leafobj, JSON_C_TO_STRING_UNQUOTED);
+}
+/**@} Compiled Path Queries */
+
 static void *json_object_path_get_leafobj_recurse(struct json_object *src, char *key_path, json_type jtype)
 {
 #warning we need to support . and .. notation here too
@@ -2341,12 +3271,11 @@ void json_object_free_printbuf(struct json_object* jso)
 }
 /**@} Serialization */
 
-int64_t json_object_object_nbytes(struct json_object* obj, json_bool mode)
+static int64_t json_object_nbytes_walk(struct json_object* obj, json_bool mode)
 {
     static int const objhdr = (int) sizeof(struct json_object);
     int addhdr = mode ? objhdr : 0;
 
-    if (!obj) return 0;
     switch (json_object_get_type(obj))
     {
         case json_type_null:    return 0 + addhdr;
@@ -2389,4 +3318,48 @@ int64_t json_object_object_nbytes(struct json_object* obj, json_bool mode)
     return 0;
 }
 
+/**
+ * \brief Bytes held by an object and its members
+ *
+ * With \c mode false, only the bytes of primitive values, strings and extarr
+ * data are counted. Otherwise, the object headers, keys, extarr headers and
+ * enum choices are counted too.
+ *
+ * Sizes of objects and arrays are cached so repeating the call for a
+ * hierarchy is O(1) until one of its members is added, removed or changes size.
+ * Replacing the members of an object's lh_table directly is not noticed.
+ */
+int64_t json_object_object_nbytes(struct json_object* obj, json_bool mode)
+{
+    int m = mode ? 1 : 0;
+    int64_t retval;
+
+    if (!obj) return 0;
+    if (obj->o_type != json_type_object && obj->o_type != json_type_array)
+        return json_object_nbytes_walk(obj, mode);
+
+    if (obj->_nbytes_gen == json_nbytes_gen && obj->_nbytes[m] >= 0)
+        return obj->_nbytes[m];
+    retval = json_object_nbytes_walk(obj, mode);
+    if (obj->_nbytes_gen != json_nbytes_gen)
+    {
+        obj->_nbytes_gen = json_nbytes_gen;
+        obj->_nbytes[1-m] = -1;
+    }
+    obj->_nbytes[m] = retval;
+    return retval;
+}
+
+/** \brief Bytes of the data held by an object, json_object_object_nbytes() in false mode */
+int64_t json_object_payload_nbytes(struct json_object* obj)
+{
+    return json_object_object_nbytes(obj, JSON_C_FALSE);
+}
+
+/** \brief Bytes of object headers, keys and the like beyond json_object_payload_nbytes() */
+int64_t json_object_overhead_nbytes(struct json_object* obj)
+{
+    return json_object_object_nbytes(obj, JSON_C_TRUE) - json_object_object_nbytes(obj, JSON_C_FALSE);
+}
+
 /**@} JSON-C Library */
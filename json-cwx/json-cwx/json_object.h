@@ -21,6 +21,7 @@
 #define THIS_FUNCTION_IS_DEPRECATED(func) func
 #endif
 
+#include <stddef.h>
 #include "json_inttypes.h"
 
 #ifdef __cplusplus
@@ -61,6 +62,11 @@ extern "C" {
 
 #define JSON_C_TO_STRING_NO_EXTARR_VALS (1<<4)
 
+/**
+ * Approximate size of the chunks json_object_to_json_sink() hands to its sink
+ */
+#define JSON_C_SINK_CHUNK (1<<16)
+
 #define JSON_C_FALSE ((json_bool)0)
 #define JSON_C_TRUE ((json_bool)1)
 
@@ -100,6 +106,13 @@ typedef int (json_object_to_json_string_fn)(struct json_object *jso,
 						struct printbuf *pb,
 						int level,
 						int flags);
+
+/**
+ * Type of a sink function receiving serialized output from
+ * json_object_to_json_sink.  Returns 0 on success; any other value
+ * aborts the serialization.
+ */
+typedef int (json_object_sink_fn)(void *data, const char *buf, size_t len);
 /**@} Object Customization */
 
 /* supported object types */
@@ -128,6 +141,7 @@ typedef enum json_extarr_type {
 } json_extarr_type;
 
 #define JSON_C_EXTARR_DONT_FREE 0x00000001
+#define JSON_C_EXTARR_MMAP      0x00000002 /**< buffer is a read-only file mapping, unmapped rather than freed */
 
 /** \addtogroup refcount Reference Counting
   @{ */
@@ -151,6 +165,61 @@ extern struct json_object* json_object_get(struct json_object *obj);
 int json_object_put(struct json_object *obj);
 /**@} Reference Counting */
 
+/** \addtogroup arena Arena Allocation
+ *
+ * Building a large, short-lived hierarchy object by object means many tiny
+ * heap allocations for the objects, their keys, strings and container storage
+ * and tearing it down with json_object_put() costs as much again. While an
+ * arena is in use by a thread, all of that memory for objects the thread
+ * creates is instead bump-allocated from large blocks owned by the arena and
+ * json_arena_free() releases it all at once without visiting any object.
+ *
+ * json_object_put() still counts references to arena objects but never frees
+ * them. Containers created in an arena should hold only objects from the same
+ * arena or objects the caller keeps references to and releases itself. An
+ * arena object must not be used after its arena is freed. An arena may be
+ * used by only one thread at a time.
+  @{ */
+
+/** Default size of the blocks an arena allocates from the C heap */
+#define JSON_C_ARENA_BLOCK (1<<16)
+
+struct json_arena;
+
+/**
+ * Create a new, empty arena
+ *
+ * @param block_size size of the blocks memory is carved from or 0 for
+ * JSON_C_ARENA_BLOCK. Larger requests get a block of their own.
+ * @returns the arena or NULL if out of memory
+ */
+extern struct json_arena* json_arena_new(size_t block_size);
+
+/**
+ * Allocate objects the calling thread creates from now on from arena
+ *
+ * @param arena the arena to use or NULL to return to the C heap
+ * @returns the arena previously in use, to be restored by the caller
+ */
+extern struct json_arena* json_arena_use(struct json_arena *arena);
+
+/**
+ * Get the arena in use by the calling thread or NULL if there is none
+ */
+extern struct json_arena* json_arena_current(void);
+
+/**
+ * Free an arena and everything allocated from it
+ *
+ * Any printbuf strings, user data of custom serializers and extarr buffers
+ * the arena's objects own are also freed.
+ *
+ * @param arena the arena to free. If in use by the calling thread, the
+ * thread returns to the C heap.
+ */
+extern void json_arena_free(struct json_arena *arena);
+/**@} Arena Allocation */
+
 /** \addtogroup objquery Object Introspection and Query
   @{ */
 
@@ -202,6 +271,21 @@ extern const char* json_object_to_json_string(struct json_object *obj);
  */
 extern const char* json_object_to_json_string_ext(struct json_object *obj, int
 flags);
+
+/** Stream object in json format to a sink
+ *
+ * Unlike json_object_to_json_string_ext(), the whole string is never held
+ * in memory. Output is handed to sink in chunks of roughly
+ * JSON_C_SINK_CHUNK bytes as it is produced.
+ *
+ * @param obj the json_object instance
+ * @param flags formatting options, see JSON_C_TO_STRING_PRETTY and other constants
+ * @param sink function receiving each chunk of output
+ * @param data passed through to sink
+ * @returns 0 on success, -1 on failure or the first non-zero value returned by sink
+ */
+extern int json_object_to_json_sink(struct json_object *obj, int flags,
+                                    json_object_sink_fn *sink, void *data);
 /**@} Serialization */
 
 /**
@@ -676,6 +760,10 @@ extern struct json_object*   json_object_new_extarr(void const *data, enum json_
                                  int ndims, int const *dims, unsigned flags);
 extern struct json_object*   json_object_new_extarr_alloc(enum json_extarr_type etype,
                                  int ndims, int const *dims, unsigned flags);
+extern struct json_object*   json_object_new_extarr_mmap(char const *path, int64_t offset,
+                                 enum json_extarr_type etype, int ndims, int const *dims, unsigned flags);
+extern struct json_object*   json_object_new_extarr_mmap_fd(int fd, int64_t offset,
+                                 enum json_extarr_type etype, int ndims, int const *dims, unsigned flags);
 extern enum json_extarr_type json_object_extarr_type(struct json_object* jso);
 extern int64_t               json_object_extarr_crc(struct json_object* jso);
 extern int                   json_object_extarr_nvals(struct json_object* jso);
@@ -711,6 +799,16 @@ extern struct json_object * json_object_apath_get_object(struct json_object *src
 extern struct json_object * json_object_apath_find_object(struct json_object *src, char const *key_path);
 extern char const *         json_paste_apath(char const *va_args_str, char const *first, ...);
 
+struct json_path;
+extern struct json_path *   json_path_compile(char const *key_path);
+extern void                 json_path_free(struct json_path *path);
+extern struct json_object * json_path_get_object(struct json_object *src, struct json_path const *path);
+extern json_bool            json_path_get_boolean(struct json_object *src, struct json_path const *path);
+extern int                  json_path_get_int(struct json_object *src, struct json_path const *path);
+extern int64_t              json_path_get_int64(struct json_object *src, struct json_path const *path);
+extern double               json_path_get_double(struct json_object *src, struct json_path const *path);
+extern char const *         json_path_get_string(struct json_object *src, struct json_path const *path);
+
 /** \addtogroup jsonclib JSON-CWX Library
   @{ */
 
@@ -795,6 +893,8 @@ extern json_bool json_object_path_set_double(struct json_object *obj, char const
 extern json_bool json_object_path_set_string(struct json_object *obj, char const *key_path, char const *val);
 
 extern int64_t json_object_object_nbytes(struct json_object *const obj, json_bool mode);
+extern int64_t json_object_payload_nbytes(struct json_object *obj);
+extern int64_t json_object_overhead_nbytes(struct json_object *obj);
 
 /**@} JSON-CWX Library */
 
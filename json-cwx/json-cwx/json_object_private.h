@@ -39,8 +39,23 @@ struct json_object
   } o;
   json_object_delete_fn *_user_delete;
   void *_userdata;
+  struct json_arena *_arena;
+  /* containing object, valid only while _nparents is 1. 2 means 2 or more. */
+  struct json_object *_parent;
+  int _nparents;
+  /* json_object_object_nbytes() of an object or array by mode, -1 if not
+     known or if _nbytes_gen is not the current generation */
+  unsigned _nbytes_gen;
+  int64_t _nbytes[2];
 };
 
+/* Allocation from an arena or, when arena is NULL, the C heap. Memory
+   obtained from an arena is only returned by json_arena_free(). */
+extern void* json_arena_calloc(struct json_arena *arena, size_t nmemb, size_t size);
+extern void* json_arena_realloc(struct json_arena *arena, void *ptr, size_t old_size, size_t size);
+extern char* json_arena_strndup(struct json_arena *arena, const char *s, size_t len);
+extern void  json_arena_release(struct json_arena *arena, void *ptr);
+
 #ifdef __cplusplus
 }
 #endif
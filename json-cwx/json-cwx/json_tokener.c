@@ -270,11 +270,331 @@ static void put_extarr_val(struct json_object* cur, struct json_object* o, int e
   json_object_put(o);
 }
 
+/* Store a parsed number into an extarr with the same conversions
+   put_extarr_val applies to an int or double json_object */
+static void store_extarr_num(enum json_extarr_type etype, void *data, int idx,
+                             int is_double, int64_t ival, double dval)
+{
+  int32_t ival32 = 0;
+
+  if (etype == json_extarr_type_byt08 || etype == json_extarr_type_int32)
+  {
+    if (is_double)
+      ival32 = (int32_t) dval;
+    else if (ival <= INT32_MIN)
+      ival32 = INT32_MIN;
+    else if (ival >= INT32_MAX)
+      ival32 = INT32_MAX;
+    else
+      ival32 = (int32_t) ival;
+  }
+
+  switch (etype)
+  {
+    case json_extarr_type_null:
+    case json_extarr_type_bit01:
+      break;
+    case json_extarr_type_byt08:
+      ((unsigned char*)data)[idx] = (unsigned char) ival32;
+      break;
+    case json_extarr_type_int32:
+      ((int*)data)[idx] = ival32;
+      break;
+    case json_extarr_type_int64:
+      ((int64_t*)data)[idx] = is_double ? (int64_t) dval : ival;
+      break;
+    case json_extarr_type_flt32:
+      ((float*)data)[idx] = (float) (is_double ? dval : (double) ival);
+      break;
+    case json_extarr_type_flt64:
+      ((double*)data)[idx] = is_double ? dval : (double) ival;
+      break;
+  }
+}
+
+/* Exactly representable powers of ten */
+static const double extarr_pow10[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#if defined(__SIZEOF_INT128__)
+
+#define JSON_ATOD_MIN_POW10 (-342)
+#define JSON_ATOD_MAX_POW10 308
+
+typedef unsigned __int128 json_uint128_t;
+
+/* 5^q for q in [MIN_POW10, MAX_POW10], normalized so the top bit of the
+   128 bit value is set. Negative q hold floor(2^b / 5^-q) + 1 truncated. */
+static uint64_t json_atod_pow5[JSON_ATOD_MAX_POW10 - JSON_ATOD_MIN_POW10 + 1][2];
+
+/* Top 128 bits of a little-endian bignum of nlimbs 32 bit limbs */
+static void json_atod_big_top128(uint32_t const *big, int nlimbs, uint64_t *out)
+{
+  uint32_t w[4];
+  int i, top = 32 * nlimbs - 1;
+
+  while (!(big[top / 32] >> (top % 32) & 1)) top--;
+  for (i = 0; i < 4; i++)
+  {
+    /* bit of big landing on bit 32*i of the result */
+    int pos = top - 127 + 32 * i;
+    int limb = pos >= 0 ? pos / 32 : -((-pos + 31) / 32);
+    int off = pos - 32 * limb;
+    uint64_t lo = (limb >= 0 && limb < nlimbs) ? big[limb] : 0;
+    uint64_t hi = (limb+1 >= 0 && limb+1 < nlimbs) ? big[limb+1] : 0;
+    w[i] = (uint32_t) (((hi << 32) | lo) >> off);
+  }
+  out[1] = ((uint64_t) w[3] << 32) | w[2];
+  out[0] = ((uint64_t) w[1] << 32) | w[0];
+}
+
+/* Computes the table Eisel-Lemire uses. This runs when the library is loaded, before any
+   thread can parse a double, so readers need no synchronization. */
+static void json_atod_init_table(void) __attribute__ ((constructor));
+static void json_atod_init_table(void)
+{
+  uint32_t big[60];
+  int q, j, nlimbs;
+
+  /* 5^q */
+  memset(big, 0, sizeof(big));
+  big[0] = 1;
+  nlimbs = 1;
+  for (q = 0; q <= JSON_ATOD_MAX_POW10; q++)
+  {
+    uint64_t carry = 0;
+    json_atod_big_top128(big, nlimbs, json_atod_pow5[q - JSON_ATOD_MIN_POW10]);
+    for (j = 0; j < nlimbs; j++)
+    {
+      uint64_t t = (uint64_t) big[j] * 5 + carry;
+      big[j] = (uint32_t) t;
+      carry = t >> 32;
+    }
+    if (carry) big[nlimbs++] = (uint32_t) carry;
+  }
+
+  /* floor(2^b / 5^p) + 1 with b large enough to leave at least 128 bits */
+  for (q = -1; q >= JSON_ATOD_MIN_POW10; q--)
+  {
+    int p = -q, z = (int) (((uint32_t) p * 1217359) >> 19) + 1; /* ceil(log2(5^p)) */
+    int b = q >= -27 ? z + 127 : 2 * z + 128;
+    memset(big, 0, sizeof(big));
+    nlimbs = b / 32 + 1;
+    big[b / 32] = (uint32_t) 1 << (b % 32);
+    for (j = 0; j < p; j++)
+    {
+      uint64_t rem = 0;
+      int l;
+      for (l = nlimbs-1; l >= 0; l--)
+      {
+        uint64_t t = (rem << 32) | big[l];
+        big[l] = (uint32_t) (t / 5);
+        rem = t % 5;
+      }
+    }
+    for (j = 0; j < nlimbs && ++big[j] == 0; j++) ;
+    json_atod_big_top128(big, nlimbs, json_atod_pow5[q - JSON_ATOD_MIN_POW10]);
+  }
+}
+
+/*
+ * Correctly rounded double nearest w * 10^q for an exact decimal significand
+ * w (Eisel-Lemire as in Lemire's fast_float, which needs no fallback once
+ * both halves of the power are used).
+ */
+static double json_atod_eisel_lemire(uint64_t w, int q)
+{
+  json_uint128_t prod;
+  uint64_t hi, lo, mantissa, bits;
+  int lz, upperbit, shift, power2;
+  double d;
+
+  if (w == 0 || q < JSON_ATOD_MIN_POW10) return 0.0;
+  if (q > JSON_ATOD_MAX_POW10) return HUGE_VAL;
+
+  lz = __builtin_clzll(w);
+  w <<= lz;
+  prod = (json_uint128_t) w * json_atod_pow5[q - JSON_ATOD_MIN_POW10][1];
+  hi = (uint64_t) (prod >> 64);
+  lo = (uint64_t) prod;
+  if ((hi & 0x1FF) == 0x1FF)
+  {
+    uint64_t second_hi = (uint64_t) (((json_uint128_t) w * json_atod_pow5[q - JSON_ATOD_MIN_POW10][0]) >> 64);
+    lo += second_hi;
+    if (second_hi > lo) hi++;
+  }
+
+  upperbit = (int) (hi >> 63);
+  shift = upperbit + 64 - 52 - 3;
+  mantissa = hi >> shift;
+  power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+
+  if (power2 <= 0) /* subnormal */
+  {
+    if (-power2 + 1 >= 64) return 0.0;
+    mantissa >>= -power2 + 1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    power2 = mantissa < ((uint64_t) 1 << 52) ? 0 : 1;
+  }
+  else
+  {
+    /* exactly halfway between two doubles rounds to even */
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+        (mantissa << shift) == hi)
+      mantissa &= ~(uint64_t) 1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= ((uint64_t) 2 << 52))
+    {
+      mantissa = (uint64_t) 1 << 52;
+      power2++;
+    }
+    mantissa &= ~((uint64_t) 1 << 52);
+    if (power2 >= 0x7FF) return HUGE_VAL;
+  }
+
+  bits = mantissa | ((uint64_t) power2 << 52);
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+#endif
+
+/*
+ * Parse a single number of an extarr starting at p.
+ *
+ * Accepts only -?d+(.d+)?([eE][+-]?d+)? and only when a character that
+ * cannot continue the number follows it before end. Anything else returns
+ * NULL, leaving the number to the general tokenizer which either accepts it
+ * or reports the error. Whether the number is a double follows the general
+ * tokenizer's rule.
+ *
+ * When the decimal significand fits in 53 bits and the power of ten is
+ * exact, the double is a single correctly rounded multiply or divide
+ * (Clinger's fast path). Other significands of up to 19 digits use
+ * Eisel-Lemire. Only longer ones fall back to strtod.
+ */
+static const char *extarr_parse_num(const char *p, const char *end,
+                                    int *is_double, int64_t *ival, double *dval)
+{
+  const char *start = p, *digits;
+  uint64_t m = 0;
+  int nd = 0, e10 = 0, truncated = 0, neg = 0;
+
+  if (p < end && *p == '-') { neg = 1; p++; }
+
+  /* significant digits; those past 19 are dropped and only scale */
+  for (digits = p; p < end && (unsigned)(*p - '0') < 10; p++)
+  {
+    if (nd < 19) { m = m * 10 + (*p - '0'); if (m) nd++; }
+    else { e10++; truncated |= *p != '0'; }
+  }
+  if (p == digits) return NULL;
+
+  *is_double = 0;
+  if (p < end && *p == '.')
+  {
+    for (digits = ++p; p < end && (unsigned)(*p - '0') < 10; p++)
+    {
+      if (nd < 19) { m = m * 10 + (*p - '0'); if (m) nd++; e10--; }
+      else truncated |= *p != '0';
+    }
+    if (p == digits) return NULL;
+    *is_double = 1;
+  }
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    int eneg = 0, e = 0;
+    p++;
+    if (p < end && (*p == '+' || *p == '-')) eneg = *p++ == '-';
+    for (digits = p; p < end && (unsigned)(*p - '0') < 10; p++)
+      if (e < 100000) e = e * 10 + (*p - '0');
+    if (p == digits) return NULL;
+    e10 += eneg ? -e : e;
+    *is_double = 1;
+  }
+
+  /* the number must be known to be complete */
+  if (p >= end || strchr(json_number_chars, *p)) return NULL;
+
+  if (!*is_double)
+  {
+    if (truncated || nd > 18 || e10) return NULL;
+    *ival = neg ? -(int64_t) m : (int64_t) m;
+  }
+  else if (!truncated && m <= ((uint64_t)1 << 53) && e10 >= -22 && e10 <= 22)
+  {
+    double d = (double) m;
+    d = e10 < 0 ? d / extarr_pow10[-e10] : d * extarr_pow10[e10];
+    *dval = neg ? -d : d;
+  }
+#if defined(__SIZEOF_INT128__)
+  else if (!truncated)
+  {
+    double d = json_atod_eisel_lemire(m, e10);
+    *dval = neg ? -d : d;
+  }
+#endif
+  else
+  {
+    char buf[64];
+    if (p - start >= (int) sizeof(buf)) return NULL;
+    memcpy(buf, start, p - start);
+    buf[p - start] = '\0';
+    *dval = strtod(buf, NULL);
+  }
+
+  return p;
+}
+
+/*
+ * Bulk parse the values of an extarr directly into its buffer.
+ *
+ * Consumes as many complete "value ," groups starting at str as lie
+ * before end, stopping at the first value it cannot handle, a value not
+ * followed by a comma (e.g. the last) or once the extarr is full. What
+ * remains is left to the general tokenizer. This skips creating a
+ * json_object for every value.
+ *
+ * Returns the number of chars consumed.
+ */
+static int extarr_bulk_parse(struct json_object *cur, int *extarr_idx,
+                             const char *str, const char *end)
+{
+  enum json_extarr_type etype = json_object_extarr_type(cur);
+  void *data = (void *) json_object_extarr_data(cur);
+  int idx = *extarr_idx, nvals = json_object_extarr_nvals(cur);
+  const char *p = str, *consumed = str;
+
+  while (idx < nvals)
+  {
+    int is_double;
+    int64_t ival = 0;
+    double dval = 0;
+
+    while (p < end && isspace((int)*p)) p++;
+    if (!(p = extarr_parse_num(p, end, &is_double, &ival, &dval)))
+      break;
+    while (p < end && isspace((int)*p)) p++;
+    if (p >= end || *p != ',')
+      break;
+    store_extarr_num(etype, data, idx++, is_double, ival, dval);
+    consumed = ++p;
+  }
+
+  *extarr_idx = idx;
+  return (int) (consumed - str);
+}
+
 struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 					  const char *str, int len)
 {
   struct json_object *obj = NULL;
   int extarr_idx = 0;
+  const char *str_end;
   char c = '\1';
 #ifdef HAVE_SETLOCALE
   char *oldlocale=NULL, *tmplocale;
@@ -300,6 +620,7 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
     tok->err = json_tokener_error_size;
     return NULL;
   }
+  str_end = str + (len == -1 ? (int) strlen(str) : len);
 
   while (PEEK_CHAR(c, tok)) {
 
@@ -920,6 +1241,17 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 	saved_state = json_tokener_state_finish;
 	state = json_tokener_state_eatws;
       } else {
+	/* take the common case of plain numbers in bulk */
+	int n = extarr_bulk_parse(current, &extarr_idx, str, str_end);
+	if (n > 0) {
+	  str += n;
+	  tok->char_offset += n;
+	  saved_state = json_tokener_state_extarr_after_sep;
+	  state = json_tokener_state_eatws;
+	  if (!PEEK_CHAR(c, tok))
+	    goto out;
+	  goto redo_char;
+	}
 	if(tok->depth >= tok->max_depth-1) {
 	  tok->err = json_tokener_error_depth;
 	  goto out;
@@ -933,13 +1265,14 @@ struct json_object* json_tokener_parse_ex(struct json_tokener *tok,
 
     case json_tokener_state_extarr_add:
     {
-      put_extarr_val(current, obj, extarr_idx);
-      extarr_idx++;
-      if (extarr_idx > json_object_extarr_nvals(current))
+      if (extarr_idx >= json_object_extarr_nvals(current))
       {
+	json_object_put(obj);
 	tok->err = json_tokener_error_parse_extarr;
 	goto out;
       }
+      put_extarr_val(current, obj, extarr_idx);
+      extarr_idx++;
       saved_state = json_tokener_state_extarr_sep;
       state = json_tokener_state_eatws;
       goto redo_char;
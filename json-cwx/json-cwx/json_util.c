@@ -97,13 +97,45 @@ struct json_object* json_object_from_file(const char *filename)
   return obj;
 }
 
+static int fd_sink(void *data, const char *buf, size_t len)
+{
+  int fd = *(int*)data;
+  size_t wpos = 0;
+  int ret;
+
+  while(wpos < len) {
+    if((ret = write(fd, buf + wpos, len - wpos)) < 0) {
+      if(errno == EINTR) continue;
+      return -1;
+    }
+    wpos += (size_t)ret;
+  }
+  return 0;
+}
+
+/* "format and write to descriptor" function */
+
+int json_object_to_fd(int fd, struct json_object *obj, int flags)
+{
+  if(!obj) {
+    MC_ERROR("json_object_to_fd: object is null\n");
+    return -1;
+  }
+
+  if(json_object_to_json_sink(obj, flags, fd_sink, &fd) != 0) {
+    MC_ERROR("json_object_to_fd: error writing fd %d: %s\n",
+	     fd, strerror(errno));
+    return -1;
+  }
+
+  return 0;
+}
+
 /* extended "format and write to file" function */
 
 int json_object_to_file_ext(const char *filename, struct json_object *obj, int flags)
 {
-  const char *json_str;
-  int fd, ret;
-  unsigned int wpos, wsize;
+  int fd;
 
   if(!obj) {
     MC_ERROR("json_object_to_file: object is null\n");
@@ -116,25 +148,11 @@ int json_object_to_file_ext(const char *filename, struct json_object *obj, int f
     return -1;
   }
 
-  if(!(json_str = json_object_to_json_string_ext(obj,flags))) {
+  if(json_object_to_fd(fd, obj, flags) < 0) {
     close(fd);
     return -1;
   }
 
-  wsize = (unsigned int)(strlen(json_str) & UINT_MAX); /* CAW: probably unnecessary, but the most 64bit safe */
-  wpos = 0;
-  while(wpos < wsize) {
-    if((ret = write(fd, json_str + wpos, wsize-wpos)) < 0) {
-      close(fd);
-      MC_ERROR("json_object_to_file: error writing file %s: %s\n",
-	     filename, strerror(errno));
-      return -1;
-    }
-
-	/* because of the above check for ret < 0, we can safely cast and add */
-    wpos += (unsigned int)ret;
-  }
-
   close(fd);
   return 0;
 }
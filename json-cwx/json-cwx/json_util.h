@@ -24,6 +24,8 @@ extern "C" {
 extern struct json_object* json_object_from_file(const char *filename);
 extern int json_object_to_file(const char *filename, struct json_object *obj);
 extern int json_object_to_file_ext(const char *filename, struct json_object *obj, int flags);
+/* streams obj to an open descriptor in bounded chunks, see json_object_to_json_sink */
+extern int json_object_to_fd(int fd, struct json_object *obj, int flags);
 extern int json_parse_int64(const char *buf, int64_t *retval);
 extern int json_parse_double(const char *buf, double *retval);
 
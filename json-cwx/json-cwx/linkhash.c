@@ -23,6 +23,7 @@
 
 #include "random_seed.h"
 #include "linkhash.h"
+#include "json_object_private.h"
 
 void lh_abort(const char *msg, ...)
 {
@@ -397,7 +398,7 @@ static uint32_t hashlittle( const void *key, size_t length, uint32_t initval)
   return c;
 }
 
-unsigned long lh_char_hash(const void *k)
+static unsigned long lh_char_hash_len(const char *k, size_t len)
 {
 	static volatile int random_seed = -1;
 
@@ -415,7 +416,12 @@ unsigned long lh_char_hash(const void *k)
 #endif
 	}
 
-	return hashlittle((const char*)k, strlen((const char*)k), random_seed); 
+	return hashlittle(k, len, random_seed);
+}
+
+unsigned long lh_char_hash(const void *k)
+{
+	return lh_char_hash_len((const char*)k, strlen((const char*)k));
 }
 
 int lh_char_equal(const void *k1, const void *k2)
@@ -423,20 +429,22 @@ int lh_char_equal(const void *k1, const void *k2)
 	return (strcmp((const char*)k1, (const char*)k2) == 0);
 }
 
-struct lh_table* lh_table_new(int size, const char *name,
-			      lh_entry_free_fn *free_fn,
-			      lh_hash_fn *hash_fn,
-			      lh_equal_fn *equal_fn)
+struct lh_table* lh_table_new_arena(struct json_arena *arena,
+				    int size, const char *name,
+				    lh_entry_free_fn *free_fn,
+				    lh_hash_fn *hash_fn,
+				    lh_equal_fn *equal_fn)
 {
 	int i;
 	struct lh_table *t;
 
-	t = (struct lh_table*)calloc(1, sizeof(struct lh_table));
+	t = (struct lh_table*)json_arena_calloc(arena, 1, sizeof(struct lh_table));
 	if(!t) lh_abort("lh_table_new: calloc failed\n");
 	t->count = 0;
 	t->size = size;
 	t->name = name;
-	t->table = (struct lh_entry*)calloc(size, sizeof(struct lh_entry));
+	t->arena = arena;
+	t->table = (struct lh_entry*)json_arena_calloc(arena, size, sizeof(struct lh_entry));
 	if(!t->table) lh_abort("lh_table_new: calloc failed\n");
 	t->free_fn = free_fn;
 	t->hash_fn = hash_fn;
@@ -445,6 +453,14 @@ struct lh_table* lh_table_new(int size, const char *name,
 	return t;
 }
 
+struct lh_table* lh_table_new(int size, const char *name,
+			      lh_entry_free_fn *free_fn,
+			      lh_hash_fn *hash_fn,
+			      lh_equal_fn *equal_fn)
+{
+	return lh_table_new_arena(NULL, size, name, free_fn, hash_fn, equal_fn);
+}
+
 struct lh_table* lh_kchar_table_new(int size, const char *name,
 				    lh_entry_free_fn *free_fn)
 {
@@ -462,19 +478,19 @@ void lh_table_resize(struct lh_table *t, int new_size)
 	struct lh_table *new_t;
 	struct lh_entry *ent;
 
-	new_t = lh_table_new(new_size, t->name, NULL, t->hash_fn, t->equal_fn);
+	new_t = lh_table_new_arena(t->arena, new_size, t->name, NULL, t->hash_fn, t->equal_fn);
 	ent = t->head;
 	while(ent) {
 		lh_table_insert(new_t, ent->k, ent->v);
 		ent = ent->next;
 	}
-	free(t->table);
+	json_arena_release(t->arena, t->table);
 	t->table = new_t->table;
 	t->size = new_size;
 	t->head = new_t->head;
 	t->tail = new_t->tail;
 	t->resizes++;
-	free(new_t);
+	json_arena_release(t->arena, new_t);
 }
 
 void lh_table_free(struct lh_table *t)
@@ -485,8 +501,8 @@ void lh_table_free(struct lh_table *t)
 			t->free_fn(c);
 		}
 	}
-	free(t->table);
-	free(t);
+	json_arena_release(t->arena, t->table);
+	json_arena_release(t->arena, t);
 }
 
 
@@ -526,11 +542,15 @@ int lh_table_insert(struct lh_table *t, void *k, const void *v)
 
 struct lh_entry* lh_table_lookup_entry(struct lh_table *t, const void *k)
 {
-	unsigned long h = t->hash_fn(k);
+	t->lookups++;
+	return lh_table_lookup_entry_w_hash(t, k, t->hash_fn(k));
+}
+
+struct lh_entry* lh_table_lookup_entry_w_hash(struct lh_table *t, const void *k, unsigned long h)
+{
 	unsigned long n = h % t->size;
 	int count = 0;
 
-	t->lookups++;
 	while( count < t->size ) {
 		if(t->table[n].k == LH_EMPTY) return NULL;
 		if(t->table[n].k != LH_FREED &&
@@ -600,3 +620,217 @@ int lh_table_length(struct lh_table *t)
 {
 	return t->count;
 }
+
+
+/* compact table */
+
+#define LH_CTRL_EMPTY   0x80
+#define LH_CTRL_DELETED 0xFE
+#define LH_CTRL_LSBS    0x0101010101010101ULL
+#define LH_CTRL_MSBS    0x8080808080808080ULL
+
+/* A group of control bytes as a word with the first in the low byte. */
+static uint64_t lh_ctrl_group(const unsigned char *p)
+{
+	uint64_t g;
+#if HASH_LITTLE_ENDIAN
+	memcpy(&g, p, sizeof(g));
+#else
+	int i;
+	for(g = 0, i = LH_CTABLE_GROUP - 1; i >= 0; i--) g = (g << 8) | p[i];
+#endif
+	return g;
+}
+
+/* The high bit of each byte of the result flags a matching control byte.
+   lh_ctrl_match may flag a byte above a true match too. */
+static uint64_t lh_ctrl_match(uint64_t g, unsigned char h2)
+{
+	uint64_t x = g ^ (LH_CTRL_LSBS * h2);
+	return (x - LH_CTRL_LSBS) & ~x & LH_CTRL_MSBS;
+}
+
+static uint64_t lh_ctrl_match_empty(uint64_t g)
+{
+	return g & (~g << 6) & LH_CTRL_MSBS;
+}
+
+static uint64_t lh_ctrl_match_free(uint64_t g)
+{
+	return g & ~(g << 7) & LH_CTRL_MSBS;
+}
+
+static int lh_ctrl_first(uint64_t m)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(m) >> 3;
+#else
+	int i = 0;
+	while(!(m & 0x80)) { m >>= 8; i++; }
+	return i;
+#endif
+}
+
+static void lh_ctrl_set(struct lh_ctable *t, int i, unsigned char c)
+{
+	t->ctrl[i] = c;
+	if(i < LH_CTABLE_GROUP) t->ctrl[t->size + i] = c;
+}
+
+/* First empty or deleted slot on h's probe sequence */
+static int lh_ctable_free_slot(struct lh_ctable *t, unsigned long h)
+{
+	int mask = t->size - 1;
+	int pos = (int)(h >> 7) & mask, stride = 0;
+
+	while(1) {
+		uint64_t m = lh_ctrl_match_free(lh_ctrl_group(t->ctrl + pos));
+		if(m) return (pos + lh_ctrl_first(m)) & mask;
+		stride += LH_CTABLE_GROUP;
+		pos = (pos + stride) & mask;
+	}
+}
+
+static int lh_ctable_find_slot(struct lh_ctable *t, const char *k, int len, unsigned long h)
+{
+	int mask = t->size - 1;
+	int pos = (int)(h >> 7) & mask, stride = 0;
+	unsigned char h2 = h & 0x7F;
+
+	while(1) {
+		uint64_t g = lh_ctrl_group(t->ctrl + pos);
+		uint64_t m = lh_ctrl_match(g, h2);
+		for(; m; m &= m - 1) {
+			int i = (pos + lh_ctrl_first(m)) & mask;
+			struct lh_centry *e = &t->entries[t->slot[i]];
+			if(e->hash == h && e->klen == len && !memcmp(lh_centry_key(e), k, len))
+				return i;
+		}
+		if(lh_ctrl_match_empty(g)) return -1;
+		stride += LH_CTABLE_GROUP;
+		pos = (pos + stride) & mask;
+	}
+}
+
+/* Drop deleted entries and index the rest in a table of size slots */
+static void lh_ctable_rebuild(struct lh_ctable *t, int size)
+{
+	int i, n;
+
+	for(i = n = 0; i < t->nentries; i++)
+		if(t->entries[i].klen >= 0) t->entries[n++] = t->entries[i];
+	t->nentries = n;
+
+	free(t->ctrl);
+	free(t->slot);
+	t->size = size;
+	t->max_entries = size - size / 8;
+	t->ctrl = (unsigned char*)malloc(size + LH_CTABLE_GROUP);
+	t->slot = (int*)malloc(size * sizeof(int));
+	t->entries = (struct lh_centry*)realloc(t->entries, t->max_entries * sizeof(struct lh_centry));
+	if(!t->ctrl || !t->slot || !t->entries) lh_abort("lh_ctable_rebuild: malloc failed\n");
+	memset(t->ctrl, LH_CTRL_EMPTY, size + LH_CTABLE_GROUP);
+
+	for(i = 0; i < n; i++) {
+		int j = lh_ctable_free_slot(t, t->entries[i].hash);
+		lh_ctrl_set(t, j, t->entries[i].hash & 0x7F);
+		t->slot[j] = i;
+	}
+}
+
+struct lh_ctable* lh_ctable_new(int size, lh_centry_free_fn *free_fn)
+{
+	struct lh_ctable *t;
+	int slots = LH_CTABLE_GROUP;
+
+	while(slots - slots / 8 < size) slots *= 2;
+	t = (struct lh_ctable*)calloc(1, sizeof(struct lh_ctable));
+	if(!t) lh_abort("lh_ctable_new: calloc failed\n");
+	t->free_fn = free_fn;
+	lh_ctable_rebuild(t, slots);
+	return t;
+}
+
+void lh_ctable_free(struct lh_ctable *t)
+{
+	struct lh_centry *e;
+	lh_ctable_foreach(t, e) {
+		if(t->free_fn) t->free_fn(e);
+		if(e->klen > LH_CTABLE_INLINE_KEY) free(e->k.p);
+	}
+	free(t->ctrl);
+	free(t->slot);
+	free(t->entries);
+	free(t);
+}
+
+struct lh_centry* lh_ctable_insert(struct lh_ctable *t, const char *k, const void *v)
+{
+	struct lh_centry *e;
+	int len = strlen(k), i;
+
+	if(t->nentries == t->max_entries) {
+		/* grow unless deletes left enough room */
+		lh_ctable_rebuild(t, t->count >= t->max_entries / 2 ? t->size * 2 : t->size);
+	}
+
+	e = &t->entries[t->nentries];
+	e->hash = lh_char_hash_len(k, len);
+	e->v = v;
+	e->klen = len;
+	if(len > LH_CTABLE_INLINE_KEY) {
+		if(!(e->k.p = (char*)malloc(len + 1))) lh_abort("lh_ctable_insert: malloc failed\n");
+		memcpy(e->k.p, k, len + 1);
+	} else {
+		memcpy(e->k.s, k, len + 1);
+	}
+
+	i = lh_ctable_free_slot(t, e->hash);
+	lh_ctrl_set(t, i, e->hash & 0x7F);
+	t->slot[i] = t->nentries++;
+	t->count++;
+	return e;
+}
+
+struct lh_centry* lh_ctable_lookup_entry(struct lh_ctable *t, const char *k)
+{
+	int len = strlen(k);
+	int i = lh_ctable_find_slot(t, k, len, lh_char_hash_len(k, len));
+	return i < 0 ? NULL : &t->entries[t->slot[i]];
+}
+
+json_bool lh_ctable_lookup_ex(struct lh_ctable *t, const char *k, void **v)
+{
+	struct lh_centry *e = lh_ctable_lookup_entry(t, k);
+	if(v != NULL) *v = e ? (void*)e->v : NULL;
+	return e ? JSON_C_TRUE : JSON_C_FALSE;
+}
+
+int lh_ctable_delete(struct lh_ctable *t, const char *k)
+{
+	int len = strlen(k);
+	int i = lh_ctable_find_slot(t, k, len, lh_char_hash_len(k, len));
+	struct lh_centry *e;
+
+	if(i < 0) return -1;
+	e = &t->entries[t->slot[i]];
+	if(t->free_fn) t->free_fn(e);
+	if(e->klen > LH_CTABLE_INLINE_KEY) free(e->k.p);
+	e->klen = -1;
+	e->v = NULL;
+	lh_ctrl_set(t, i, LH_CTRL_DELETED);
+	t->count--;
+	return 0;
+}
+
+int lh_ctable_length(struct lh_ctable *t)
+{
+	return t->count;
+}
+
+struct lh_centry* lh_ctable_next(struct lh_ctable *t, struct lh_centry *e)
+{
+	struct lh_centry *end = t->entries + t->nentries;
+	while(e < end && e->klen < 0) e++;
+	return e < end ? e : NULL;
+}
@@ -42,6 +42,7 @@ extern "C" {
 #define LH_FREED (void*)-2
 
 struct lh_entry;
+struct json_arena;
 
 /**
  * callback function prototypes
@@ -140,6 +141,11 @@ struct lh_table {
 	lh_entry_free_fn *free_fn;
 	lh_hash_fn *hash_fn;
 	lh_equal_fn *equal_fn;
+
+	/**
+	 * The arena the table is allocated from or NULL.
+	 */
+	struct json_arena *arena;
 };
 
 
@@ -189,6 +195,20 @@ extern struct lh_table* lh_table_new(int size, const char *name,
 				     lh_hash_fn *hash_fn,
 				     lh_equal_fn *equal_fn);
 
+/**
+ * Create a new linkhash table allocated from an arena.
+ * The table and its storage are only freed with the arena, although
+ * lh_table_free and lh_table_delete still call free_fn.
+ * @param arena the arena or NULL for an ordinary table.
+ * See lh_table_new for the other parameters.
+ * @return a pointer onto the linkhash table.
+ */
+extern struct lh_table* lh_table_new_arena(struct json_arena *arena,
+					   int size, const char *name,
+					   lh_entry_free_fn *free_fn,
+					   lh_hash_fn *hash_fn,
+					   lh_equal_fn *equal_fn);
+
 /**
  * Convenience function to create a new linkhash
  * table with char keys.
@@ -239,6 +259,16 @@ extern int lh_table_insert(struct lh_table *t, void *k, const void *v);
  */
 extern struct lh_entry* lh_table_lookup_entry(struct lh_table *t, const void *k);
 
+/**
+ * Lookup a record in the table given the key's precomputed hash.
+ * Unlike lh_table_lookup_entry, this does not modify the table.
+ * @param t the table to lookup
+ * @param k a pointer to the key to lookup
+ * @param h the value of t->hash_fn(k)
+ * @return a pointer to the record structure of the value or NULL if it does not exist.
+ */
+extern struct lh_entry* lh_table_lookup_entry_w_hash(struct lh_table *t, const void *k, unsigned long h);
+
 /**
  * Lookup a record into the table
  * @param t the table to lookup
@@ -282,6 +312,163 @@ extern int lh_table_delete(struct lh_table *t, const void *k);
 
 extern int lh_table_length(struct lh_table *t);
 
+
+/**
+ * Keys of up to this many chars are stored inline in a compact table's entries.
+ */
+#define LH_CTABLE_INLINE_KEY 15
+
+/**
+ * Number of control bytes a compact table examines at once.
+ */
+#define LH_CTABLE_GROUP 8
+
+/**
+ * An entry in a compact table
+ */
+struct lh_centry {
+	/**
+	 * The key's hash.
+	 */
+	unsigned long hash;
+	/**
+	 * The value.
+	 */
+	const void *v;
+	/**
+	 * Length of the key or -1 for a deleted entry.
+	 */
+	int klen;
+	/**
+	 * The table's own copy of the key. Use lh_centry_key to get it.
+	 */
+	union {
+		char s[LH_CTABLE_INLINE_KEY + 1];
+		char *p;
+	} k;
+};
+
+/**
+ * callback function prototypes
+ */
+typedef void (lh_centry_free_fn) (struct lh_centry *e);
+
+/**
+ * A compact, string keyed hash table.
+ *
+ * An alternative to lh_table with lookups touching less memory. Entries
+ * are kept densely in insertion order with their hash and, when short,
+ * their key. They are indexed by an open-addressing table of one control
+ * byte per slot holding 7 bits of the key's hash, probed LH_CTABLE_GROUP
+ * slots at a time, as in Google's SwissTable. A key is only compared
+ * when both its control byte and full hash match. Pointers to entries
+ * are only valid until the next insert.
+ */
+struct lh_ctable {
+	/**
+	 * Number of slots, a power of 2.
+	 */
+	int size;
+	/**
+	 * Number of entries.
+	 */
+	int count;
+	/**
+	 * Number of entries used including deleted ones.
+	 */
+	int nentries;
+	/**
+	 * Number of entries allocated, 7/8 of size.
+	 */
+	int max_entries;
+	/**
+	 * Control byte of each slot. The first LH_CTABLE_GROUP are repeated at the end.
+	 */
+	unsigned char *ctrl;
+	/**
+	 * Index in entries of the entry in each full slot.
+	 */
+	int *slot;
+	/**
+	 * The entries, in insertion order.
+	 */
+	struct lh_centry *entries;
+	/**
+	 * A pointer onto the function responsible for freeing an entry's value.
+	 */
+	lh_centry_free_fn *free_fn;
+};
+
+/**
+ * The key of a compact table entry.
+ */
+#define lh_centry_key(e) ((e)->klen > LH_CTABLE_INLINE_KEY ? (e)->k.p : (e)->k.s)
+
+/**
+ * Compact table iterator, in insertion order.
+ */
+#define lh_ctable_foreach(table, entry) \
+for(entry = lh_ctable_next(table, (table)->entries); entry; entry = lh_ctable_next(table, entry + 1))
+
+/**
+ * Create a new compact table.
+ * @param size number of entries expected. The table is automatically resized.
+ * @param free_fn callback function called for entries when
+ * lh_ctable_free or lh_ctable_delete is called. Keys are copied by the
+ * table and always freed by it.
+ * @return a pointer onto the table.
+ */
+extern struct lh_ctable* lh_ctable_new(int size, lh_centry_free_fn *free_fn);
+
+/**
+ * Free a compact table, calling free_fn for all entries.
+ * @param t table to free.
+ */
+extern void lh_ctable_free(struct lh_ctable *t);
+
+/**
+ * Insert a record into a compact table. The key must not already be in it.
+ * @param t the table to insert into.
+ * @param k the key, copied by the table.
+ * @param v the value.
+ * @return a pointer to the new entry.
+ */
+extern struct lh_centry* lh_ctable_insert(struct lh_ctable *t, const char *k, const void *v);
+
+/**
+ * Lookup a record in a compact table.
+ * @param t the table to lookup
+ * @param k the key to lookup
+ * @return a pointer to the entry or NULL if it does not exist. Its value
+ * may be replaced.
+ */
+extern struct lh_centry* lh_ctable_lookup_entry(struct lh_ctable *t, const char *k);
+
+/**
+ * Lookup a record in a compact table
+ * @param t the table to lookup
+ * @param k the key to lookup
+ * @param v a pointer to a where to store the found value (set to NULL if it doesn't exist).
+ * @return whether or not the key was found
+ */
+extern json_bool lh_ctable_lookup_ex(struct lh_ctable *t, const char *k, void **v);
+
+/**
+ * Delete a record from a compact table, calling free_fn for it.
+ * @param t the table to delete from.
+ * @param k the key to delete.
+ * @return 0 if the item was deleted.
+ * @return -1 if it was not found.
+ */
+extern int lh_ctable_delete(struct lh_ctable *t, const char *k);
+
+extern int lh_ctable_length(struct lh_ctable *t);
+
+/**
+ * The first entry at or after e that has not been deleted or NULL.
+ */
+extern struct lh_centry* lh_ctable_next(struct lh_ctable *t, struct lh_centry *e);
+
 void lh_abort(const char *msg, ...);
 void lh_table_resize(struct lh_table *t, int new_size);
 
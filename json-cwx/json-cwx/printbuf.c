@@ -85,6 +85,8 @@ int printbuf_memappend(struct printbuf *p, const char *buf, int size)
   memcpy(p->buf + p->bpos, buf, size);
   p->bpos += size;
   p->buf[p->bpos]= '\0';
+  if (p->sink && p->bpos >= p->sink_chunk)
+    printbuf_flush(p);
   return size;
 }
 
@@ -104,10 +106,23 @@ int printbuf_memset(struct printbuf *pb, int offset, int charvalue, int len)
 	memset(pb->buf + offset, charvalue, len);
 	if (pb->bpos < size_needed)
 		pb->bpos = size_needed;
+	if (pb->sink && pb->bpos >= pb->sink_chunk)
+		printbuf_flush(pb);
 
 	return 0;
 }
 
+int printbuf_flush(struct printbuf *p)
+{
+  if (!p->sink)
+    return 0;
+  if (p->bpos > 0 && !p->sink_err)
+    p->sink_err = p->sink(p->sink_data, p->buf, (size_t) p->bpos);
+  p->bpos = 0;
+  p->buf[0] = '\0';
+  return p->sink_err;
+}
+
 #if !defined(HAVE_VSNPRINTF) && defined(_MSC_VER)
 # define vsnprintf _vsnprintf
 #elif !defined(HAVE_VSNPRINTF) /* !HAVE_VSNPRINTF */
@@ -16,6 +16,8 @@
 #ifndef _printbuf_h_
 #define _printbuf_h_
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -24,6 +26,13 @@ struct printbuf {
   char *buf;
   int bpos;
   int size;
+  /* When sink is set, the buffered data is handed to sink and the buffer
+   * emptied whenever bpos reaches sink_chunk. The first non-zero return
+   * from sink is kept in sink_err and any later data is discarded. */
+  int (*sink)(void *data, const char *buf, size_t len);
+  void *sink_data;
+  int sink_chunk;
+  int sink_err;
 };
 
 extern struct printbuf*
@@ -45,11 +54,22 @@ do {                                                         \
     memcpy(p->buf + p->bpos, (bufptr), bufsize);             \
     p->bpos += bufsize;                                      \
     p->buf[p->bpos]= '\0';                                   \
+    if (p->sink && p->bpos >= p->sink_chunk)                 \
+      printbuf_flush(p);                                     \
   } else {  printbuf_memappend(p, (bufptr), bufsize); }      \
 } while (0)
 
 #define printbuf_length(p) ((p)->bpos)
 
+/**
+ * Hand any buffered data to the printbuf's sink and empty the buffer.
+ * Does nothing when no sink is set.
+ *
+ * Returns the sink's error status (0 on success).
+ */
+extern int
+printbuf_flush(struct printbuf *p);
+
 /**
  * Set len bytes of the buffer to charvalue, starting at offset offset.
  * Similar to calling memset(x, charvalue, len);
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "json.h"
+
+/* Microbenchmark of text serialization and parsing throughput of extarrs.
+
+   usage: bench_extarr [nvals [reps]]
+
+   Reports, for each extarr type, the rate at which text is produced and
+   parsed and the corresponding rate in the array's raw bytes, all in MB/s.
+   A memcpy of the raw bytes is reported for reference. */
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void bench(char const *name, void const *data, enum json_extarr_type etype, int n, int reps)
+{
+	json_object *arr = json_object_new_extarr(data, etype, 1, &n, JSON_C_EXTARR_DONT_FREE);
+	double nbytes = (double) json_object_extarr_nbytes(arr);
+	double t0, t1, textbytes = 0;
+	char *text, *copy;
+	int i;
+
+	t0 = now();
+	for (i = 0; i < reps; i++)
+		textbytes += strlen(json_object_to_json_string_ext(arr, JSON_C_TO_STRING_PLAIN));
+	t1 = now();
+
+	printf("%-6s %10d vals x %3d: write text %8.2f MB/s, raw %8.2f MB/s, %5.2f chars/val\n",
+		name, n, reps, textbytes / (t1 - t0) / 1e6,
+		nbytes * reps / (t1 - t0) / 1e6,
+		textbytes / reps / n);
+
+	text = strdup(json_object_to_json_string_ext(arr, JSON_C_TO_STRING_PLAIN));
+	t0 = now();
+	for (i = 0; i < reps; i++)
+		json_object_put(json_tokener_parse(text));
+	t1 = now();
+
+	printf("%-6s %10d vals x %3d:  read text %8.2f MB/s, raw %8.2f MB/s\n",
+		name, n, reps, strlen(text) * reps / (t1 - t0) / 1e6,
+		nbytes * reps / (t1 - t0) / 1e6);
+
+	copy = (char *) malloc(nbytes);
+	t0 = now();
+	for (i = 0; i < reps; i++)
+	{
+		memcpy(copy, data, nbytes);
+		copy[i % (int) nbytes]++;
+	}
+	t1 = now();
+	printf("%-6s %10d vals x %3d:     memcpy %8.2f MB/s\n",
+		name, n, reps, nbytes * reps / (t1 - t0) / 1e6);
+
+	free(copy);
+	free(text);
+	json_object_put(arr);
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	int reps = argc > 2 ? atoi(argv[2]) : 5;
+	double *dvals = (double *) malloc(n * sizeof(double));
+	float *fvals = (float *) malloc(n * sizeof(float));
+	int *ivals = (int *) malloc(n * sizeof(int));
+	int i;
+
+	/* values typical of a mesh; coordinates and noisy field data */
+	srand(0);
+	for (i = 0; i < n; i++)
+	{
+		dvals[i] = i * 0.001 + (double) rand() / RAND_MAX;
+		fvals[i] = (float) dvals[i];
+		ivals[i] = rand() - RAND_MAX / 2;
+	}
+
+	bench("flt64", dvals, json_extarr_type_flt64, n, reps);
+	bench("flt32", fvals, json_extarr_type_flt32, n, reps);
+	bench("int32", ivals, json_extarr_type_int32, n, reps);
+
+	free(dvals);
+	free(fvals);
+	free(ivals);
+	return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "json.h"
+
+/* Microbenchmark of lh_table against lh_ctable.
+
+   usage: bench_linkhash [ntables [nkeys]]
+
+   The small workload mimics MACSio's main_obj: ntables mesh part objects, each
+   with the same couple dozen short keys, which are built, queried for a few
+   keys at a time along paths, queried for keys they do not have, iterated and
+   freed. The large workload does the same with a single table of nkeys keys
+   looked up in random order. Reports ns per operation. */
+
+static char const *part_keys[] = {
+	"Bounds", "ChunkID", "CoordBasis", "Coords", "DomainDim", "GeomDim",
+	"GlobalLogIndices", "GlobalLogOrigin", "LogDims", "MeshType", "NodeCounts",
+	"NumX", "NumY", "NumZ", "OriginX", "OriginY", "OriginZ", "TopoDim",
+	"Topology", "Type", "Vars", "XAxisCoords", "YAxisCoords", "ZAxisCoords", 0
+};
+
+/* keys of a path query, e.g. parts/i/Mesh/LogDims, and ones not present */
+static char const *hit_keys[] = {"ChunkID", "LogDims", "Vars", "GlobalLogOrigin", "Type", 0};
+static char const *miss_keys[] = {"name", "centering", "Mesh", "data", 0};
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void lh_entry_free_key(struct lh_entry *e)
+{
+	free(e->k);
+}
+
+static void report(char const *workload, char const *op, double lh_t, double ct_t, double nops)
+{
+	printf("%-6s %-8s lh_table %8.1f ns, lh_ctable %8.1f ns, speedup %5.2f\n",
+		workload, op, lh_t / nops * 1e9, ct_t / nops * 1e9, lh_t / ct_t);
+}
+
+/* ops are: 0 build, 1 hits, 2 misses, 3 iterate, 4 free */
+static void run(char const *workload, int ntables, char **keys, int nkeys,
+	char **hits, int nhits, char **misses, int nmisses, int reps)
+{
+	struct lh_table **lh = (struct lh_table **) malloc(ntables * sizeof(*lh));
+	struct lh_ctable **ct = (struct lh_ctable **) malloc(ntables * sizeof(*ct));
+	double t[5][2], nops[5];
+	long sum[2] = {0, 0};
+	int i, j, r;
+
+	nops[0] = nops[4] = (double) ntables * nkeys;
+	nops[1] = (double) ntables * nhits * reps;
+	nops[2] = (double) ntables * nmisses * reps;
+	nops[3] = (double) ntables * nkeys * reps;
+
+	/* as json_object_object_add() does: check for the key, then insert a copy */
+	t[0][0] = now();
+	for (i = 0; i < ntables; i++)
+	{
+		lh[i] = lh_kchar_table_new(JSON_OBJECT_DEF_HASH_ENTRIES, NULL, lh_entry_free_key);
+		for (j = 0; j < nkeys; j++)
+			if (!lh_table_lookup_entry(lh[i], keys[j]))
+				lh_table_insert(lh[i], strdup(keys[j]), keys[j]);
+	}
+	t[0][0] = now() - t[0][0];
+	t[0][1] = now();
+	for (i = 0; i < ntables; i++)
+	{
+		ct[i] = lh_ctable_new(JSON_OBJECT_DEF_HASH_ENTRIES, NULL);
+		for (j = 0; j < nkeys; j++)
+			if (!lh_ctable_lookup_entry(ct[i], keys[j]))
+				lh_ctable_insert(ct[i], keys[j], keys[j]);
+	}
+	t[0][1] = now() - t[0][1];
+
+	t[1][0] = now();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < ntables; i++)
+			for (j = 0; j < nhits; j++)
+				sum[0] += lh_table_lookup_entry(lh[i], hits[j]) != 0;
+	t[1][0] = now() - t[1][0];
+	t[1][1] = now();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < ntables; i++)
+			for (j = 0; j < nhits; j++)
+				sum[1] += lh_ctable_lookup_entry(ct[i], hits[j]) != 0;
+	t[1][1] = now() - t[1][1];
+
+	t[2][0] = now();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < ntables; i++)
+			for (j = 0; j < nmisses; j++)
+				sum[0] += lh_table_lookup_entry(lh[i], misses[j]) != 0;
+	t[2][0] = now() - t[2][0];
+	t[2][1] = now();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < ntables; i++)
+			for (j = 0; j < nmisses; j++)
+				sum[1] += lh_ctable_lookup_entry(ct[i], misses[j]) != 0;
+	t[2][1] = now() - t[2][1];
+
+	t[3][0] = now();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < ntables; i++)
+		{
+			struct lh_entry *e;
+			lh_foreach(lh[i], e)
+				sum[0] += ((char const *) e->k)[0];
+		}
+	t[3][0] = now() - t[3][0];
+	t[3][1] = now();
+	for (r = 0; r < reps; r++)
+		for (i = 0; i < ntables; i++)
+		{
+			struct lh_centry *e;
+			lh_ctable_foreach(ct[i], e)
+				sum[1] += lh_centry_key(e)[0];
+		}
+	t[3][1] = now() - t[3][1];
+
+	t[4][0] = now();
+	for (i = 0; i < ntables; i++)
+		lh_table_free(lh[i]);
+	t[4][0] = now() - t[4][0];
+	t[4][1] = now();
+	for (i = 0; i < ntables; i++)
+		lh_ctable_free(ct[i]);
+	t[4][1] = now() - t[4][1];
+
+	if (sum[0] != sum[1])
+		printf("%s: lh_table and lh_ctable disagree\n", workload);
+	report(workload, "insert", t[0][0], t[0][1], nops[0]);
+	report(workload, "hit", t[1][0], t[1][1], nops[1]);
+	report(workload, "miss", t[2][0], t[2][1], nops[2]);
+	report(workload, "iterate", t[3][0], t[3][1], nops[3]);
+	report(workload, "free", t[4][0], t[4][1], nops[4]);
+
+	free(lh);
+	free(ct);
+}
+
+static int count(char const **keys)
+{
+	int n = 0;
+	while (keys[n]) n++;
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	int ntables = argc > 1 ? atoi(argv[1]) : 100000;
+	int nkeys = argc > 2 ? atoi(argv[2]) : 1000000;
+	char **keys = (char **) malloc(nkeys * sizeof(char *));
+	char **hits = (char **) malloc(nkeys * sizeof(char *));
+	char **misses = (char **) malloc(nkeys * sizeof(char *));
+	int i;
+
+	run("small", ntables, (char **) part_keys, count(part_keys), (char **) hit_keys,
+		count(hit_keys), (char **) miss_keys, count(miss_keys), 10);
+
+	/* keys as long as those of MACSio's timers and log records */
+	for (i = 0; i < nkeys; i++)
+	{
+		char buf[64];
+		snprintf(buf, sizeof(buf), "%s_%d", i % 2 ? "part" : "MACSIO_MAIN_dump_iteration", i);
+		keys[i] = strdup(buf);
+		snprintf(buf, sizeof(buf), "missing_%d", i);
+		misses[i] = strdup(buf);
+	}
+	srand(1);
+	for (i = 0; i < nkeys; i++)
+		hits[i] = keys[rand() % nkeys];
+	run("large", 1, keys, nkeys, hits, nkeys, misses, nkeys, 1);
+
+	for (i = 0; i < nkeys; i++)
+	{
+		free(keys[i]);
+		free(misses[i]);
+	}
+	free(keys);
+	free(hits);
+	free(misses);
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+/* Objects built in an arena serialize the same as objects built on the heap
+   and survive json_object_put() until the arena is freed. */
+
+static json_object *member(json_object *obj, char const *key)
+{
+	json_object *val = 0;
+	json_object_object_get_ex(obj, key, &val);
+	return val;
+}
+
+static json_object *build(void)
+{
+	json_object *top = json_object_new_object();
+	json_object *arr = json_object_new_array();
+	json_object *str = json_object_new_string("first");
+	int dims[2] = {2, 3};
+	json_object *xa = json_object_new_extarr_alloc(json_extarr_type_int32, 2, dims, 0);
+	json_object *en = json_object_new_enum();
+	int i, *vals = (int *) json_object_extarr_data(xa);
+	char key[32];
+
+	for (i = 0; i < 6; i++)
+		vals[i] = i * i;
+
+	/* enough members and elements to resize the table and the list */
+	for (i = 0; i < 100; i++)
+	{
+		snprintf(key, sizeof(key), "key%03d", i);
+		json_object_object_add(top, key, json_object_new_int(i));
+		json_object_array_add(arr, json_object_new_double(i / 4.0));
+	}
+	json_object_object_add(top, "key050", json_object_new_string("replaced"));
+	json_object_object_del(top, "key051");
+
+	json_object_set_string(str, "second, and longer");
+	json_object_object_add(top, "str", str);
+	json_object_object_add(top, "len", json_object_new_string_len("abcdef", 3));
+	json_object_object_add(top, "ds", json_object_new_double_s(0.1, "0.1000"));
+	json_object_object_add(top, "arr", arr);
+	json_object_object_add(top, "xa", xa);
+	json_object_enum_add(en, "red", 0, JSON_C_FALSE);
+	json_object_enum_add(en, "blue", 1, JSON_C_TRUE);
+	json_object_object_add(top, "en", en);
+	return top;
+}
+
+int main(int argc, char **argv)
+{
+	struct json_arena *arena = json_arena_new(1024), *inner = json_arena_new(0), *prev;
+	json_object *heap, *top, *kept, *nested, *plain;
+	char *heap_str;
+
+	heap = build();
+	heap_str = strdup(json_object_to_json_string_ext(heap, JSON_C_TO_STRING_PLAIN));
+
+	printf("no arena: %s\n", json_arena_current() ? "in use" : "none");
+	printf("previous: %s\n", json_arena_use(arena) ? "in use" : "none");
+	top = build();
+	kept = member(top, "str");
+
+	/* arenas nest and the heap can be returned to temporarily */
+	prev = json_arena_use(inner);
+	nested = json_object_new_string("inner");
+	printf("restored: %s\n", json_arena_use(prev) == inner && json_arena_current() == arena ? "yes" : "no");
+	prev = json_arena_use(0);
+	plain = json_object_new_string("heap");
+	json_arena_use(prev);
+
+	printf("same output: %s\n",
+	    strcmp(heap_str, json_object_to_json_string_ext(top, JSON_C_TO_STRING_PLAIN)) ? "no" : "yes");
+	printf("str: %s\n", json_object_to_json_string(member(top, "str")));
+	printf("ds: %s\n", json_object_to_json_string(member(top, "ds")));
+
+	printf("put top: %d\n", json_object_put(top));
+	printf("kept after put: %s\n", json_object_get_string(kept));
+	printf("nested: %s\n", json_object_get_string(nested));
+	json_arena_free(inner);
+
+	json_arena_free(arena);
+	printf("after free: %s\n", json_arena_current() ? "in use" : "none");
+	printf("plain: %s\n", json_object_get_string(plain));
+
+	json_object_put(plain);
+	json_object_put(heap);
+	free(heap_str);
+	return 0;
+}
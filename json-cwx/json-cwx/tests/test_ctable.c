@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+/* An lh_ctable holds the same keys and values, in the same order, as an
+   lh_table given the same random sequence of inserts, replacements and
+   deletes of short and long keys. */
+
+static int nfreed = 0;
+
+static void count_free(struct lh_centry *e)
+{
+	nfreed++;
+}
+
+static void free_key(struct lh_entry *e)
+{
+	free(e->k);
+}
+
+static int same(struct lh_table *lh, struct lh_ctable *ct)
+{
+	struct lh_entry *e;
+	struct lh_centry *c = lh_ctable_next(ct, ct->entries);
+
+	if (lh_table_length(lh) != lh_ctable_length(ct))
+		return 0;
+	lh_foreach(lh, e)
+	{
+		void *v;
+		if (!c || strcmp((char const *) e->k, lh_centry_key(c)) || c->v != e->v)
+			return 0;
+		if (!lh_ctable_lookup_ex(ct, (char const *) e->k, &v) || v != e->v)
+			return 0;
+		c = lh_ctable_next(ct, c + 1);
+	}
+	return c == 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct lh_table *lh = lh_kchar_table_new(16, NULL, free_key);
+	struct lh_ctable *ct = lh_ctable_new(0, count_free);
+	int i, ok = 1, ndeletes = 0, maxlen = 0;
+	void *v;
+
+	srand(7);
+	for (i = 0; i < 200000 && ok; i++)
+	{
+		char key[64];
+		int r = rand() % 2000;
+		struct lh_entry *e;
+
+		/* a mix of inline and heap allocated keys */
+		if (r % 3)
+			snprintf(key, sizeof(key), "k%d", r);
+		else
+			snprintf(key, sizeof(key), "a_much_longer_key_%d", r);
+
+		e = lh_table_lookup_entry(lh, key);
+		if (rand() % 3 == 0)
+		{
+			if ((e != 0) != (lh_ctable_delete(ct, key) == 0))
+				ok = 0;
+			if (e)
+			{
+				lh_table_delete_entry(lh, e);
+				ndeletes++;
+			}
+		}
+		else if (e)
+		{
+			e->v = (void *)(long) i;
+			lh_ctable_lookup_entry(ct, key)->v = (void *)(long) i;
+		}
+		else
+		{
+			lh_table_insert(lh, strdup(key), (void *)(long) i);
+			lh_ctable_insert(ct, key, (void *)(long) i);
+		}
+
+		if (i % 10000 == 0 && !same(lh, ct))
+			ok = 0;
+		if (lh_table_length(lh) > maxlen)
+			maxlen = lh_table_length(lh);
+	}
+
+	printf("random operations: %s\n", ok && same(lh, ct) ? "same" : "differ");
+	printf("deletes freed: %s\n", nfreed == ndeletes ? "all" : "wrong count");
+	printf("size bounded: %s\n", ct->size <= 4 * maxlen ? "yes" : "no");
+	v = ct;
+	i = lh_ctable_lookup_ex(ct, "not there", &v);
+	printf("missing key: %d %s\n", i, v ? "non-null" : "null");
+	printf("delete missing: %d\n", lh_ctable_delete(ct, "not there"));
+
+	nfreed = 0;
+	i = lh_ctable_length(ct);
+	lh_ctable_free(ct);
+	lh_table_free(lh);
+	printf("free calls free_fn: %s\n", nfreed == i ? "yes" : "no");
+
+	/* empty keys and keys exactly at the inline limit */
+	ct = lh_ctable_new(4, NULL);
+	lh_ctable_insert(ct, "", "empty");
+	lh_ctable_insert(ct, "fifteen_chars__", "inline");
+	lh_ctable_insert(ct, "sixteen_chars___", "heap");
+	{
+		struct lh_centry *c;
+		lh_ctable_foreach(ct, c)
+			printf("\"%s\": %s\n", lh_centry_key(c), (char const *) c->v);
+	}
+	lh_ctable_free(ct);
+
+	return 0;
+}
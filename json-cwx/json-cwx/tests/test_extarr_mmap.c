@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "json.h"
+
+/* Extarrs mapped from regions of a file, at offsets that are not page
+   aligned and regions that straddle pages, hold the file's bytes and are
+   unmapped when deleted unless the caller keeps ownership. */
+
+static char const *fname = "test_extarr_mmap.dat";
+
+static void check(char const *what, json_object *xa, double const *expect, int n)
+{
+	double const *vals = (double const *) json_object_extarr_data(xa);
+	int i, ok = xa && json_object_extarr_nvals(xa) == n;
+
+	for (i = 0; ok && i < n; i++)
+		ok = vals[i] == expect[i];
+	printf("%-24s %s\n", what, ok ? "ok" : "wrong");
+}
+
+int main(int argc, char **argv)
+{
+	long pagesize = sysconf(_SC_PAGESIZE);
+	char const *header = "{\"hdr\":1}\n";
+	double vals[1000];
+	int i, dims[2] = {10, 100}, nodims[1] = {0};
+	int64_t offset = strlen(header), far = 3 * pagesize - 8;
+	json_object *xa, *top, *arena_xa;
+	struct json_arena *arena;
+	FILE *f;
+
+	for (i = 0; i < 1000; i++)
+		vals[i] = i * 0.5;
+	f = fopen(fname, "wb");
+	fwrite(header, 1, offset, f);
+	fwrite(vals, sizeof(double), 1000, f);
+	fseek(f, far, SEEK_SET);
+	fwrite(vals, sizeof(double), 1000, f);
+	fclose(f);
+
+	xa = json_object_new_extarr_mmap(fname, offset, json_extarr_type_flt64, 2, dims, 0);
+	check("after header", xa, vals, 1000);
+	printf("nbytes: %lld\n", (long long) json_object_extarr_nbytes(xa));
+	json_object_put(xa);
+
+	/* in a hierarchy, across page boundaries */
+	top = json_object_new_object();
+	json_object_object_add(top, "far", json_object_new_extarr_mmap(fname, far,
+		json_extarr_type_flt64, 2, dims, 0));
+	check("straddling pages", json_object_path_get_extarr(top, "far"), vals, 1000);
+	json_object_put(top);
+
+	/* the caller keeps ownership of the mapping */
+	xa = json_object_new_extarr_mmap(fname, offset + 8 * 500, json_extarr_type_flt64, 1,
+		dims + 1, JSON_C_EXTARR_DONT_FREE);
+	check("caller owned", xa, vals + 500, 100);
+	{
+		char *data = (char *) json_object_extarr_data(xa);
+		size_t delta = (size_t) data % pagesize;
+		json_object_put(xa);
+		printf("caller munmap: %d\n", munmap(data - delta, 800 + delta));
+	}
+
+	/* unmapped when the arena is freed */
+	arena = json_arena_new(0);
+	json_arena_use(arena);
+	arena_xa = json_object_new_extarr_mmap(fname, offset, json_extarr_type_flt64, 2, dims, 0);
+	json_arena_use(NULL);
+	check("in arena", arena_xa, vals, 1000);
+	json_object_put(arena_xa);
+	json_arena_free(arena);
+
+	xa = json_object_new_extarr_mmap(fname, offset, json_extarr_type_flt64, 1, nodims, 0);
+	printf("empty: %s nbytes %lld\n", xa && !json_object_extarr_data(xa) ? "ok" : "wrong",
+		(long long) json_object_extarr_nbytes(xa));
+	json_object_put(xa);
+
+	printf("missing file: %s\n", json_object_new_extarr_mmap("no_such_file.dat", 0,
+		json_extarr_type_flt64, 2, dims, 0) ? "mapped" : "null");
+	printf("negative offset: %s\n", json_object_new_extarr_mmap(fname, -8,
+		json_extarr_type_flt64, 2, dims, 0) ? "mapped" : "null");
+
+	remove(fname);
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+/* Parsing of extarr values. Whatever path a value takes through the
+   tokener, the stored value must be the same. */
+
+static void parse_extarr(char const *str)
+{
+	json_object *obj = json_tokener_parse(str);
+	int i;
+
+	printf("%s =>", str);
+	if (!obj || !json_object_is_type(obj, json_type_extarr))
+	{
+		printf(" error\n");
+		json_object_put(obj);
+		return;
+	}
+	for (i = 0; i < json_object_extarr_nvals(obj); i++)
+	{
+		void const *data = json_object_extarr_data(obj);
+		switch (json_object_extarr_type(obj))
+		{
+			case json_extarr_type_byt08: printf(" %d", ((unsigned char const *)data)[i]); break;
+			case json_extarr_type_int32: printf(" %d", ((int const *)data)[i]); break;
+			case json_extarr_type_int64: printf(" %lld", (long long) ((int64_t const *)data)[i]); break;
+			case json_extarr_type_flt32: printf(" %.9g", ((float const *)data)[i]); break;
+			case json_extarr_type_flt64: printf(" %.17g", ((double const *)data)[i]); break;
+			default: break;
+		}
+	}
+	printf("\n");
+	json_object_put(obj);
+}
+
+int main(int argc, char **argv)
+{
+	int i, n = 10000, nbad = 0;
+	double *rvals;
+	json_object *arr, *back;
+
+	/* type 6 is flt64, 5 flt32, 3 int32, 4 int64, 2 byt08 */
+	parse_extarr("(6, 1, 12, 0, -0.0, 1.5, -2.25e-3, 1E5, 0.1, 1e22, 1e23, "
+	             "123456789012345678901234, 0.30000000000000004, 5e-324, 7)");
+	parse_extarr("(6, 1, 7, 0, 9007199254740993.0, 9007199254740995.0, 2.2250738585072011e-308, "
+	             "1.00000000000000011102230246251565404236316680908203125, 1e-400, 1e400)");
+	parse_extarr("(6, 1, 4, 1, NaN, -Infinity, 2)");
+	parse_extarr("(5, 1, 3, 0.1, 16777217, 3.4028235e38)");
+	parse_extarr("(3, 1, 6, 1, -7, 3000000000, -3000000000, 2.9, -2.9)");
+	parse_extarr("(4, 1, 4, 1, 9223372036854775807, -9223372036854775807, 1e3)");
+	parse_extarr("(2, 1, 4, 1, 255, 256, 0007)");
+	parse_extarr("(6, 2, 2, 2,\n  1 ,\t2 ,3,\n  4\n)");
+
+	/* malformed and oversized arrays are still rejected */
+	parse_extarr("(6, 1, 3, 1, 2-3, 4)");
+	parse_extarr("(6, 1, 3, 1, 2, 3, 4)");
+	parse_extarr("(6, 1, 3, 1, 2, .)");
+
+	/* every value of a large, pseudo-random array must survive a round trip */
+	rvals = (double *) malloc(n * sizeof(double));
+	srand(1);
+	for (i = 0; i < n; i++)
+	{
+		uint64_t bits = ((uint64_t) rand() << 42) ^ ((uint64_t) rand() << 21) ^ (uint64_t) rand();
+		memcpy(&rvals[i], &bits, sizeof(double));
+		if (isnan(rvals[i]) || isinf(rvals[i]))
+			rvals[i] = i * 0.001;
+		if (i % 3 == 0)
+			rvals[i] = (rand() % 100000) / 1000.0;
+	}
+	arr = json_object_new_extarr(rvals, json_extarr_type_flt64, 1, &n, JSON_C_EXTARR_DONT_FREE);
+	back = json_tokener_parse(json_object_to_json_string_ext(arr, JSON_C_TO_STRING_PLAIN));
+	for (i = 0; back && i < n; i++)
+		if (memcmp(&rvals[i], (double const *) json_object_extarr_data(back) + i, sizeof(double)))
+			nbad++;
+	printf("round trip of %d doubles: %s, %d mismatches\n", n, back ? "parsed" : "error", nbad);
+	json_object_put(arr);
+	json_object_put(back);
+	free(rvals);
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+/* Formatting of extarr values. Doubles are printed with the fewest digits
+   that parse back to the identical value. */
+
+static void print_extarr(void const *data, enum json_extarr_type etype, int n)
+{
+	json_object *arr = json_object_new_extarr(data, etype, 1, &n, JSON_C_EXTARR_DONT_FREE);
+	printf("%s\n", json_object_to_json_string_ext(arr, JSON_C_TO_STRING_PLAIN));
+	json_object_put(arr);
+}
+
+int main(int argc, char **argv)
+{
+	double dvals[] = {0.0, -0.0, 1.0, -1.0, 0.1, 0.3, 1.0/3, 2.0/3, 100.0, 1.5e-3,
+	                  1e-4, 1e-5, 123456.789, 1e16, 1e17, 1.2345e21, 9007199254740993.0,
+	                  5e-324, 2.2250738585072014e-308, 1.7976931348623157e308,
+	                  NAN, INFINITY, -INFINITY};
+	float fvals[] = {0.0f, 0.1f, 1.5f, -2.25f, 3.4028235e38f};
+	int ivals[] = {0, 1, -1, 42, 2147483647, -2147483647-1};
+	int64_t lvals[] = {0, -1, 1234567890123LL, INT64_MAX, INT64_MIN};
+	unsigned char bvals[] = {0, 7, 128, 255};
+	int i, n = 10000, nbad = 0;
+	double *rvals;
+	json_object *arr;
+	char const *str, *p;
+
+	print_extarr(dvals, json_extarr_type_flt64, sizeof(dvals)/sizeof(dvals[0]));
+	print_extarr(fvals, json_extarr_type_flt32, sizeof(fvals)/sizeof(fvals[0]));
+	print_extarr(ivals, json_extarr_type_int32, sizeof(ivals)/sizeof(ivals[0]));
+	print_extarr(lvals, json_extarr_type_int64, sizeof(lvals)/sizeof(lvals[0]));
+	print_extarr(bvals, json_extarr_type_byt08, sizeof(bvals)/sizeof(bvals[0]));
+
+	/* pretty printing of a small 2D array */
+	{
+		int dims[2] = {2, 2};
+		double d4[4] = {0.5, 1.25, -3.0, 1e-7};
+		arr = json_object_new_extarr(d4, json_extarr_type_flt64, 2, dims, JSON_C_EXTARR_DONT_FREE);
+		printf("%s\n", json_object_to_json_string_ext(arr, JSON_C_TO_STRING_PRETTY));
+		json_object_put(arr);
+	}
+
+	/* every value of a large, pseudo-random array must round trip exactly */
+	rvals = (double *) malloc(n * sizeof(double));
+	srand(1);
+	for (i = 0; i < n; i++)
+	{
+		uint64_t bits = ((uint64_t) rand() << 42) ^ ((uint64_t) rand() << 21) ^ (uint64_t) rand();
+		memcpy(&rvals[i], &bits, sizeof(bits));
+		if (isnan(rvals[i]) || isinf(rvals[i]))
+			rvals[i] = (double) rand() / RAND_MAX;
+	}
+	arr = json_object_new_extarr(rvals, json_extarr_type_flt64, 1, &n, JSON_C_EXTARR_DONT_FREE);
+	str = json_object_to_json_string_ext(arr, JSON_C_TO_STRING_PLAIN);
+	p = strchr(str, ',') + 1;
+	p = strchr(p, ',') + 1;
+	p = strchr(p, ',') + 1;
+	for (i = 0; i < n; i++)
+	{
+		char *end;
+		double d = strtod(p, &end);
+		if (memcmp(&d, &rvals[i], sizeof(d)))
+			nbad++;
+		p = end + 1;
+	}
+	printf("round trip of %d random doubles: %d mismatches\n", n, nbad);
+	json_object_put(arr);
+	free(rvals);
+
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+/* Cached sizes from json_object_object_nbytes() track changes made anywhere
+   below an object, including through members shared by several objects. */
+
+/* json_object_object_nbytes() in false mode, without any caching */
+static int64_t payload(json_object *obj)
+{
+	int64_t n = 0;
+	int i;
+
+	switch (json_object_get_type(obj))
+	{
+		case json_type_null: return 0;
+		case json_type_boolean: return sizeof(json_bool);
+		case json_type_int: return sizeof(int64_t);
+		case json_type_double: return sizeof(double);
+		case json_type_string: return json_object_get_string_len(obj);
+		case json_type_extarr: return json_object_extarr_nbytes(obj);
+		case json_type_enum: return sizeof(int64_t);
+		case json_type_array:
+			for (i = 0; i < json_object_array_length(obj); i++)
+				n += payload(json_object_array_get_idx(obj, i));
+			return n;
+		case json_type_object:
+		{
+			struct json_object_iter iter;
+			json_object_object_foreachC(obj, iter)
+				n += payload(iter.val);
+			return n;
+		}
+	}
+	return 0;
+}
+
+static void check(char const *what, json_object *obj)
+{
+	int64_t cached = json_object_payload_nbytes(obj);
+	printf("%-28s %6lld %s\n", what, (long long) cached,
+		cached == payload(obj) ? "ok" : "STALE");
+}
+
+static json_object *member(json_object *obj, char const *key)
+{
+	json_object *val = 0;
+	json_object_object_get_ex(obj, key, &val);
+	return val;
+}
+
+int main(int argc, char **argv)
+{
+	json_object *top = json_tokener_parse(
+		"{ \"clargs\": { \"interface\": \"miftmpl\", \"part_size\": 80000 },"
+		"  \"parts\": [ { \"Mesh\": { \"ChunkID\": 0, \"name\": \"mesh\" } },"
+		"               { \"Mesh\": { \"ChunkID\": 1, \"name\": \"mesh\" } } ] }");
+	json_object *parts = member(top, "parts");
+	json_object *mesh = member(json_object_array_get_idx(parts, 1), "Mesh");
+	json_object *shared = json_object_new_string("shared");
+	json_object *other = json_object_new_object();
+	json_object *orphan, *en, *small;
+	int64_t with_keys, hdr;
+
+	check("parsed", top);
+	json_object_object_add(mesh, "extra", json_object_new_double(1.5));
+	check("member added deep", top);
+	json_object_set_string(member(mesh, "name"), "a much longer mesh name");
+	check("string set deep", top);
+	json_object_object_del(mesh, "extra");
+	check("member deleted deep", top);
+	json_object_object_add(mesh, "name", json_object_new_int(3));
+	check("member replaced deep", top);
+	json_object_array_put_idx(parts, 0, json_object_new_string("gone"));
+	check("array element replaced", top);
+	json_object_array_add(parts, json_object_new_boolean(1));
+	check("array element added", top);
+
+	/* a member shared with another hierarchy */
+	json_object_object_add(mesh, "shared", json_object_get(shared));
+	json_object_object_add(other, "shared", shared);
+	check("shared added", top);
+	check("other", other);
+	json_object_set_string(shared, "shared, now longer");
+	check("shared set", top);
+	check("other after shared set", other);
+
+	/* a member outliving its container */
+	orphan = json_object_get(member(mesh, "ChunkID"));
+	json_object_object_del(json_object_array_get_idx(parts, 1), "Mesh");
+	check("container deleted", top);
+	json_object_set_int(orphan, 7);
+	json_object_put(orphan);
+
+	en = json_object_new_enum();
+	json_object_enum_add(en, "red", 0, JSON_C_TRUE);
+	json_object_object_add(top, "color", en);
+	with_keys = json_object_object_nbytes(top, JSON_C_TRUE);
+	json_object_enum_add(en, "blue", 1, JSON_C_FALSE);
+	printf("enum choice added: %s\n",
+		json_object_object_nbytes(top, JSON_C_TRUE) == with_keys + (int64_t)(strlen("blue") + sizeof(int64_t)) ? "ok" : "STALE");
+
+	/* overhead counted by hand: a header per object, of which null has none, and
+	   the bytes of the keys, with the header size taken from a lone int */
+	orphan = json_object_new_int(0);
+	hdr = json_object_object_nbytes(orphan, JSON_C_TRUE) - (int64_t) sizeof(int64_t);
+	json_object_put(orphan);
+	small = json_tokener_parse("{ \"ab\": 1, \"list\": [ 2.5, \"xyz\" ], \"c\": null }");
+	printf("overhead: %s\n", json_object_overhead_nbytes(small) == 5 * hdr + 7 ? "ok" : "wrong");
+	json_object_object_add(small, "d", json_object_new_boolean(1));
+	printf("overhead after add: %s\n", json_object_overhead_nbytes(small) == 6 * hdr + 8 ? "ok" : "wrong");
+	json_object_put(small);
+
+	json_object_put(other);
+	json_object_put(top);
+	return 0;
+}
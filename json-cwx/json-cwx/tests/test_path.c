@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+/* Compiled path queries find the same objects as apath queries except where
+   apath mishandles a leading or repeated slash, an empty path or a non-numeric
+   component applied to an array. */
+
+static char const *paths[] = {
+	"clargs/part_size",
+	"/clargs/part_size",
+	"clargs//interface/",
+	"clargs/file",
+	"parts/1/Mesh/ChunkID",
+	"parts/1/Mesh/LogDims/2",
+	"parts/7/Mesh/ChunkID",
+	"parts/x/Mesh",
+	"counts/16",
+	"clargs/flag",
+	"clargs/avg_num_parts",
+	"clargs/missing",
+	"clargs/part_size/deeper",
+	"",
+	0
+};
+
+int main(int argc, char **argv)
+{
+	json_object *obj = json_tokener_parse(
+	    "{ \"clargs\": { \"part_size\": 80000, \"interface\": \"miftmpl\","
+	    "              \"file\": \"out/dir/base\", \"flag\": true, \"avg_num_parts\": 2.5 },"
+	    "  \"parts\": [ { \"Mesh\": { \"ChunkID\": 3, \"LogDims\": [4, 5, 6] } },"
+	    "               { \"Mesh\": { \"ChunkID\": 8, \"LogDims\": [7, 8, 9] } } ],"
+	    "  \"counts\": { \"16\": 42 } }");
+	int i;
+
+	for (i = 0; paths[i]; i++)
+	{
+		struct json_path *path = json_path_compile(paths[i]);
+		json_object *found = json_path_get_object(obj, path);
+
+		printf("\"%s\": %s int=%d int64=%lld dbl=%g bool=%d str=%s\n", paths[i],
+		    found == json_object_apath_get_object(obj, paths[i]) ? "same" : "differs",
+		    json_path_get_int(obj, path), (long long) json_path_get_int64(obj, path),
+		    json_path_get_double(obj, path), (int) json_path_get_boolean(obj, path),
+		    found == obj ? "(root)" : json_path_get_string(obj, path));
+		json_path_free(path);
+	}
+
+	/* strings are returned unescaped */
+	{
+		struct json_path *path = json_path_compile("clargs/file");
+		printf("apath: %s, compiled: %s\n",
+		    json_object_apath_get_string(obj, "clargs/file"), json_path_get_string(obj, path));
+		json_path_free(path);
+	}
+
+	json_object_apath_get_string(0, 0);
+	json_object_put(obj);
+	return 0;
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "printbuf.h"
+
+/* Streaming serialization must produce exactly what the string
+   serializer does, in chunks of bounded size. */
+
+struct collect {
+	struct printbuf *pb;
+	int nchunks;
+	size_t maxlen;
+	int fail_at;
+};
+
+static int collect_sink(void *data, const char *buf, size_t len)
+{
+	struct collect *c = (struct collect *) data;
+	c->nchunks++;
+	if (len > c->maxlen)
+		c->maxlen = len;
+	if (c->fail_at && c->nchunks == c->fail_at)
+		return 7;
+	printbuf_memappend(c->pb, buf, (int) len);
+	return 0;
+}
+
+static void check(const char *name, json_object *obj, int flags)
+{
+	struct collect c = {printbuf_new(), 0, 0, 0};
+	int ret = json_object_to_json_sink(obj, flags, collect_sink, &c);
+	const char *str = json_object_to_json_string_ext(obj, flags);
+
+	printf("%s: ret=%d match=%d multichunk=%d bounded=%d\n", name, ret,
+	       strcmp(str, c.pb->buf) == 0, c.nchunks > 1,
+	       c.maxlen < 2 * JSON_C_SINK_CHUNK);
+	printbuf_free(c.pb);
+}
+
+int main(int argc, char **argv)
+{
+	json_object *small, *big, *arr;
+	int i, n = 100000, fds[2];
+	double *vals;
+	char buf[64];
+	ssize_t len;
+
+	small = json_tokener_parse("{ \"a\": [1, 2.5, \"x\\/y\"], \"b\": { \"c\": null } }");
+	check("small plain", small, JSON_C_TO_STRING_PLAIN);
+	check("small pretty", small, JSON_C_TO_STRING_PRETTY);
+
+	big = json_object_new_object();
+	vals = (double *) malloc(n * sizeof(double));
+	for (i = 0; i < n; i++)
+		vals[i] = i / 7.0;
+	json_object_object_add(big, "extarr",
+	    json_object_new_extarr(vals, json_extarr_type_flt64, 1, &n, 0));
+	arr = json_object_new_array();
+	for (i = 0; i < 20000; i++)
+		json_object_array_add(arr, json_object_new_int(i));
+	json_object_object_add(big, "array", arr);
+	check("big plain", big, JSON_C_TO_STRING_PLAIN);
+	check("big pretty", big, JSON_C_TO_STRING_PRETTY);
+
+	/* the first sink error stops output and is returned */
+	{
+		struct collect c = {printbuf_new(), 0, 0, 2};
+		int ret = json_object_to_json_sink(big, JSON_C_TO_STRING_PLAIN, collect_sink, &c);
+		printf("sink error: ret=%d chunks=%d\n", ret, c.nchunks);
+		printbuf_free(c.pb);
+	}
+
+	{
+		struct collect c = {printbuf_new(), 0, 0, 0};
+		int ret = json_object_to_json_sink(NULL, 0, collect_sink, &c);
+		printf("null: ret=%d %s\n", ret, c.pb->buf);
+		printbuf_free(c.pb);
+	}
+
+	/* json_object_to_fd */
+	if (pipe(fds) == 0)
+	{
+		printf("to_fd: ret=%d\n", json_object_to_fd(fds[1], small, JSON_C_TO_STRING_PLAIN));
+		close(fds[1]);
+		len = read(fds[0], buf, sizeof(buf) - 1);
+		buf[len > 0 ? len : 0] = '\0';
+		printf("to_fd: %s\n", buf);
+		close(fds[0]);
+	}
+
+	json_object_put(small);
+	json_object_put(big);
+	return 0;
+}
@@ -859,26 +859,163 @@ make_scalar_var(int ndims, int const *dims, double const *bounds,
 
 }
 
+/* Vector components and symmetric tensor components, in order, for 1, 2 and 3
+   spatial dimensions */
+static char const *vector_comp_names[3] = {"x","y","z"};
+static char const *tensor_comp_names[3][6] = {
+    {"xx"},
+    {"xx","yy","xy"},
+    {"xx","yy","zz","xy","yz","xz"}};
+static int const tensor_comp_idx[3][6][2] = {
+    {{0,0}},
+    {{0,0},{1,1},{0,1}},
+    {{0,0},{1,1},{2,2},{0,1},{1,2},{0,2}}};
+
+/* A vector or tensor var is a single extarr holding all of its components.
+   With the aos layout, the components of each node (or zone) are interleaved
+   and the component count is the extarr's first (fastest varying) dimension.
+   With the soa layout, each component is contiguous and the component count is
+   the extarr's last (slowest varying) dimension. */
 static json_object *
-make_vector_var(int ndims, int const *dims, double const *bounds)
+make_multicomp_var(int ndims, int const *dims, double const *bounds,
+    char const *centering, char const *type, char const *layout, char const *name)
 {
-    return 0;
+    json_object *var_obj = json_object_new_object();
+    json_object *comps_obj = json_object_new_array();
+    json_object *data_obj;
+    int i,j,k,c,n;
+    int dims2[3] = {1,1,1};
+    int data_dims[4];
+    int minus_one = strcmp(centering, "zone")?0:-1;
+    int is_vector = !strcmp(type, "vector");
+    int aos = !strcmp(layout, "aos");
+    int ncomps = is_vector ? ndims : ndims * (ndims + 1) / 2;
+    int nvals = 1;
+    double *vals;
+
+    for (i = 0; i < ndims; i++)
+    {
+        dims2[i] = dims[i] + minus_one;
+        data_dims[aos ? i + 1 : i] = dims2[i];
+        nvals *= dims2[i];
+    }
+    data_dims[aos ? 0 : ndims] = ncomps;
+    for (c = 0; c < ncomps; c++)
+    {
+        char const *comp_name = is_vector ? vector_comp_names[c] : tensor_comp_names[ndims-1][c];
+        json_object_array_add(comps_obj, json_object_new_string(comp_name));
+    }
+
+    json_object_object_add(var_obj, "name", json_object_new_string(name));
+    json_object_object_add(var_obj, "type", json_object_new_string(type));
+    json_object_object_add(var_obj, "centering", json_object_new_string(centering));
+    json_object_object_add(var_obj, "layout", json_object_new_string(layout));
+    json_object_object_add(var_obj, "components", comps_obj);
+    data_obj = json_object_new_extarr_alloc(json_extarr_type_flt64, ndims + 1, data_dims, 0);
+    json_object_object_add(var_obj, "data", data_obj);
+    vals = (double *) json_object_extarr_data(data_obj);
+
+    n = 0;
+    for (k = 0; k < dims2[2]; k++)
+    {
+        for (j = 0; j < dims2[1]; j++)
+        {
+            for (i = 0; i < dims2[0]; i++)
+            {
+                double p[3];
+                p[0] = bounds[0] + i * MACSIO_UTILS_XDelta(dims, bounds);
+                p[1] = bounds[1] + j * MACSIO_UTILS_YDelta(dims, bounds);
+                p[2] = bounds[2] + k * MACSIO_UTILS_ZDelta(dims, bounds);
+                for (c = 0; c < ncomps; c++)
+                {
+                    double v;
+                    if (is_vector) /* a swirl about the z axis */
+                        v = c == 0 ? -p[1] : c == 1 ? p[0] : p[2];
+                    else           /* an isotropic pressure plus a shear that grows outward */
+                    {
+                        int a = tensor_comp_idx[ndims-1][c][0];
+                        int b = tensor_comp_idx[ndims-1][c][1];
+                        v = p[a] * p[b] + (a == b ? 1.0 : 0.0);
+                    }
+                    vals[aos ? n * ncomps + c : c * nvals + n] = v;
+                }
+                n++;
+            }
+        }
+    }
+
+    return var_obj;
 }
 
 static json_object *
-make_tensor_var(int ndims, int const *dims, double const *bounds)
+make_vector_var(int ndims, int const *dims, double const *bounds,
+    char const *layout, char const *name)
 {
-    return 0;
+    return make_multicomp_var(ndims, dims, bounds, "node", "vector", layout, name);
 }
 
 static json_object *
-make_subset_var(int ndims, int const *dims, double const *bounds)
+make_tensor_var(int ndims, int const *dims, double const *bounds,
+    char const *layout, char const *name)
 {
-    return 0;
+    return make_multicomp_var(ndims, dims, bounds, "zone", "tensor", layout, name);
 }
 
+/* A subset var is a zonal scalar defined on only some of the zones, here every
+   third layer of 20 zones in x like the material layers of the xlayers var.
+   The "subset" extarr holds the indices of those zones and "data" holds one
+   value for each. */
 static json_object *
-make_mesh_vars(int ndims, int const *dims, double const *bounds, int nvars)
+make_subset_var(int ndims, int const *dims, double const *bounds, char const *name)
+{
+    json_object *var_obj = json_object_new_object();
+    json_object *subset_obj, *data_obj;
+    int i,j,k,n,nzones;
+    int dims2[3] = {1,1,1};
+    int *ids;
+    double *vals;
+
+    for (i = 0; i < ndims; i++)
+        dims2[i] = dims[i] - 1;
+    for (i = 0, nzones = 0; i < dims2[0]; i++)
+    {
+        if ((i / 20) % 3 == 0)
+            nzones++;
+    }
+    nzones *= dims2[1] * dims2[2];
+
+    json_object_object_add(var_obj, "name", json_object_new_string(name));
+    json_object_object_add(var_obj, "type", json_object_new_string("subset"));
+    json_object_object_add(var_obj, "centering", json_object_new_string("zone"));
+    subset_obj = json_object_new_extarr_alloc(json_extarr_type_int32, 1, &nzones, 0);
+    data_obj = json_object_new_extarr_alloc(json_extarr_type_flt64, 1, &nzones, 0);
+    json_object_object_add(var_obj, "subset", subset_obj);
+    json_object_object_add(var_obj, "data", data_obj);
+    ids = (int *) json_object_extarr_data(subset_obj);
+    vals = (double *) json_object_extarr_data(data_obj);
+
+    n = 0;
+    for (k = 0; k < dims2[2]; k++)
+    {
+        for (j = 0; j < dims2[1]; j++)
+        {
+            for (i = 0; i < dims2[0]; i++)
+            {
+                double x = bounds[0] + i * MACSIO_UTILS_XDelta(dims, bounds);
+                double y = bounds[1] + j * MACSIO_UTILS_YDelta(dims, bounds);
+                double z = bounds[2] + k * MACSIO_UTILS_ZDelta(dims, bounds);
+                if ((i / 20) % 3) continue;
+                ids[n] = MU_SeqIdx3(i,j,k,dims2[0],dims2[1]);
+                vals[n++] = sqrt(x*x+y*y+z*z);
+            }
+        }
+    }
+
+    return var_obj;
+}
+
+static json_object *
+make_mesh_vars(int ndims, int const *dims, double const *bounds, json_object *main_obj)
 {
     json_object *vars_array = json_object_new_array();
     char const *centering_names[2] = {"zone", "node"};
@@ -886,6 +1023,12 @@ make_mesh_vars(int ndims, int const *dims, double const *bounds, int nvars)
     int const centerings[] = {0,0,0,1,1,1,1,0};
     int const types[] = {0,0,0,0,0,0,0,1};
     char const *var_names[] = {"constant","random","spherical","xramp","ysin","noise","noise_sum","xlayers"};
+    int nvars = json_object_path_get_int(main_obj, "clargs/vars_per_part");
+    int nvectors = json_object_path_get_int(main_obj, "clargs/vector_vars");
+    int ntensors = json_object_path_get_int(main_obj, "clargs/tensor_vars");
+    int nsubsets = json_object_path_get_int(main_obj, "clargs/subset_vars");
+    char const *layout = json_object_path_get_string(main_obj, "clargs/var_layout");
+    char tmpname[32];
     int i;
 
     /* for now, just hack and cycle through possible combinations */
@@ -895,21 +1038,49 @@ make_mesh_vars(int ndims, int const *dims, double const *bounds, int nvars)
         char const *centering = centering_names[centerings[mod8]];
         char const *type = type_names[types[mod8]];
         char const *name = var_names[mod8];
-        char tmpname[32];
+        json_object *var_obj;
 
         if (i < 8)
             snprintf(tmpname, sizeof(tmpname), "%s", name);
         else
             snprintf(tmpname, sizeof(tmpname), "%s_%03d", name, (i-8)/8);
 
-        json_object_array_add(vars_array, make_scalar_var(ndims, dims, bounds, centering, type, tmpname));
+        var_obj = make_scalar_var(ndims, dims, bounds, centering, type, tmpname);
+        json_object_object_add(var_obj, "type", json_object_new_string("scalar"));
+        json_object_array_add(vars_array, var_obj);
+    }
+
+    for (i = 0; i < nvectors; i++)
+    {
+        if (i == 0)
+            snprintf(tmpname, sizeof(tmpname), "velocity");
+        else
+            snprintf(tmpname, sizeof(tmpname), "velocity_%03d", i-1);
+        json_object_array_add(vars_array, make_vector_var(ndims, dims, bounds, layout, tmpname));
+    }
+    for (i = 0; i < ntensors; i++)
+    {
+        if (i == 0)
+            snprintf(tmpname, sizeof(tmpname), "stress");
+        else
+            snprintf(tmpname, sizeof(tmpname), "stress_%03d", i-1);
+        json_object_array_add(vars_array, make_tensor_var(ndims, dims, bounds, layout, tmpname));
     }
+    for (i = 0; i < nsubsets; i++)
+    {
+        if (i == 0)
+            snprintf(tmpname, sizeof(tmpname), "layer_density");
+        else
+            snprintf(tmpname, sizeof(tmpname), "layer_density_%03d", i-1);
+        json_object_array_add(vars_array, make_subset_var(ndims, dims, bounds, tmpname));
+    }
+
     return vars_array;
 }
 
 #warning UNIFY PART CHUNK TERMINOLOGY THEY ARE THE SAME
 #warning SHOULD NAME CHUNK/PART NUMBER HERE TO INDICATE IT IS A GLOBAL NUMBER
-static json_object *make_uniform_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, int nvars)
+static json_object *make_uniform_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, json_object *main_obj)
 {
     json_object *chunk_obj = json_object_new_object();
     json_object *mesh_obj = json_object_new_object();
@@ -922,12 +1093,12 @@ static json_object *make_uniform_mesh_chunk(int chunkId, int ndims, int const *d
     json_object_object_add(mesh_obj, "Coords", make_uniform_mesh_coords(ndims, dims, bounds));
     json_object_object_add(mesh_obj, "Topology", make_uniform_mesh_topology(ndims, dims));
     json_object_object_add(chunk_obj, "Mesh", mesh_obj);
-    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, nvars));
+    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, main_obj));
     return chunk_obj;
 }
 
 #warning ADD CALLS TO VARGEN FOR OTHER MESH TYPES
-static json_object *make_rect_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, int nvars)
+static json_object *make_rect_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, json_object *main_obj)
 {
     json_object *chunk_obj = json_object_new_object();
     json_object *mesh_obj = json_object_new_object();
@@ -941,11 +1112,11 @@ static json_object *make_rect_mesh_chunk(int chunkId, int ndims, int const *dims
     json_object_object_add(mesh_obj, "Topology", make_rect_mesh_topology(ndims, dims));
     json_object_object_add(chunk_obj, "Mesh", mesh_obj);
 #warning ADD NVARS AND VARMAPS ARGS HERE
-    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, nvars));
+    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, main_obj));
     return chunk_obj;
 }
 
-static json_object *make_curv_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, int nvars)
+static json_object *make_curv_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, json_object *main_obj)
 {
     json_object *chunk_obj = json_object_new_object();
     json_object *mesh_obj = json_object_new_object();
@@ -959,11 +1130,11 @@ static json_object *make_curv_mesh_chunk(int chunkId, int ndims, int const *dims
     json_object_object_add(mesh_obj, "Topology", make_curv_mesh_topology(ndims, dims));
     json_object_object_add(chunk_obj, "Mesh", mesh_obj);
 #warning ADD NVARS AND VARMAPS ARGS HERE
-    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, nvars));
+    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, main_obj));
     return chunk_obj;
 }
 
-static json_object *make_ucdzoo_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, int nvars)
+static json_object *make_ucdzoo_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, json_object *main_obj)
 {
     json_object *chunk_obj = json_object_new_object();
     json_object *mesh_obj = json_object_new_object();
@@ -976,11 +1147,11 @@ static json_object *make_ucdzoo_mesh_chunk(int chunkId, int ndims, int const *di
     json_object_object_add(mesh_obj, "Coords", make_ucdzoo_mesh_coords(ndims, dims, bounds));
     json_object_object_add(mesh_obj, "Topology", make_ucdzoo_mesh_topology(ndims, dims));
     json_object_object_add(chunk_obj, "Mesh", mesh_obj);
-    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, nvars));
+    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, main_obj));
     return chunk_obj;
 }
 
-static json_object *make_arb_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, int nvars)
+static json_object *make_arb_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, json_object *main_obj)
 {
     json_object *chunk_obj = json_object_new_object();
     json_object *mesh_obj = json_object_new_object();
@@ -993,25 +1164,25 @@ static json_object *make_arb_mesh_chunk(int chunkId, int ndims, int const *dims,
     json_object_object_add(mesh_obj, "Coords", make_arb_mesh_coords(ndims, dims, bounds));
     json_object_object_add(mesh_obj, "Topology", make_arb_mesh_topology(ndims, dims));
     json_object_object_add(chunk_obj, "Mesh", mesh_obj);
-    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, nvars));
+    json_object_object_add(chunk_obj, "Vars", make_mesh_vars(ndims, dims, bounds, main_obj));
     return chunk_obj;
 }
 
 /* dims are # nodes in x, y and z,
    bounds are xmin,ymin,zmin,xmax,ymax,zmax */
 static json_object *
-make_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, char const *type, int nvars)
+make_mesh_chunk(int chunkId, int ndims, int const *dims, double const *bounds, char const *type, json_object *main_obj)
 {
          if (!strncasecmp(type, "uniform", sizeof("uniform")))
-        return make_uniform_mesh_chunk(chunkId, ndims, dims, bounds, nvars);
+        return make_uniform_mesh_chunk(chunkId, ndims, dims, bounds, main_obj);
     else if (!strncasecmp(type, "rectilinear", sizeof("rectilinear")))
-        return make_rect_mesh_chunk(chunkId, ndims, dims, bounds, nvars);
+        return make_rect_mesh_chunk(chunkId, ndims, dims, bounds, main_obj);
     else if (!strncasecmp(type, "curvilinear", sizeof("curvilinear")))
-        return make_curv_mesh_chunk(chunkId, ndims, dims, bounds, nvars);
+        return make_curv_mesh_chunk(chunkId, ndims, dims, bounds, main_obj);
     else if (!strncasecmp(type, "unstructured", sizeof("unstructured")))
-        return make_ucdzoo_mesh_chunk(chunkId, ndims, dims, bounds, nvars);
+        return make_ucdzoo_mesh_chunk(chunkId, ndims, dims, bounds, main_obj);
     else if (!strncasecmp(type, "arbitrary", sizeof("arbitrary")))
-        return make_arb_mesh_chunk(chunkId, ndims, dims, bounds, nvars);
+        return make_arb_mesh_chunk(chunkId, ndims, dims, bounds, main_obj);
     return 0;
 }
 
@@ -1065,7 +1236,7 @@ MACSIO_DATA_GenerateTimeZeroDumpObject(json_object *main_obj, int *rank_owning_c
     int part_size = json_object_path_get_int(main_obj, "clargs/part_size") / sizeof(double);
     double avg_num_parts = json_object_path_get_double(main_obj, "clargs/avg_num_parts");
     int dim = json_object_path_get_int(main_obj, "clargs/part_dim");
-    int vars_per_part = json_object_path_get_int(main_obj, "clargs/vars_per_part");
+    char const *part_type = json_object_path_get_string(main_obj, "clargs/part_type");
     double total_num_parts_d = size * avg_num_parts;
     int total_num_parts = (int) lround(total_num_parts_d);
     int myrank = json_object_path_get_int(main_obj, "parallel/mpi_rank");
@@ -1133,7 +1304,7 @@ MACSIO_DATA_GenerateTimeZeroDumpObject(json_object *main_obj, int *rank_owning_c
                     MACSIO_UTILS_SetBounds(part_bounds, (double) ipart, (double) jpart, (double) kpart,
                         (double) ipart+ipart_width, (double) jpart+jpart_width, (double) kpart+kpart_width);
                     json_object *part_obj = make_mesh_chunk(chunk, dim, part_dims, part_bounds,
-                        json_object_path_get_string(main_obj, "clargs/part_type"), vars_per_part);
+                        part_type, main_obj);
                     MACSIO_UTILS_SetDims(global_indices, ipart, jpart, kpart);
 #warning MAYBE MOVE GLOBAL LOG INDICES TO make_mesh_chunk
 #warning GlogalLogIndices MAY NOT BE NEEDED
@@ -29,8 +29,10 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <macsio_log.h>
@@ -42,6 +44,10 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 
 int                     mpi_errno = MPI_SUCCESS;
 int                     MACSIO_LOG_DebugLevel = 0;
+int                     MACSIO_LOG_UseMPIIO = 0;
+#ifdef HAVE_MPI
+MPI_Info                MACSIO_LOG_MPIInfo = MPI_INFO_NULL;
+#endif
 MACSIO_LOG_LogHandle_t *MACSIO_LOG_MainLog = 0;
 MACSIO_LOG_LogHandle_t *MACSIO_LOG_StdErr = 0;
 
@@ -64,9 +70,20 @@ typedef struct _MACSIO_LOG_LogHandle_t
     int log_line_length;      /**< Maximum length of a message line in the log file */
     int lines_per_proc;       /**< Number of message lines allocated in the file for each processor */
     int extra_lines_proc0;    /**< Additional number of message lines for processor with MPI rank 0 */
+    int ring_size;            /**< Number of formatted lines the ring can hold before it is flushed */
+    char *ring;               /**< Preallocated buffer of ring_size lines of log_line_length chars */
+    off_t *ring_offsets;      /**< File offset at which each line in the ring is to be written */
+    struct iovec *ring_iov;   /**< Preallocated iovecs used to flush the ring */
+    char *region;             /**< In MPI-IO mode, in-memory copy of this processor's group of lines */
+    int region_size;          /**< Size, in chars, of region */
+    off_t region_offset;      /**< Offset in the file of this processor's group of lines */
+#ifdef HAVE_MPI
+    MPI_File mpifile;         /**< In MPI-IO mode, the log file handle */
+#endif
 #warning FIX USE OF MUTABLE HERE
     mutable int current_line; /**< Index into this processor's group of lines in the log file at
                                    which the next message will be written */
+    mutable int ring_count;   /**< Number of lines currently held in the ring */
     mutable log_flags_t flags; /**< Informational flags regarding the log */
 } MACSIO_LOG_LogHandle_t;
 
@@ -74,6 +91,8 @@ typedef struct _MACSIO_LOG_LogHandle_t
 \brief Internal convenience method to build a message from a printf-style format string and args.
 
 This method is public only because it is used within the \c MACSIO_LOG_MSG convenience macro.
+The returned string is held in a thread-local buffer and is valid until the next call from
+the same thread.
 */
 char const *
 MACSIO_LOG_MakeMsg(
@@ -81,27 +100,31 @@ MACSIO_LOG_MakeMsg(
     ...                 /**< [in] Optional, variable length set of arguments for format to be printed out. */
 )
 {
-#warning MAKE THIS THREAD SAFE BY ALLOCATING THE RETURNED STRING OR USE A LARGE CIRCULAR BUFFER
-  static char error_buffer[1024];
-  static int error_buffer_ptr = 0;
-  size_t L,Lmax;
-  char   tmp[sizeof(error_buffer)];
+  static __thread char error_buffer[1024];
   va_list ptr;
 
   va_start(ptr, format);
-
-  vsprintf(tmp, format, ptr);
-  L    = strlen(tmp);
-  Lmax = sizeof(error_buffer) - error_buffer_ptr - 1;
-  if (Lmax < L)
-     tmp[Lmax-1] = '\0';
-  strcpy(error_buffer + error_buffer_ptr,tmp);
-
+  vsnprintf(error_buffer, sizeof(error_buffer), format, ptr);
   va_end(ptr);
 
   return error_buffer;
 }
 
+/* Fill buf with this processor's group of lines as rank 0 would prime them in the file */
+static void
+init_region(char *buf, int rank, int nlines, int line_len)
+{
+    int i;
+    char tmp[32];
+
+    memset(buf, '-', line_len * sizeof(char));
+    memset(buf+line_len, ' ', line_len * (nlines - 1) * sizeof(char));
+    for (i = 0; i < nlines; i++)
+        buf[(i+1)*line_len-1] = '\n';
+    sprintf(tmp, "Processor %06d", rank);
+    memcpy(buf+line_len/2-strlen(tmp)/2, tmp, strlen(tmp));
+}
+
 /*!
 \brief Initialize a log
 
@@ -122,21 +145,63 @@ MACSIO_LOG_LogInit(
     int extra_lines_proc0 /**< [in] The number of extra message lines for processor rank 0 */
 )
 {
-    int rank=0, size=1;
+    int rank=0, size=1, use_mpiio = 0;
     MACSIO_LOG_LogHandle_t *retval;
 
     if (line_len <= 0) line_len = MACSIO_LOG_DEFAULT_LINE_LENGTH;
     if (lines_per_proc <= 0) lines_per_proc = MACSIO_LOG_DEFAULT_LINE_COUNT;
     if (extra_lines_proc0 <= 0) extra_lines_proc0 = MACSIO_LOG_DEFAULT_EXTRA_LINES;
 
+    retval = (MACSIO_LOG_LogHandle_t *) malloc(sizeof(MACSIO_LOG_LogHandle_t));
+    retval->region = 0;
+    retval->region_size = 0;
+    retval->region_offset = 0;
+
 #ifdef HAVE_MPI
     MPI_Comm_size(comm, &size);
     MPI_Comm_rank(comm, &rank);
+
+    /* In MPI-IO mode, each processor builds its own group of lines in memory and
+       they are written collectively at finalization. Nothing is written here. */
+    if (path && MACSIO_LOG_UseMPIIO)
+    {
+        MPI_Info info;
+
+        MPI_Info_create(&info);
+        MPI_Info_set(info, (char*) "romio_cb_write", (char*) "enable");
+        MPI_Info_set(info, (char*) "cb_config_list", (char*) "*:1"); /* one aggregator per node */
+        if (MACSIO_LOG_MPIInfo != MPI_INFO_NULL)
+        {
+            int i, nkeys, flag;
+            char key[MPI_MAX_INFO_KEY+1], val[MPI_MAX_INFO_VAL+1];
+
+            MPI_Info_get_nkeys(MACSIO_LOG_MPIInfo, &nkeys);
+            for (i = 0; i < nkeys; i++)
+            {
+                MPI_Info_get_nthkey(MACSIO_LOG_MPIInfo, i, key);
+                MPI_Info_get(MACSIO_LOG_MPIInfo, key, MPI_MAX_INFO_VAL, val, &flag);
+                if (flag)
+                    MPI_Info_set(info, key, val);
+            }
+        }
+        mpi_errno = MPI_File_open(comm, (char*) path, MPI_MODE_CREATE|MPI_MODE_WRONLY, info, &retval->mpifile);
+        MPI_Info_free(&info);
+        if (mpi_errno == MPI_SUCCESS)
+        {
+            int nlines = lines_per_proc + (rank==0?extra_lines_proc0:0);
+            use_mpiio = 1;
+            MPI_File_set_size(retval->mpifile, (MPI_Offset) line_len * (size * lines_per_proc + extra_lines_proc0));
+            retval->region_size = nlines * line_len;
+            retval->region_offset = (off_t) (rank * lines_per_proc + (rank?extra_lines_proc0:0)) * line_len;
+            retval->region = (char *) malloc(retval->region_size * sizeof(char));
+            init_region(retval->region, rank, nlines, line_len);
+        }
+    }
 #endif
 
     /* Rank 0 "primes" the log file; creates it, populates it
        with processor header lines and spaces and closes it */
-    if (path && rank == 0)
+    if (path && rank == 0 && !use_mpiio)
     {
         int i, filefd;
         char *linbuf = (char*) malloc(line_len * (lines_per_proc + extra_lines_proc0) * sizeof(char));
@@ -160,13 +225,13 @@ MACSIO_LOG_LogInit(
     }
 
 #ifdef HAVE_MPI
-    mpi_errno = MPI_Barrier(comm);
+    if (!use_mpiio)
+        mpi_errno = MPI_Barrier(comm);
 #endif
 
-    retval = (MACSIO_LOG_LogHandle_t *) malloc(sizeof(MACSIO_LOG_LogHandle_t));
     retval->pathname = path?strdup(path):0;
     retval->comm = comm;
-    retval->logfile = path?open(path, O_WRONLY):fileno(stderr);
+    retval->logfile = use_mpiio?-1:(path?open(path, O_WRONLY):fileno(stderr));
     retval->size = size;
     retval->rank = rank;
     retval->log_line_length = path?line_len:1024;
@@ -174,14 +239,77 @@ MACSIO_LOG_LogInit(
     retval->extra_lines_proc0 = path?extra_lines_proc0:0;
     retval->current_line = 1; /* never write to line '0' to preserve "Processor XXXX" headings */
     retval->flags.was_logged = 0;
+
+    /* Messages to a log file are formatted into a ring of lines and written in batches.
+       Messages to stderr are written immediately and so need only a single line. */
+    retval->ring_size = 1;
+    if (path && !use_mpiio)
+    {
+        int max_lines = lines_per_proc + (rank==0?extra_lines_proc0:0);
+        retval->ring_size = max_lines < MACSIO_LOG_FLUSH_LINE_COUNT ? max_lines : MACSIO_LOG_FLUSH_LINE_COUNT;
+    }
+    retval->ring = (char *) malloc(retval->ring_size * retval->log_line_length * sizeof(char));
+    retval->ring_offsets = (off_t *) malloc(retval->ring_size * sizeof(off_t));
+    retval->ring_iov = (struct iovec *) malloc(retval->ring_size * sizeof(struct iovec));
+    retval->ring_count = 0;
+
     errno = 0;
     return retval;
 }
 
+/*!
+\brief Write any buffered messages to the log file
+
+Lines destined for consecutive locations in the file are coalesced and written with
+a single \c pwritev(). In MPI-IO mode, the processor's whole group of lines is written
+with an independent \c MPI_File_write_at(). May be called independently by any processor.
+*/
+void
+MACSIO_LOG_LogFlush(
+    MACSIO_LOG_LogHandle_t const *log /**< [in] The handle for the specified log */
+)
+{
+    int i = 0;
+    int saved_errno = errno;
+
+#ifdef HAVE_MPI
+    if (log->region)
+    {
+        MPI_Status status;
+        MPI_File_write_at(log->mpifile, (MPI_Offset) log->region_offset, log->region,
+            log->region_size, MPI_CHAR, &status);
+        errno = saved_errno;
+        return;
+    }
+#endif
+
+    while (i < log->ring_count)
+    {
+        int n = 0;
+        off_t off = log->ring_offsets[i];
+
+        while (i+n < log->ring_count && n < IOV_MAX &&
+               log->ring_offsets[i+n] == off + (off_t) n * log->log_line_length)
+        {
+            log->ring_iov[n].iov_base = log->ring + (i+n) * log->log_line_length;
+            log->ring_iov[n].iov_len = log->log_line_length;
+            n++;
+        }
+        pwritev(log->logfile, log->ring_iov, n, off);
+        i += n;
+    }
+    log->ring_count = 0;
+    errno = saved_errno;
+}
+
 /*!
 \brief Issue a printf-style message to a log
 
 May be called independently by any processor in the communicator used to initialize the log.
+
+Messages to a log file are formatted directly into the log's preallocated ring of lines
+and are not written until the ring fills, \c MACSIO_LOG_LogFlush() is called or the log
+is finalized. No memory is allocated on this path.
 */
 void
 MACSIO_LOG_LogMsg(
@@ -190,53 +318,51 @@ MACSIO_LOG_LogMsg(
     ...                          /**< [in] Optional, variable list of arguments for the format string. */
 )
 {
-    int i = 0;
     int is_stderr = log->logfile == fileno(stderr);
-    char *msg, *buf;
+    int len = log->log_line_length;
+    int n, start;
+    char *buf, *p;
     va_list ptr;
 
-    msg = (char *) malloc(log->log_line_length+10);
-    buf = (char *) malloc(log->log_line_length+10);
+    if (log->region)
+        buf = log->region + log->current_line * len;
+    else
+    {
+        if (log->ring_count == log->ring_size)
+            MACSIO_LOG_LogFlush(log);
+        buf = log->ring + log->ring_count * len;
+    }
 
-    if (is_stderr) sprintf(msg, "%06d: ", log->rank);
+    start = is_stderr ? sprintf(buf, "%06d: ", log->rank) : 0;
     va_start(ptr, fmt);
-    vsnprintf(is_stderr?&msg[8]:msg, log->log_line_length-1, fmt, ptr);
+    n = vsnprintf(buf+start, len-1-start, fmt, ptr);
     va_end(ptr);
-    msg[log->log_line_length-1] = '\0';
+    if (n < 0) n = 0;
+    n = start + n < len-2 ? start + n : len-2;
 
-    while (i < strlen(msg) && i < log->log_line_length)
-    {
-        if (msg[i] == '\n')
-            buf[i] = '!';
-        else
-            buf[i] = msg[i];
-        i++;
-    }
-    free(msg);
-    if (is_stderr)
-    {
-        buf[i++] = '\n';
-        buf[i++] = '\0';
-    }
-    else
-    {
-        while (i < log->log_line_length)
-            buf[i++] = ' ';
-        buf[log->log_line_length-1] = '\n';
-    }
+    /* messages are restricted to one line */
+    for (p = buf; (p = (char *) memchr(p, '\n', n - (p - buf))); p++)
+        *p = '!';
 
     if (is_stderr)
     {
-        write(log->logfile, buf, sizeof(char) * strlen(buf));
+        buf[n++] = '\n';
+        write(log->logfile, buf, sizeof(char) * n);
         fflush(stderr); /* can never be sure stderr is UNbuffered */
     }
+    else if (log->region)
+    {
+        memset(buf+n, ' ', len-n);
+        buf[len-1] = '\n';
+    }
     else
     {
         int extra_lines = log->rank?log->extra_lines_proc0:0;
         off_t seek_offset = (log->rank * log->lines_per_proc + log->current_line + extra_lines) * log->log_line_length;
-        pwrite(log->logfile, buf, sizeof(char) * log->log_line_length, seek_offset);
+        memset(buf+n, ' ', len-n);
+        buf[len-1] = '\n';
+        log->ring_offsets[log->ring_count++] = seek_offset;
     }
-    free(buf);
 
     log->current_line++;
     if (log->current_line == log->lines_per_proc + (log->rank==0?log->extra_lines_proc0:0))
@@ -281,6 +407,11 @@ MACSIO_LOG_LogMsgWithDetails(
 #endif
 #warning CLEAN UP SO ONLY PRINT NON-EMPTY STRINGS
     MACSIO_LOG_LogMsg(log, "%s:%s:%s:%s:%s", _sig, _msg, _err, _mpistr, _mpicls);
+
+    /* Don't let errors sit in the ring where an abort or crash would lose them */
+    if (sevVal >= MACSIO_LOG_MsgErr)
+        MACSIO_LOG_LogFlush(log);
+
     if (sevVal == MACSIO_LOG_MsgDie)
 #ifdef HAVE_MPI
         MPI_Abort(MPI_COMM_WORLD, 0);
@@ -302,18 +433,33 @@ MACSIO_LOG_LogFinalize(
     int reduced_was_logged = was_logged;
 
 #warning ADD ATEXIT FUNCTIONALITY TO CLOSE LOGS
-    if (log->logfile != fileno(stderr))
-        close(log->logfile);
-
 #ifdef HAVE_MPI
-    MPI_Reduce(&was_logged, &reduced_was_logged, 1, MPI_INT, MPI_MAX, 0, log->comm);
+    MPI_Allreduce(&was_logged, &reduced_was_logged, 1, MPI_INT, MPI_MAX, log->comm);
+
+    if (log->region)
+    {
+        MPI_Status status;
+        if (reduced_was_logged)
+            MPI_File_write_at_all(log->mpifile, (MPI_Offset) log->region_offset, log->region,
+                log->region_size, MPI_CHAR, &status);
+        MPI_File_close(&log->mpifile);
+        free(log->region);
+        log->region = 0;
+    }
 #endif
 
+    MACSIO_LOG_LogFlush(log);
+    if (log->logfile != fileno(stderr) && log->logfile != -1)
+        close(log->logfile);
+
     /* If there was no message logged, we remove the log */
     if (log->rank == 0 && !reduced_was_logged && log->pathname)
         unlink(log->pathname);
 
     if (log->pathname) free(log->pathname);
+    free(log->ring);
+    free(log->ring_offsets);
+    free(log->ring_iov);
     free(log);
 }
 
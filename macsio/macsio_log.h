@@ -64,6 +64,15 @@ Parallelism in writing to a MACSIO_LOG file is achieved by ensuring no two proce
 to write data in overlapping regions in the file \em by using \c pwrite() to do the actual
 writes.
 
+To keep logging cheap enough to leave enabled, messages to a log file are not written one at a
+time. Each log handle preallocates a small ring of formatted lines. A message is formatted directly
+into the next free line of the ring, without any memory allocation, and the ring is written to the
+file in a batch, with one \c pwritev() per run of consecutive lines, when it fills, when
+\c MACSIO_LOG_LogFlush() is called and when the log is finalized. Messages of severity Err or Die
+cause an immediate flush so that they are not lost to a subsequent abort. Messages to the stderr log
+are always written immediately. A log handle's ring is not thread safe; a log should be used by only
+one thread at a time.
+
 MACSIO's main creates a default log, \c MACSIO_LOG_MainLog, on the \c MACSIO_MAIN_Comm. That
 log is probably the only log needed by MACSIO proper or any of its plugins. The convenience macro,
 \c MACSIO_LOG_MSG(SEV, MSG), is the only method one need to worry about to log messages to the
@@ -124,6 +133,11 @@ do{
 */
 #define MACSIO_LOG_DEFAULT_LINE_LENGTH 128
 
+/*!
+\def Maximum number of lines buffered by a log before they are written to the file
+*/
+#define MACSIO_LOG_FLUSH_LINE_COUNT 64
+
 /*!
 \def MACSIO_LOG_MSG
 \brief Convenience macro for logging a message to the main log
@@ -230,6 +244,32 @@ the appropriate debug level.
 */
 extern int                     MACSIO_LOG_DebugLevel;
 
+/*!
+\brief Integer variable to control how log files are written
+
+A non-zero value, set prior to \c MACSIO_LOG_LogInit(), causes logs subsequently created
+with a file name to be written with MPI-IO. Rank 0 then no longer primes the whole file
+with serial writes and processors do not each \c open(2) it. Instead, the file is opened
+collectively, each processor keeps its own group of lines in memory and all groups are
+written with a single collective \c MPI_File_write_at_all() (with collective buffering
+hinted to use one aggregator per node) when the log is finalized. Messages of severity
+Err or Die are also written immediately with an independent write. In this mode,
+\c MACSIO_LOG_LogFinalize() must be called collectively. If the file cannot be opened
+with MPI-IO, the log falls back to the default mode.
+*/
+extern int                     MACSIO_LOG_UseMPIIO;
+
+#ifdef HAVE_MPI
+/*!
+\brief MPI-IO hints for logs written with MPI-IO
+
+Hints, set prior to \c MACSIO_LOG_LogInit(), passed when opening logs with MPI-IO. They
+override the log's own collective buffering hints. MACSIO's main sets this from its
+\c --mpi_hints argument. The caller keeps ownership of the \c MPI_Info.
+*/
+extern MPI_Info                MACSIO_LOG_MPIInfo;
+#endif
+
 /*!
 \brief Log handle for MACSIO's main log
 
@@ -254,6 +294,7 @@ extern MACSIO_LOG_LogHandle_t *MACSIO_LOG_LogInit(MPI_Comm comm, char const *pat
 extern MACSIO_LOG_LogHandle_t *MACSIO_LOG_LogInit(int comm, char const *path, int line_len, int lines_per_proc, int extra_lines_proc0);
 #endif
 extern void MACSIO_LOG_LogMsg(MACSIO_LOG_LogHandle_t const *log, char const *fmt, ...);
+extern void MACSIO_LOG_LogFlush(MACSIO_LOG_LogHandle_t const *log);
 extern void MACSIO_LOG_LogMsgWithDetails(MACSIO_LOG_LogHandle_t const *log, char const *linemsg,
     MACSIO_LOG_MsgSeverity_t sevVal, char const *sevStr,
     int sysErrno, int mpiErrno, char const *theFile, int theLine);
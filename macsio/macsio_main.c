@@ -50,6 +50,7 @@ extern "C" {
 #include <macsio_iface.h>
 #include <macsio_log.h>
 #include <macsio_main.h>
+#include <macsio_telemetry.h>
 #include <macsio_timing.h>
 #include <macsio_utils.h>
 
@@ -284,6 +285,39 @@ int MACSIO_MAIN_Comm = 0;
 int MACSIO_MAIN_Size = 1;
 int MACSIO_MAIN_Rank = 0;
 
+#ifdef HAVE_MPI
+MPI_Info MACSIO_MAIN_MPIInfo = MPI_INFO_NULL;
+
+/* Build an MPI_Info from a comma-separated list of key=val hints */
+static MPI_Info make_mpi_info(char const *hints)
+{
+    MPI_Info info;
+    char *hints_copy, *p, *hint;
+
+    if (!hints || !strlen(hints))
+        return MPI_INFO_NULL;
+
+    MPI_Info_create(&info);
+    hints_copy = p = strdup(hints);
+    while ((hint = strsep(&p, ",")))
+    {
+        char *val = strchr(hint, '=');
+
+        if (!strlen(hint))
+            continue;
+        if (!val || val == hint || !strlen(val+1))
+        {
+            MACSIO_LOG_MSGL(MACSIO_LOG_StdErr, Warn, ("Ignoring malformed MPI hint \"%s\"", hint));
+            continue;
+        }
+        *val++ = '\0';
+        MPI_Info_set(info, hint, val);
+    }
+    free(hints_copy);
+    return info;
+}
+#endif
+
 static void handle_help_request_and_exit(int argi, int argc, char **argv)
 {
     int i, n, *ids=0;;
@@ -405,6 +439,25 @@ static json_object *ProcessCommandLine(int argc, char *argv[], int *plugin_argi)
             "curvilinear mesh it is the number of spatial dimensions and for\n"
             "unstructured mesh it is the number of spatial dimensions plus\n"
             "2^number of topological dimensions. [50]",
+        "--vector_vars %d", "0",
+            "Number of vector variable objects in each part in addition to the\n"
+            "vars_per_part scalar variables. A vector variable, like a velocity,\n"
+            "is node centered and has one component for each spatial dimension.",
+        "--tensor_vars %d", "0",
+            "Number of symmetric tensor variable objects in each part in addition to\n"
+            "the vars_per_part scalar variables. A tensor variable, like a stress, is\n"
+            "zone centered and has 1, 3 or 6 components in 1, 2 or 3 dimensions.",
+        "--subset_vars %d", "0",
+            "Number of subset variable objects in each part in addition to the\n"
+            "vars_per_part scalar variables. A subset variable is a zone centered\n"
+            "scalar defined on only some of a part's zones, like a material's\n"
+            "density. It is stored as a list of zone indices and a value for each.",
+        "--var_layout %s", "aos",
+            "Memory layout of the components of vector and tensor variables. Use\n"
+            "'aos' (array of structs) to interleave the components of each node or\n"
+            "zone or 'soa' (struct of arrays) to store each component contiguously.\n"
+            "Plugins that can write multi-component data natively do so in the same\n"
+            "layout.",
         "--topology_change_probability %f", "0.0",
             "The probability that the topology of the mesh (e.g. something fundamental\n"
             "about the mesh's structure) will change between dumps. A value of 1.0\n"
@@ -477,12 +530,41 @@ static json_object *ProcessCommandLine(int argc, char *argv[], int *plugin_argi)
             "for rank 0.",
         "--log_line_length %d", "128",
             "Set log file line length.",
+        "--log_mpiio", "",
+            "Write the log and timings files with MPI-IO. Each rank keeps its lines\n"
+            "in memory and all ranks write them with a single collective write when\n"
+            "the file is closed. This avoids rank 0 serially priming the file and\n"
+            "every rank opening it, which can be slow at large scale. However, the\n"
+            "log file will not reflect messages issued prior to an abnormal exit\n"
+            "except for those of severity Err or Die.",
         "--timings_file_name %s", "macsio-timings.log",
             "Specify the name of the timings file. Passing an empty string, \"\"\n"
             "will disable the creation of a timings file.",
+        "--timings_format %s", "text",
+            "Format of the timings file. Use \"text\" for fixed width lines like the\n"
+            "log file or \"jsonl\" for compact JSON lines records, one per timer per\n"
+            "rank plus the reduced timers, suitable for processing with tstat.",
+        "--perf_counters", "",
+            "Attach performance counters (cycles, instructions, LLC misses, context\n"
+            "switches and page faults) to timers and include them in the timings file.\n"
+            "Counters are obtained with perf_event_open(2) on Linux. Any that are\n"
+            "not available on the system are silently omitted.",
+        "--telemetry %s", MACSIO_CLARGS_NODEFAULT,
+            "Emit a JSON lines record of bytes, bandwidth and timer deltas as each\n"
+            "dump completes. The argument is either the name of a file to append\n"
+            "records to or \"unix:<path>\" to stream them to a Unix domain socket\n"
+            "another process is listening on. Records are written by rank 0 only.",
         MACSIO_CLARGS_ARG_GROUP_END(Log File Options),
         "--alignment %d", MACSIO_CLARGS_NODEFAULT,
-            "Not currently documented",
+            "Align objects of at least this many bytes on multiples of it in the\n"
+            "file, e.g. the file system's stripe or block size. Plugins that support\n"
+            "it also size chunks to cover whole multiples of it.",
+        "--mpi_hints %s", "",
+            "Comma-separated list of key=val MPI-IO hints, e.g.\n"
+            "\"striping_factor=16,striping_unit=1048576,cb_nodes=8\". They are\n"
+            "passed to every file opened with MPI-IO, including the log and timings\n"
+            "files and the files of plugins using MPI-IO, such as HDF5 in SIF mode.\n"
+            "Other common hints are cb_buffer_size and romio_cb_write.",
         "--filebase %s", "macsio",
             "Basename of generated file(s).",
         "--fileext %s", "dat",
@@ -525,6 +607,10 @@ static json_object *ProcessCommandLine(int argc, char *argv[], int *plugin_argi)
     if (!strcmp(json_object_path_get_string(mainJargs, "interface"), ""))
         MACSIO_LOG_MSG(Die, ("no io-interface specified"));
 
+    if (strcmp(json_object_path_get_string(mainJargs, "var_layout"), "aos") &&
+        strcmp(json_object_path_get_string(mainJargs, "var_layout"), "soa"))
+        MACSIO_LOG_MSG(Die, ("var_layout must be either \"aos\" or \"soa\""));
+
     if (plugin_argi)
         *plugin_argi = plugin_args_start>-1?plugin_args_start+1:argc;
 
@@ -549,7 +635,8 @@ write_timings_file(char const *filename)
     MPI_Allreduce(rdata, rdata_out, 3, MPI_INT, MPI_MAX, MACSIO_MAIN_Comm);
 #endif
 
-    timing_log = MACSIO_LOG_LogInit(MACSIO_MAIN_Comm, filename, rdata_out[0], rdata_out[1], rdata_out[2]+1);
+    /* Leave room for the severity:file:line prefix MACSIO_LOG_MSGL adds to each line */
+    timing_log = MACSIO_LOG_LogInit(MACSIO_MAIN_Comm, filename, rdata_out[0]+64, rdata_out[1], rdata_out[2]+1);
 
     /* dump this processor's timers */
     for (i = 0; i < ntimers; i++)
@@ -577,6 +664,92 @@ write_timings_file(char const *filename)
     MACSIO_LOG_LogFinalize(timing_log);
 }
 
+/* Write timers as JSON lines. Records vary in length so each rank's records are
+   placed in the file by a prefix sum of their sizes and written collectively. */
+static void
+write_timings_jsonl(char const *filename, json_object *main_obj)
+{
+    char **timer_strs = 0, **rtimer_strs = 0;
+    char const *run_str = "";
+    json_object *run_obj = 0;
+    char *buf, *p;
+    int i, ntimers, maxlen, rntimers = 0, rmaxlen = 0;
+    long long nbytes = 0, offset = 0;
+
+    MACSIO_TIMING_DumpTimersToJsonStrings(MACSIO_TIMING_ALL_GROUPS, &timer_strs, &ntimers, &maxlen);
+    MACSIO_TIMING_ReduceTimers(MACSIO_MAIN_Comm, 0);
+    if (MACSIO_MAIN_Rank == 0)
+        MACSIO_TIMING_DumpReducedTimersToJsonStrings(MACSIO_TIMING_ALL_GROUPS, &rtimer_strs, &rntimers, &rmaxlen);
+
+    if (MACSIO_MAIN_Rank == 0)
+    {
+        run_obj = json_object_new_object();
+        json_object_object_add(run_obj, "record", json_object_new_string("run"));
+        json_object_object_add(run_obj, "time", json_object_new_double(MT_Time()));
+        json_object_object_add(run_obj, "mpi_size", json_object_new_int(MACSIO_MAIN_Size));
+        json_object_object_add(run_obj, "interface",
+            json_object_new_string(json_object_path_get_string(main_obj, "clargs/interface")));
+        json_object_object_add(run_obj, "part_size", json_object_new_int(JsonGetInt(main_obj, "clargs/part_size")));
+        json_object_object_add(run_obj, "avg_num_parts",
+            json_object_new_double(JsonGetDbl(main_obj, "clargs/avg_num_parts")));
+        json_object_object_add(run_obj, "num_dumps", json_object_new_int(JsonGetInt(main_obj, "clargs/num_dumps")));
+        run_str = json_object_to_json_string_ext(run_obj, JSON_C_TO_STRING_PLAIN);
+    }
+
+    /* each timer string is an object; we splice a record type and rank into it */
+    buf = p = (char *) malloc(strlen(run_str) + 2 + ntimers * (maxlen + 64) + rntimers * (rmaxlen + 64));
+    if (MACSIO_MAIN_Rank == 0)
+        p += sprintf(p, "%s\n", run_str);
+    if (run_obj)
+        json_object_put(run_obj);
+    for (i = 0; i < ntimers; i++)
+    {
+        p += sprintf(p, "{\"record\":\"timer\",\"rank\":%d,%s\n", MACSIO_MAIN_Rank, timer_strs[i]+1);
+        free(timer_strs[i]);
+    }
+    free(timer_strs);
+    for (i = 0; i < rntimers; i++)
+    {
+        p += sprintf(p, "{\"record\":\"reduced\",%s\n", rtimer_strs[i]+1);
+        free(rtimer_strs[i]);
+    }
+    if (rtimer_strs) free(rtimer_strs);
+    nbytes = p - buf;
+
+#ifdef HAVE_MPI
+    {
+        MPI_File fh;
+        MPI_Status status;
+
+        MPI_Exscan(&nbytes, &offset, 1, MPI_LONG_LONG, MPI_SUM, MACSIO_MAIN_Comm);
+        if (MACSIO_MAIN_Rank == 0) offset = 0;
+        mpi_errno = MPI_File_open(MACSIO_MAIN_Comm, (char*) filename, MPI_MODE_CREATE|MPI_MODE_WRONLY,
+            MACSIO_MAIN_MPIInfo, &fh);
+        if (mpi_errno == MPI_SUCCESS)
+        {
+            MPI_File_set_size(fh, 0);
+            MPI_File_write_at_all(fh, (MPI_Offset) offset, buf, (int) nbytes, MPI_CHAR, &status);
+            MPI_File_close(&fh);
+        }
+        else
+            MACSIO_LOG_MSG(Warn, ("Unable to open timings file \"%s\"", filename));
+    }
+#else
+    {
+        FILE *f = fopen(filename, "w");
+        if (f)
+        {
+            fwrite(buf, 1, nbytes, f);
+            fclose(f);
+        }
+        else
+            MACSIO_LOG_MSG(Warn, ("Unable to open timings file \"%s\"", filename));
+    }
+#endif
+
+    free(buf);
+}
+
 static int
 main_write(int argi, int argc, char **argv, json_object *main_obj)
 {
@@ -594,7 +767,13 @@ main_write(int argi, int argc, char **argv, json_object *main_obj)
 
     /* Generate a static problem object to dump on each dump */
     json_object *problem_obj = MACSIO_DATA_GenerateTimeZeroDumpObject(main_obj,0);
-    problem_nbytes = (unsigned long long) json_object_object_nbytes(problem_obj, JSON_C_FALSE);
+    problem_nbytes = (unsigned long long) json_object_payload_nbytes(problem_obj);
+    {
+        char payload_str[32], overhead_str[32];
+        MACSIO_LOG_MSG(Dbg1, ("Problem object holds %s of data and %s of headers and keys",
+            MU_PrByts(problem_nbytes, 0, payload_str, sizeof(payload_str)),
+            MU_PrByts(json_object_overhead_nbytes(problem_obj), 0, overhead_str, sizeof(overhead_str))));
+    }
 
 #warning MAKE JSON OBJECT KEY CASE CONSISTENT
     json_object_object_add(main_obj, "problem", problem_obj);
@@ -611,12 +790,17 @@ main_write(int argi, int argc, char **argv, json_object *main_obj)
 
         snprintf(outfName, sizeof(outfName), "main_obj_write_%03d.json", MACSIO_MAIN_Rank);
         outf = fopen(outfName, "w");
-        fprintf(outf, "\"%s\"\n", json_object_to_json_string_ext(main_obj, json_c_print_flags));
+        fputc('"', outf);
+        fflush(outf);
+        json_object_to_fd(fileno(outf), main_obj, json_c_print_flags);
+        fputs("\"\n", outf);
         fclose(outf);
     }
 
 #warning WERE NOT GENERATING OR WRITING ANY METADATA STUFF
 
+    MACSIO_TELEMETRY_Init(MACSIO_MAIN_Comm, json_object_path_get_string(main_obj, "clargs/telemetry"), main_obj);
+
 #warning MAKE THIS LOOP MORE LIKE A MAIN SIM LOOP WITH SIMPLE COMPUTE AND COMM STEP
     dump_loop_start = MT_Time();
     dumpTime = 0.0;
@@ -678,10 +862,14 @@ main_write(int argi, int argc, char **argv, json_object *main_obj)
             MU_PrByts(problem_nbytes, 0, nbytes_str, sizeof(nbytes_str)),
             MU_PrSecs(dt, 0, seconds_str, sizeof(seconds_str)),
             MU_PrBW(problem_nbytes, dt, 0, bandwidth_str, sizeof(bandwidth_str))));
+
+        MACSIO_TELEMETRY_EmitDump(dumpNum, problem_nbytes, dt);
     }
 
     dump_loop_end = MT_Time();
 
+    MACSIO_TELEMETRY_Finalize();
+
     MACSIO_LOG_MSG(Info, ("Overall BW: %s/%s = %s",
         MU_PrByts(dumpBytes, 0, nbytes_str, sizeof(nbytes_str)),
         MU_PrSecs(dumpTime, 0, seconds_str, sizeof(seconds_str)),
@@ -720,7 +908,7 @@ main_read(int argi, int argc, char **argv, json_object *main_obj)
 
     for (loadNum = 0; loadNum < json_object_path_get_int(main_obj, "clargs/num_loads"); loadNum++)
     {
-        json_object *data_read_obj;
+        json_object *data_read_obj = 0;
         MACSIO_TIMING_TimerId_t heavy_load_tid;
 
         const MACSIO_IFACE_Handle_t *iface = MACSIO_IFACE_GetByName(
@@ -743,6 +931,8 @@ main_read(int argi, int argc, char **argv, json_object *main_obj)
         /* Validate the data */
         if (JsonGetBool(main_obj, "clargs/validate_read"))
             MACSIO_DATA_ValidateDataRead(data_read_obj);
+
+        json_object_put(data_read_obj);
     }
 
     /* Just here for debugging for the moment */
@@ -752,7 +942,10 @@ main_read(int argi, int argc, char **argv, json_object *main_obj)
         FILE *outf;
         snprintf(outfName, sizeof(outfName), "main_obj_read_%03d.json", MACSIO_MAIN_Rank);
         outf = fopen(outfName, "w");
-        fprintf(outf, "\"%s\"\n", json_object_to_json_string_ext(main_obj, JSON_C_TO_STRING_PRETTY));
+        fputc('"', outf);
+        fflush(outf);
+        json_object_to_fd(fileno(outf), main_obj, JSON_C_TO_STRING_PRETTY);
+        fputs("\"\n", outf);
         fclose(outf);
     }
 }
@@ -773,6 +966,10 @@ main(int argc, char *argv[])
     for (i = 0; i < argc && !exercise_scr; i++)
         exercise_scr = !strcmp("exercise_scr", argv[i]);
 
+    /* quick pre-scan for perf counters flag so the main timer gets them too */
+    for (i = 0; i < argc && !MACSIO_TIMING_UsePerfCounters; i++)
+        MACSIO_TIMING_UsePerfCounters = !strcmp("--perf_counters", argv[i]);
+
 #warning SHOULD WE BE USING MPI-3 API
 #ifdef HAVE_MPI
     MPI_Init(&argc, &argv);
@@ -801,6 +998,11 @@ main(int argc, char *argv[])
     strncpy(MACSIO_UTILS_UnitsPrefixSystem, JsonGetStr(clargs_obj, "units_prefix_system"),
         sizeof(MACSIO_UTILS_UnitsPrefixSystem));
 
+#ifdef HAVE_MPI
+    MACSIO_MAIN_MPIInfo = make_mpi_info(JsonGetStr(clargs_obj, "mpi_hints"));
+    MACSIO_LOG_MPIInfo = MACSIO_MAIN_MPIInfo;
+#endif
+    MACSIO_LOG_UseMPIIO = JsonGetInt(clargs_obj, "log_mpiio");
     MACSIO_LOG_MainLog = MACSIO_LOG_LogInit(MACSIO_MAIN_Comm,
         JsonGetStr(clargs_obj, "log_file_name"),
         JsonGetInt(clargs_obj, "log_line_length"),
@@ -830,7 +1032,12 @@ main(int argc, char *argv[])
 
     /* Write timings data file if requested */
     if (strlen(JsonGetStr(clargs_obj, "timings_file_name")))
-        write_timings_file(JsonGetStr(clargs_obj, "timings_file_name"));
+    {
+        if (!strcmp(json_object_path_get_string(clargs_obj, "timings_format"), "jsonl"))
+            write_timings_jsonl(json_object_path_get_string(clargs_obj, "timings_file_name"), main_obj);
+        else
+            write_timings_file(JsonGetStr(clargs_obj, "timings_file_name"));
+    }
 
     MACSIO_TIMING_ClearTimers(MACSIO_TIMING_ALL_GROUPS);
 
@@ -851,6 +1058,8 @@ main(int argc, char *argv[])
 #endif
 
 #ifdef HAVE_MPI
+    if (MACSIO_MAIN_MPIInfo != MPI_INFO_NULL)
+        MPI_Info_free(&MACSIO_MAIN_MPIInfo);
     {   int result;
         if ((MPI_Initialized(&result) == MPI_SUCCESS) && result)
             MPI_Finalize();
@@ -37,6 +37,12 @@ extern MPI_Comm MACSIO_MAIN_Comm;
 #else
 extern int MACSIO_MAIN_Comm;
 #endif
+
+#ifdef HAVE_MPI
+/* MPI-IO hints from the --mpi_hints argument, for all files opened with MPI-IO */
+extern MPI_Info MACSIO_MAIN_MPIInfo;
+#endif
+
 extern int MACSIO_MAIN_Size;
 extern int MACSIO_MAIN_Rank;
 
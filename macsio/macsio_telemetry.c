@@ -0,0 +1,277 @@
+/*
+Copyright (c) 2015, Lawrence Livermore National Security, LLC.
+Produced at the Lawrence Livermore National Laboratory.
+Written by Mark C. Miller
+
+LLNL-CODE-676051. All rights reserved.
+
+This file is part of MACSio
+
+Please also read the LICENSE file at the top of the source code directory or
+folder hierarchy.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License (as published by the Free Software
+Foundation) version 2, dated June 1991.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the terms and conditions of the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <macsio_log.h>
+#include <macsio_telemetry.h>
+#include <macsio_timing.h>
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/*!
+\addtogroup MACSIO_TELEMETRY
+@{
+*/
+
+#ifdef HAVE_MPI
+static MPI_Comm telemetryComm = MPI_COMM_NULL;
+#else
+static int telemetryComm = 0;
+#endif
+static int telemetryEnabled = 0;   /**< Non-zero on all ranks when telemetry was requested */
+static int telemetryRank = 0;
+static int telemetryFd = -1;       /**< File or socket descriptor (rank 0 only) */
+static int telemetryIsSocket = 0;
+static double telemetryStartTime = 0;
+static unsigned long long telemetryTotalBytes = 0;
+static json_object *telemetryPrevTimers = 0; /**< Timer totals at the previous record, keyed by label */
+
+static int
+open_target(char const *target)
+{
+    if (!strncmp(target, "unix:", 5))
+    {
+        struct sockaddr_un addr;
+        int fd;
+
+        if (strlen(target+5) >= sizeof(addr.sun_path))
+        {
+            MACSIO_LOG_MSG(Warn, ("Telemetry socket path \"%s\" too long", target+5));
+            return -1;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, target+5);
+        if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+            return -1;
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1)
+        {
+            close(fd);
+            return -1;
+        }
+        telemetryIsSocket = 1;
+        return fd;
+    }
+
+    return open(target, O_WRONLY|O_CREAT|O_APPEND, S_IRUSR|S_IWUSR|S_IRGRP);
+}
+
+/* Write one record as a single line. Any failure disables telemetry on rank 0.
+   Other ranks keep participating in the (cheap) reductions. */
+static void
+emit_record(json_object *rec)
+{
+    char const *str;
+    size_t len, off = 0;
+
+    if (telemetryFd == -1) return;
+
+    str = json_object_to_json_string_ext(rec, JSON_C_TO_STRING_PLAIN);
+    len = strlen(str);
+    while (off <= len)
+    {
+        /* the terminating null is replaced by the record separator */
+        char const *p = off < len ? str + off : "\n";
+        size_t n = off < len ? len - off : 1;
+        ssize_t w = telemetryIsSocket ? send(telemetryFd, p, n, MSG_NOSIGNAL) : write(telemetryFd, p, n);
+        if (w <= 0)
+        {
+            MACSIO_LOG_MSG(Warn, ("Write to telemetry target failed, disabling telemetry"));
+            close(telemetryFd);
+            telemetryFd = -1;
+            return;
+        }
+        off += w;
+    }
+}
+
+/* Add change in rank 0's timer totals since the previous record to rec */
+static void
+add_timer_deltas(json_object *rec)
+{
+    MACSIO_TIMING_TimerId_t *ids = 0;
+    json_object *timers = json_object_new_object();
+    int i, n;
+
+    if (!telemetryPrevTimers)
+        telemetryPrevTimers = json_object_new_object();
+
+    MACSIO_TIMING_GetIds(MACSIO_TIMING_ALL_GROUPS, &n, &ids);
+    for (i = 0; i < n; i++)
+    {
+        char const *label = MACSIO_TIMING_GetLabel(ids[i]);
+        double total = MACSIO_TIMING_GetTimer(ids[i], "total_time");
+        double prev = 0, delta;
+        json_object *prev_obj = 0, *cur_obj = 0;
+
+        if (json_object_object_get_ex(telemetryPrevTimers, label, &prev_obj))
+            prev = json_object_get_double(prev_obj);
+        delta = total - prev;
+        json_object_object_add(telemetryPrevTimers, label, json_object_new_double(total));
+
+        /* distinct timers may share a label; combine them */
+        if (json_object_object_get_ex(timers, label, &cur_obj))
+            delta += json_object_get_double(cur_obj);
+        json_object_object_add(timers, label, json_object_new_double(delta));
+    }
+    free(ids);
+
+    json_object_object_add(rec, "timer_deltas", timers);
+}
+
+void
+MACSIO_TELEMETRY_Init(
+#ifdef HAVE_MPI
+    MPI_Comm comm,
+#else
+    int comm,
+#endif
+    char const *target,
+    json_object *main_obj
+)
+{
+    int ok = 1;
+
+    if (!target || !strlen(target) || !strcmp(target, "null"))
+        return;
+
+    telemetryComm = comm;
+    telemetryEnabled = 1;
+    telemetryTotalBytes = 0;
+    telemetryStartTime = MT_Time();
+#ifdef HAVE_MPI
+    MPI_Comm_rank(comm, &telemetryRank);
+#endif
+
+    if (telemetryRank == 0)
+    {
+        if ((telemetryFd = open_target(target)) == -1)
+        {
+            MACSIO_LOG_MSG(Warn, ("Unable to open telemetry target \"%s\"", target));
+            ok = 0;
+        }
+        else
+        {
+            json_object *rec = json_object_new_object();
+            json_object_object_add(rec, "record", json_object_new_string("start"));
+            json_object_object_add(rec, "time", json_object_new_double(telemetryStartTime));
+            json_object_object_add(rec, "mpi_size", json_object_new_int(JsonGetInt(main_obj, "parallel/mpi_size")));
+            json_object_object_add(rec, "interface", json_object_new_string(JsonGetStr(main_obj, "clargs/interface")));
+            json_object_object_add(rec, "part_size", json_object_new_int(JsonGetInt(main_obj, "clargs/part_size")));
+            json_object_object_add(rec, "avg_num_parts", json_object_new_double(JsonGetDbl(main_obj, "clargs/avg_num_parts")));
+            json_object_object_add(rec, "num_dumps", json_object_new_int(JsonGetInt(main_obj, "clargs/num_dumps")));
+            emit_record(rec);
+            json_object_put(rec);
+        }
+    }
+    errno = 0;
+
+#ifdef HAVE_MPI
+    /* If rank 0 cannot open the target, no one bothers with the reductions */
+    MPI_Bcast(&ok, 1, MPI_INT, 0, comm);
+#endif
+    telemetryEnabled = ok;
+}
+
+void
+MACSIO_TELEMETRY_EmitDump(int dumpNum, unsigned long long nbytes, double seconds)
+{
+    unsigned long long sum_nbytes = nbytes;
+    double min_seconds = seconds, max_seconds = seconds;
+    json_object *rec;
+
+    if (!telemetryEnabled) return;
+
+#ifdef HAVE_MPI
+    MPI_Reduce(&nbytes, &sum_nbytes, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, telemetryComm);
+    MPI_Reduce(&seconds, &min_seconds, 1, MPI_DOUBLE, MPI_MIN, 0, telemetryComm);
+    MPI_Reduce(&seconds, &max_seconds, 1, MPI_DOUBLE, MPI_MAX, 0, telemetryComm);
+#endif
+
+    if (telemetryRank != 0 || telemetryFd == -1) return;
+
+    telemetryTotalBytes += sum_nbytes;
+
+    rec = json_object_new_object();
+    json_object_object_add(rec, "record", json_object_new_string("dump"));
+    json_object_object_add(rec, "time", json_object_new_double(MT_Time()));
+    json_object_object_add(rec, "dump", json_object_new_int(dumpNum));
+    json_object_object_add(rec, "bytes", json_object_new_int64((int64_t) sum_nbytes));
+    json_object_object_add(rec, "min_seconds", json_object_new_double(min_seconds));
+    json_object_object_add(rec, "max_seconds", json_object_new_double(max_seconds));
+    json_object_object_add(rec, "bandwidth",
+        json_object_new_double(max_seconds > 0 ? sum_nbytes / max_seconds : 0));
+    json_object_object_add(rec, "total_bytes", json_object_new_int64((int64_t) telemetryTotalBytes));
+    json_object_object_add(rec, "elapsed", json_object_new_double(MT_Time() - telemetryStartTime));
+    add_timer_deltas(rec);
+    emit_record(rec);
+    json_object_put(rec);
+}
+
+void
+MACSIO_TELEMETRY_Finalize(void)
+{
+    if (!telemetryEnabled) return;
+
+    if (telemetryRank == 0 && telemetryFd != -1)
+    {
+        json_object *rec = json_object_new_object();
+        double elapsed = MT_Time() - telemetryStartTime;
+        json_object_object_add(rec, "record", json_object_new_string("end"));
+        json_object_object_add(rec, "time", json_object_new_double(MT_Time()));
+        json_object_object_add(rec, "total_bytes", json_object_new_int64((int64_t) telemetryTotalBytes));
+        json_object_object_add(rec, "elapsed", json_object_new_double(elapsed));
+        json_object_object_add(rec, "bandwidth",
+            json_object_new_double(elapsed > 0 ? telemetryTotalBytes / elapsed : 0));
+        emit_record(rec);
+        json_object_put(rec);
+        close(telemetryFd);
+        telemetryFd = -1;
+    }
+
+    if (telemetryPrevTimers)
+        json_object_put(telemetryPrevTimers);
+    telemetryPrevTimers = 0;
+    telemetryEnabled = 0;
+}
+
+/*!@}*/
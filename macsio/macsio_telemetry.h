@@ -0,0 +1,107 @@
+#ifndef _MACSIO_TELEMETRY_H
+#define _MACSIO_TELEMETRY_H
+/*
+Copyright (c) 2015, Lawrence Livermore National Security, LLC.
+Produced at the Lawrence Livermore National Laboratory.
+Written by Mark C. Miller
+
+LLNL-CODE-676051. All rights reserved.
+
+This file is part of MACSio
+
+Please also read the LICENSE file at the top of the source code directory or
+folder hierarchy.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License (as published by the Free Software
+Foundation) version 2, dated June 1991.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the terms and conditions of the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <json-cwx/json.h>
+
+/*!
+\defgroup MACSIO_TELEMETRY MACSIO_TELEMETRY
+\brief Live progress reporting during long runs
+
+The timings file and summary bandwidth messages are produced only at the very end of
+a run. For long running (e.g. soak) tests, MACSIO_TELEMETRY provides an in-flight view
+of progress by emitting one record per dump as it completes.
+
+Each record is a single line of plain JSON (e.g. JSON lines format) so that a monitoring
+agent can simply tail the stream. A record holds the dump number, the bytes dumped summed
+over all ranks, the min and max time any rank spent in the dump, the resulting aggregate
+bandwidth, running totals and the change since the previous record in the total time
+of each of rank 0's timers. A \c "start" record is emitted at initialization and an
+\c "end" record at finalization.
+
+Records are produced at dump boundaries rather than from a separate timer thread. That
+keeps the emitter free of any threading requirements on MPI. Gathering the per-dump
+values does require a small reduction to rank 0 each dump and so all ranks in the
+communicator must call \c MACSIO_TELEMETRY_EmitDump() collectively. Only rank 0 writes.
+
+The target is either a local file, which is appended to, or, when given as
+\c unix:path, a Unix domain stream socket some other process is listening on. If
+the target cannot be opened or a write to it fails, a warning is logged and
+telemetry is disabled for the remainder of the run. It never causes MACSio to fail.
+
+@{
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+\brief Initialize telemetry
+
+Must be called collectively. Passing a null or empty \c target leaves
+telemetry disabled and all other calls become no-ops.
+*/
+extern void
+MACSIO_TELEMETRY_Init(
+#ifdef HAVE_MPI
+    MPI_Comm comm,         /**< [in] The MPI communicator dumps are performed on */
+#else
+    int comm,              /**< [in] Dummy arg for non-MPI compilation */
+#endif
+    char const *target,    /**< [in] File name or \c unix:path of a Unix domain socket */
+    json_object *main_obj  /**< [in] The main json object; some of its clargs are included in the start record */
+);
+
+/*!
+\brief Emit a record for a completed dump
+
+Must be called collectively after each dump.
+*/
+extern void
+MACSIO_TELEMETRY_EmitDump(
+    int dumpNum,                /**< [in] The number/index of the dump just completed */
+    unsigned long long nbytes,  /**< [in] Bytes this rank dumped */
+    double seconds              /**< [in] Time this rank spent in the dump */
+);
+
+/*!
+\brief Emit the final record and close the telemetry target
+*/
+extern void MACSIO_TELEMETRY_Finalize(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*!@}*/
+
+#endif /* _MACSIO_TELEMETRY_H */
@@ -33,15 +33,25 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <cfloat>
 #include <climits>
+#include <errno.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #define MACSIO_TIMING_HASH_TABLE_SIZE 10007
+#define MACSIO_TIMING_NUM_COUNTERS 5
 
 int MACSIO_TIMING_UseMPI_Wtime = 1;
+int MACSIO_TIMING_UsePerfCounters = 0;
 
 static double get_current_time()
 {
@@ -111,6 +121,146 @@ static double get_current_time()
 #endif
 }
 
+/* Hardware/software performance counters that can be attached to timers.
+   The order here determines the order of values in a timer's counters
+   array as well as the field names GetTimer() accepts for them. */
+static struct {
+    char const *name;   /* field name for GetTimer() */
+    char const *abbrev; /* abbreviation used when dumping timers to strings */
+#ifdef __linux__
+    unsigned int type;
+    unsigned long long config;
+#endif
+} const perfCounterInfo[MACSIO_TIMING_NUM_COUNTERS] = {
+#ifdef __linux__
+    {"cycles",       "CYC", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", "INS", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"llc_misses",   "LLC", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"ctx_switches", "CSW", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {"page_faults",  "PGF", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}
+#else
+    {"cycles",       "CYC"},
+    {"instructions", "INS"},
+    {"llc_misses",   "LLC"},
+    {"ctx_switches", "CSW"},
+    {"page_faults",  "PGF"}
+#endif
+};
+
+/* State of this process' counter group. perfCounterMask has a bit set for
+   each counter that was successfully opened. Counters that cannot be opened
+   (no kernel support, insufficient permissions, virtualized PMU, etc.) are
+   simply left out of the mask and reported as unavailable. */
+static int perfCountersInitialized = 0;
+static int perfCounterMask = 0;
+#ifdef __linux__
+static int perfGroupFd = -1;
+static int perfCounterFds[MACSIO_TIMING_NUM_COUNTERS] = {-1, -1, -1, -1, -1};
+static int perfCounterGroupIdx[MACSIO_TIMING_NUM_COUNTERS];
+static int perfGroupSize = 0;
+
+static int
+open_perf_counter(int i, int group_fd, int exclude_kernel)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perfCounterInfo[i].type;
+    attr.config = perfCounterInfo[i].config;
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+static void
+init_perf_counters(void)
+{
+#ifdef __linux__
+    int i;
+
+    perfCountersInitialized = 1;
+
+    /* First counter we can open becomes the group leader. We'd like to include
+       time spent in the kernel (syscalls are part of what we're after) but fall
+       back to user-space only counting for a counter the system does not permit
+       that for. Other failures (e.g. no PMU) do not affect the other counters. */
+    for (i = 0; i < MACSIO_TIMING_NUM_COUNTERS; i++)
+    {
+        int fd = open_perf_counter(i, perfGroupFd, 0);
+        if (fd == -1 && (errno == EACCES || errno == EPERM))
+            fd = open_perf_counter(i, perfGroupFd, 1);
+        if (fd == -1) continue;
+
+        if (perfGroupFd == -1)
+            perfGroupFd = fd;
+        perfCounterFds[i] = fd;
+        perfCounterGroupIdx[i] = perfGroupSize++;
+        perfCounterMask |= (1<<i);
+    }
+
+    if (perfGroupFd != -1)
+    {
+        ioctl(perfGroupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(perfGroupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    errno = 0;
+#else
+    perfCountersInitialized = 1;
+#endif
+}
+
+static void
+close_perf_counters(void)
+{
+#ifdef __linux__
+    int i;
+    for (i = MACSIO_TIMING_NUM_COUNTERS-1; i >= 0; i--)
+    {
+        if (perfCounterFds[i] != -1)
+            close(perfCounterFds[i]);
+        perfCounterFds[i] = -1;
+    }
+    perfGroupFd = -1;
+    perfGroupSize = 0;
+#endif
+    perfCounterMask = 0;
+    perfCountersInitialized = 0;
+}
+
+/* Read current values of all available counters with a single read of the
+   group. Returns the mask of counters for which vals[] holds valid data. */
+static int
+read_perf_counters(unsigned long long *vals)
+{
+#ifdef __linux__
+    unsigned long long buf[1+MACSIO_TIMING_NUM_COUNTERS];
+    int i;
+
+    if (!MACSIO_TIMING_UsePerfCounters) return 0;
+    if (!perfCountersInitialized) init_perf_counters();
+    if (perfGroupFd == -1) return 0;
+
+    if (read(perfGroupFd, buf, sizeof(buf)) < (ssize_t) ((1+perfGroupSize)*sizeof(buf[0])))
+    {
+        errno = 0;
+        return 0;
+    }
+
+    for (i = 0; i < MACSIO_TIMING_NUM_COUNTERS; i++)
+        vals[i] = (perfCounterMask & (1<<i)) ? buf[1+perfCounterGroupIdx[i]] : 0;
+
+    return perfCounterMask;
+#else
+    if (MACSIO_TIMING_UsePerfCounters && !perfCountersInitialized) init_perf_counters();
+    return 0;
+#endif
+}
+
 /* A small collection of strings to be associated with different
    timer groups. That is, collections of timers that are used to
    time different phases of some larger class of activity. For
@@ -178,6 +328,8 @@ typedef struct _timerInfo_t
     int iter_num;                    /**< Iteration number of current timer */
     int depth;                       /**< Depth of this timer relative to other active timers */
     int is_restart;                  /**< Is this timer restarting the current iteration */
+    int counter_mask;                /**< Bit mask of perf counters valid over all iterations (and ranks in reductions) */
+    int counter_mask_this_iter;      /**< Bit mask of perf counters sampled at start of current iteration */
 
     double total_time;               /**< Total cummulative time spent in this timer over all iterations */
     double min_time;                 /**< Min over all iterations this timer ran */
@@ -189,6 +341,9 @@ typedef struct _timerInfo_t
 
     MACSIO_TIMING_GroupMask_t gmask; /**< User defined bit mask for group membership of this timer. */
 
+    unsigned long long counters[MACSIO_TIMING_NUM_COUNTERS];       /**< Perf counter totals over all iterations */
+    unsigned long long counters_start[MACSIO_TIMING_NUM_COUNTERS]; /**< Perf counter values at start of current iteration */
+
     char __file__[32];               /**< Source file name for StartTimer call */
     char label[64];                  /**< User defined label given to the timer */
 
@@ -238,8 +393,11 @@ MACSIO_TIMING_TimerId_t MACSIO_TIMING_StartTimer(
             timerHashTable[tid].iter_num = iter_num;
             timerHashTable[tid].total_time_this_iter = 0;
             timerHashTable[tid].is_restart = 0;
+            memset(timerHashTable[tid].counters, 0, sizeof(timerHashTable[tid].counters));
 
             timerHashTable[tid].depth = 0;
+            timerHashTable[tid].counter_mask_this_iter = read_perf_counters(timerHashTable[tid].counters_start);
+            timerHashTable[tid].counter_mask = timerHashTable[tid].counter_mask_this_iter;
             timerHashTable[tid].start_time = get_current_time();
             return tid;
         }
@@ -256,6 +414,7 @@ MACSIO_TIMING_TimerId_t MACSIO_TIMING_StartTimer(
                 timerHashTable[tid].iter_num++;
             else
                 timerHashTable[tid].iter_num = iter_num;
+            timerHashTable[tid].counter_mask_this_iter = read_perf_counters(timerHashTable[tid].counters_start);
             timerHashTable[tid].start_time = get_current_time();
             return tid;
         }
@@ -280,9 +439,23 @@ double MACSIO_TIMING_StopTimer(MACSIO_TIMING_TimerId_t tid)
 {
     double stop_time = get_current_time();
     double timer_time = stop_time - timerHashTable[tid].start_time;
+    unsigned long long counters_stop[MACSIO_TIMING_NUM_COUNTERS];
+    int i, counter_mask;
 
     if (tid >= MACSIO_TIMING_HASH_TABLE_SIZE) return DBL_MAX;
 
+    /* Accumulate perf counter deltas. A counter remains valid for a timer
+       only if it was available for every iteration of the timer. */
+    counter_mask = timerHashTable[tid].counter_mask_this_iter;
+    if (counter_mask)
+        counter_mask &= read_perf_counters(counters_stop);
+    for (i = 0; i < MACSIO_TIMING_NUM_COUNTERS; i++)
+    {
+        if (counter_mask & (1<<i))
+            timerHashTable[tid].counters[i] += counters_stop[i] - timerHashTable[tid].counters_start[i];
+    }
+    timerHashTable[tid].counter_mask &= counter_mask;
+
     if (timerHashTable[tid].is_restart)
     {
         timerHashTable[tid].total_time_this_iter += timer_time;
@@ -359,6 +532,16 @@ static double get_timer(timerInfo_t const *table, MACSIO_TIMING_TimerId_t tid, c
         return table[tid].running_mean;
     else if (!strncmp(field, "running_var", 11))
         return table[tid].running_var;
+    else
+    {
+        int i;
+        for (i = 0; i < MACSIO_TIMING_NUM_COUNTERS; i++)
+        {
+            if (strcmp(field, perfCounterInfo[i].name)) continue;
+            if (!(table[tid].counter_mask & (1<<i))) return DBL_MAX;
+            return (double) table[tid].counters[i];
+        }
+    }
 
     return DBL_MAX;
 }
@@ -373,6 +556,36 @@ double MACSIO_TIMING_GetReducedTimer(MACSIO_TIMING_TimerId_t tid, char const *fi
     return get_timer(reducedTimerTable, tid, field);
 }
 
+void MACSIO_TIMING_GetIds(
+    MACSIO_TIMING_GroupMask_t gmask,
+    int *cnt,
+    MACSIO_TIMING_TimerId_t **ids
+)
+{
+    int i, n, pass;
+    for (pass = 0; pass < (ids?2:1); pass++)
+    {
+        n = 0;
+        for (i = 0; i < MACSIO_TIMING_HASH_TABLE_SIZE; i++)
+        {
+            if (!strlen(timerHashTable[i].label)) continue;
+            if (!(timerHashTable[i].gmask & gmask)) continue;
+            if (pass == 1)
+                (*ids)[n] = (MACSIO_TIMING_TimerId_t) i;
+            n++;
+        }
+        if (ids && *ids == 0)
+            *ids = (MACSIO_TIMING_TimerId_t *) malloc(n * sizeof(MACSIO_TIMING_TimerId_t));
+    }
+    *cnt = n;
+}
+
+char const *MACSIO_TIMING_GetLabel(MACSIO_TIMING_TimerId_t tid)
+{
+    if (tid >= MACSIO_TIMING_HASH_TABLE_SIZE) return "unknown";
+    return timerHashTable[tid].label;
+}
+
 static void
 clear_timers(timerInfo_t *table, MACSIO_TIMING_GroupMask_t gmask)
 {
@@ -402,6 +615,11 @@ clear_timers(timerInfo_t *table, MACSIO_TIMING_GroupMask_t gmask)
         table[i].is_restart = 0;
         table[i].depth = 0;
         table[i].start_time = 0;
+
+        table[i].counter_mask = 0;
+        table[i].counter_mask_this_iter = 0;
+        memset(table[i].counters, 0, sizeof(table[i].counters));
+        memset(table[i].counters_start, 0, sizeof(table[i].counters_start));
     }
 }
 
@@ -449,6 +667,18 @@ reduce_a_timerinfo(
 
         b_info[i].total_time += a_info[i].total_time;
 
+        /* Counters are summed across ranks but only those available on all ranks
+           that ran the timer are kept */
+        if (strlen(b_info[i].label) == 0)
+            b_info[i].counter_mask = a_info[i].counter_mask;
+        else if (strlen(a_info[i].label) != 0)
+            b_info[i].counter_mask &= a_info[i].counter_mask;
+        {
+            int j;
+            for (j = 0; j < MACSIO_TIMING_NUM_COUNTERS; j++)
+                b_info[i].counters[j] += a_info[i].counters[j];
+        }
+
         if (a_info[i].min_time < b_info[i].min_time)
         {
             b_info[i].min_time = a_info[i].min_time;
@@ -517,6 +747,7 @@ MACSIO_TIMING_ReduceTimers(
 
     if (root == -1)
     {
+        close_perf_counters();
         MPI_Op_free(&timerinfo_reduce_op);
         MPI_Type_free(&str_32_mpi_type);
         MPI_Type_free(&str_64_mpi_type);
@@ -528,9 +759,9 @@ MACSIO_TIMING_ReduceTimers(
     if (first)
     {
         int i;
-        MPI_Aint offsets[5];
-        int lengths[5];
-        MPI_Datatype types[5];
+        MPI_Aint offsets[6];
+        int lengths[6];
+        MPI_Datatype types[6];
 
         MPI_Op_create(reduce_a_timerinfo, 0, &timerinfo_reduce_op);
         MPI_Type_contiguous(32, MPI_CHAR, &str_32_mpi_type);
@@ -538,7 +769,7 @@ MACSIO_TIMING_ReduceTimers(
         MPI_Type_contiguous(64, MPI_CHAR, &str_64_mpi_type);
         MPI_Type_commit(&str_64_mpi_type);
 
-        lengths[0] = 9;
+        lengths[0] = 11;
         types[0] = MPI_INT;
         MPI_Address(&timerHashTable[0], offsets);
         lengths[1] = 7;
@@ -547,14 +778,17 @@ MACSIO_TIMING_ReduceTimers(
         lengths[2] = 1;
         types[2] = MPI_UNSIGNED_LONG_LONG;
         MPI_Address(&timerHashTable[0].gmask, offsets+2);
-        lengths[3] = 1;
-        types[3] = str_32_mpi_type;
-        MPI_Address(&timerHashTable[0].__file__[0], offsets+3);
+        lengths[3] = 2*MACSIO_TIMING_NUM_COUNTERS;
+        types[3] = MPI_UNSIGNED_LONG_LONG;
+        MPI_Address(&timerHashTable[0].counters[0], offsets+3);
         lengths[4] = 1;
-        types[4] = str_64_mpi_type;
-        MPI_Address(&timerHashTable[0].label[0], offsets+4);
-        for (i = 4; i >= 0; offsets[i] -= offsets[0], i--);
-        MPI_Type_struct(5, lengths, offsets, types, &timerinfo_mpi_type);
+        types[4] = str_32_mpi_type;
+        MPI_Address(&timerHashTable[0].__file__[0], offsets+4);
+        lengths[5] = 1;
+        types[5] = str_64_mpi_type;
+        MPI_Address(&timerHashTable[0].label[0], offsets+5);
+        for (i = 5; i >= 0; offsets[i] -= offsets[0], i--);
+        MPI_Type_struct(6, lengths, offsets, types, &timerinfo_mpi_type);
         MPI_Type_commit(&timerinfo_mpi_type);
 
         first = 0;
@@ -569,10 +803,57 @@ MACSIO_TIMING_ReduceTimers(
 #endif
 }
 
+/* Copy src to dst escaping characters special to JSON strings */
+static int
+json_escape(char *dst, int dstlen, char const *src)
+{
+    int n = 0;
+    for (; *src && n < dstlen-2; src++)
+    {
+        if (*src == '"' || *src == '\\')
+            dst[n++] = '\\';
+        dst[n++] = *src;
+    }
+    dst[n] = '\0';
+    return n;
+}
+
+static int
+dump_timer_to_json_string(timerInfo_t const *t, char *str, int max_str_size)
+{
+    char lab[sizeof(t->label)*2], file[sizeof(t->__file__)*2];
+    int len;
+
+    json_escape(lab, sizeof(lab), t->label);
+    json_escape(file, sizeof(file), t->__file__);
+    len = snprintf(str, max_str_size,
+        "{\"label\":\"%s\",\"file\":\"%s\",\"line\":%d,\"count\":%d,\"total\":%.9g,"
+        "\"min\":%.9g,\"min_rank\":%d,\"avg\":%.9g,\"max\":%.9g,\"max_rank\":%d,\"dev\":%.9g",
+        lab, file, t->__line__, t->iter_count, t->total_time,
+        t->min_time, t->min_rank, t->running_mean, t->max_time, t->max_rank, sqrt(t->running_var));
+
+    if (t->counter_mask)
+    {
+        int j;
+        for (j = 0; j < MACSIO_TIMING_NUM_COUNTERS && len < max_str_size; j++)
+        {
+            if (!(t->counter_mask & (1<<j))) continue;
+            len += snprintf(str+len, max_str_size-len, ",\"%s\":%llu",
+                perfCounterInfo[j].name, t->counters[j]);
+        }
+    }
+
+    if (len < max_str_size)
+        len += snprintf(str+len, max_str_size-len, "}");
+    if (len >= max_str_size) len = max_str_size-1;
+    return len;
+}
+
 static void
 dump_timers_to_strings(
     timerInfo_t const *table,
     MACSIO_TIMING_GroupMask_t gmask,
+    int json,
     char ***strs,
     int *nstrs,
     int *maxlen
@@ -602,6 +883,13 @@ dump_timers_to_strings(
 
             _strs[_nstrs-1] = (char *) malloc(max_str_size);
 
+            if (json)
+            {
+                len = dump_timer_to_json_string(&table[i], _strs[_nstrs-1], max_str_size);
+                if (len > _maxlen) _maxlen = len;
+                continue;
+            }
+
             dev = sqrt(table[i].running_var);
             if (dev > 0)
             {
@@ -623,6 +911,22 @@ dump_timers_to_strings(
                 table[i].__line__,
                 table[i].label);
 
+            /* Append any perf counters that are valid for this timer */
+            if (table[i].counter_mask)
+            {
+                int j;
+                for (j = 0; j < MACSIO_TIMING_NUM_COUNTERS && len < max_str_size; j++)
+                {
+                    if (!(table[i].counter_mask & (1<<j))) continue;
+                    len += snprintf(_strs[_nstrs-1]+len, max_str_size-len, ":%s=%llu",
+                        perfCounterInfo[j].abbrev, table[i].counters[j]);
+                }
+                if ((table[i].counter_mask & 0x3) == 0x3 && table[i].counters[0] && len < max_str_size)
+                    len += snprintf(_strs[_nstrs-1]+len, max_str_size-len, ":IPC=%4.2f",
+                        (double) table[i].counters[1] / table[i].counters[0]);
+                if (len >= max_str_size) len = max_str_size-1;
+            }
+
             if (len > _maxlen) _maxlen = len;
         }
 
@@ -643,7 +947,7 @@ MACSIO_TIMING_DumpTimersToStrings(
     int *maxlen
 )
 {
-    dump_timers_to_strings(timerHashTable, gmask, strs, nstrs, maxlen);
+    dump_timers_to_strings(timerHashTable, gmask, 0, strs, nstrs, maxlen);
 }
 
 void MACSIO_TIMING_DumpReducedTimersToStrings(
@@ -653,7 +957,28 @@ void MACSIO_TIMING_DumpReducedTimersToStrings(
     int *maxlen
 )
 {
-    dump_timers_to_strings(reducedTimerTable, gmask, strs, nstrs, maxlen);
+    dump_timers_to_strings(reducedTimerTable, gmask, 0, strs, nstrs, maxlen);
+}
+
+void
+MACSIO_TIMING_DumpTimersToJsonStrings(
+    MACSIO_TIMING_GroupMask_t gmask,
+    char ***strs,
+    int *nstrs,
+    int *maxlen
+)
+{
+    dump_timers_to_strings(timerHashTable, gmask, 1, strs, nstrs, maxlen);
+}
+
+void MACSIO_TIMING_DumpReducedTimersToJsonStrings(
+    MACSIO_TIMING_GroupMask_t gmask,
+    char ***strs,
+    int *nstrs,
+    int *maxlen
+)
+{
+    dump_timers_to_strings(reducedTimerTable, gmask, 1, strs, nstrs, maxlen);
 }
 
 void MACSIO_TIMING_ClearTimers(MACSIO_TIMING_GroupMask_t gmask)
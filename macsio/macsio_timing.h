@@ -81,6 +81,13 @@ examle, we do not worry about timer group masks.
 By default, MACSIO_TIMING uses MPI_Wtime but a caller can set \c MACSIO_TIMING_UseMPI_Wtime() to zero to
 instead use \c gettimeofday().
 
+Optionally, a small group of performance counters (cycles, instructions, last-level cache misses,
+context switches and page faults) can be attached to timers by setting \c MACSIO_TIMING_UsePerfCounters
+to a non-zero value. On Linux, these are obtained via \c perf_event_open(2). Counter values are
+accumulated over all iterations of a timer, summed in reductions and appended to the strings produced by
+\c MACSIO_TIMING_DumpTimersToStrings(). Any counter that cannot be opened on a given system (e.g. due to
+permissions or lack of kernel or hardware support) is simply omitted.
+
 @{
 */
 
@@ -153,6 +160,17 @@ use \c gettimeofday().
 */
 extern int                       MACSIO_TIMING_UseMPI_Wtime;
 
+/*!
+\brief Integer variable to control collection of performance counters with timers
+
+A non-zero value indicates that MACSIO_TIMING should sample the process' performance
+counters (where available) whenever a timer is started and stopped. Counter values
+can be retrieved using field names \c cycles, \c instructions, \c llc_misses,
+\c ctx_switches and \c page_faults in \c MACSIO_TIMING_GetTimer(). A value of
+\c DBL_MAX is returned for counters that are unavailable.
+*/
+extern int                       MACSIO_TIMING_UsePerfCounters;
+
 /*!
 \brief Create a group name and mask
 
@@ -206,6 +224,26 @@ MACSIO_TIMING_GetReducedTimer(
     char const *field            /**< The name of the field from the timer to return */
 );
 
+/*!
+\brief Get the IDs of all timers in a group
+
+Finds all used timers in the hash table matching the specified \c gmask group mask. If \c *ids
+is zero on entry, an array for the IDs is allocated and the caller is responsible for freeing it.
+Passing \c ids as zero only returns the count.
+*/
+extern void
+MACSIO_TIMING_GetIds(
+    MACSIO_TIMING_GroupMask_t gmask, /**< Group mask to filter only timers belonging to specific groups */
+    int *cnt,                        /**< Number of matching timers returned to caller */
+    MACSIO_TIMING_TimerId_t **ids    /**< Array of matching timer IDs returned to caller */
+);
+
+/*!
+\brief Get the user defined label of a timer
+*/
+extern char const *
+MACSIO_TIMING_GetLabel(MACSIO_TIMING_TimerId_t tid /**< The timer's ID, returned from a call to StartTimer */);
+
 /*!
 \brief Dump timers to ascii strings
 
@@ -219,6 +257,19 @@ extern void MACSIO_TIMING_DumpTimersToStrings(
     int *nstrs,                      /**< Number of strings returned to caller */
     int *maxlen                      /**< The maximum length of all strings */); 
 
+/*!
+\brief Dump timers to JSON strings
+
+Like \c DumpTimersToStrings except each string is a single line JSON object holding the
+timer's label, file, line, count, total, min, avg, max and dev along with any valid perf
+counters by name. Intended for writing timings in JSON lines format for post-processing.
+*/
+extern void MACSIO_TIMING_DumpTimersToJsonStrings(
+    MACSIO_TIMING_GroupMask_t gmask, /**< Group mask to filter only timers belonging to specific groups */
+    char ***strs,                    /**< An array of strings, one for each timer, returned to caller. Caller is responsible for freeing */
+    int *nstrs,                      /**< Number of strings returned to caller */
+    int *maxlen                      /**< The maximum length of all strings */);
+
 /*!
 \brief Reduce timers across MPI tasks
 
@@ -245,6 +296,18 @@ MACSIO_TIMING_DumpReducedTimersToStrings(
     int *nstrs,                      /**< Number of strings returned to caller */
     int *maxlen                      /**< The maximum length of all strings */);
 
+/*!
+\brief Dump reduced timers to JSON strings
+
+Similar to \c DumpTimersToJsonStrings except this call dumps reduced timers
+*/
+extern void
+MACSIO_TIMING_DumpReducedTimersToJsonStrings(
+    MACSIO_TIMING_GroupMask_t gmask, /**< Group mask to filter only timers belonging to specific groups */
+    char ***strs,                    /**< An array of strings, one for each timer, returned to caller. Caller is responsible for freeing */
+    int *nstrs,                      /**< Number of strings returned to caller */
+    int *maxlen                      /**< The maximum length of all strings */);
+
 /*!
 \brief Clear a group of timers
 
@@ -0,0 +1,240 @@
+/*
+Copyright (c) 2015, Lawrence Livermore National Security, LLC.
+Produced at the Lawrence Livermore National Laboratory.
+Written by Mark C. Miller
+
+LLNL-CODE-676051. All rights reserved.
+
+This file is part of MACSio
+
+Please also read the LICENSE file at the top of the source code directory or
+folder hierarchy.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License (as published by the Free Software
+Foundation) version 2, dated June 1991.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the terms and conditions of the GNU General
+Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+/*
+Summarize and compare MACSio timings files written with --timings_format jsonl.
+
+    tstat run.log
+        Merge the per-rank timer records of a run and print, for each timer label,
+        the number of ranks, total iteration count and the min, avg and max over
+        ranks of the total time along with the imbalance (max/avg).
+
+    tstat [--threshold PCT] [--min_time SECS] --baseline base.log run.log ...
+        Compare one or more runs to a saved baseline run. For each label, the max
+        over ranks of the total time is compared. A label is flagged as a REGRESSION
+        when it is more than PCT percent (default 10) slower than the baseline and
+        the difference exceeds SECS seconds (default 0.001). The exit status is 1
+        if any regression is found.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <json-cwx/json.h>
+
+/* Returns an object keyed by timer label. Each member is an object holding
+   "count" and "ranks", an object keyed by rank of that rank's total time. */
+static json_object *
+load_run(char const *filename)
+{
+    FILE *f = fopen(filename, "r");
+    json_object *run;
+    char *line = 0;
+    size_t linecap = 0;
+    int lineno = 0;
+
+    if (!f)
+    {
+        fprintf(stderr, "tstat: unable to open \"%s\"\n", filename);
+        return 0;
+    }
+
+    run = json_object_new_object();
+    while (getline(&line, &linecap, f) > 0)
+    {
+        json_object *rec = json_tokener_parse(line);
+        json_object *val, *timer, *ranks;
+        char rankstr[32];
+        double total, prev = 0;
+
+        lineno++;
+        if (!rec)
+        {
+            fprintf(stderr, "tstat: \"%s\":%d: not a JSON record\n", filename, lineno);
+            continue;
+        }
+
+        if (!json_object_object_get_ex(rec, "record", &val) ||
+            strcmp(json_object_get_string(val), "timer"))
+        {
+            json_object_put(rec);
+            continue;
+        }
+
+        json_object_object_get_ex(rec, "label", &val);
+        if (!json_object_object_get_ex(run, json_object_get_string(val), &timer))
+        {
+            timer = json_object_new_object();
+            json_object_object_add(timer, "count", json_object_new_int(0));
+            json_object_object_add(timer, "ranks", json_object_new_object());
+            json_object_object_add(run, json_object_get_string(val), timer);
+        }
+
+        json_object_object_get_ex(timer, "count", &val);
+        {
+            json_object *cnt;
+            json_object_object_get_ex(rec, "count", &cnt);
+            json_object_object_add(timer, "count",
+                json_object_new_int(json_object_get_int(val) + json_object_get_int(cnt)));
+        }
+
+        /* distinct timers on a rank may share a label; combine them */
+        json_object_object_get_ex(rec, "rank", &val);
+        snprintf(rankstr, sizeof(rankstr), "%d", json_object_get_int(val));
+        json_object_object_get_ex(rec, "total", &val);
+        total = json_object_get_double(val);
+        json_object_object_get_ex(timer, "ranks", &ranks);
+        if (json_object_object_get_ex(ranks, rankstr, &val))
+            prev = json_object_get_double(val);
+        json_object_object_add(ranks, rankstr, json_object_new_double(prev + total));
+
+        json_object_put(rec);
+    }
+
+    free(line);
+    fclose(f);
+    return run;
+}
+
+/* Statistics over ranks of a timer's total time */
+static void
+timer_stats(json_object *timer, int *nranks, int *count, double *min, double *avg, double *max)
+{
+    json_object *ranks, *val;
+    struct json_object_iter iter;
+    double sum = 0;
+
+    json_object_object_get_ex(timer, "count", &val);
+    *count = json_object_get_int(val);
+    *nranks = 0;
+    *min = *max = 0;
+    json_object_object_get_ex(timer, "ranks", &ranks);
+    json_object_object_foreachC(ranks, iter)
+    {
+        double t = json_object_get_double(iter.val);
+        if (*nranks == 0 || t < *min) *min = t;
+        if (*nranks == 0 || t > *max) *max = t;
+        sum += t;
+        (*nranks)++;
+    }
+    *avg = *nranks ? sum / *nranks : 0;
+}
+
+static void
+summarize(char const *filename, json_object *run)
+{
+    printf("%s\n", filename);
+    printf("%-40s %6s %8s %12s %12s %12s %8s\n", "label", "ranks", "count", "min", "avg", "max", "imbal");
+    {
+        json_object_object_foreach(run, label, timer)
+        {
+            int nranks, count;
+            double min, avg, max;
+            timer_stats(timer, &nranks, &count, &min, &avg, &max);
+            printf("%-40s %6d %8d %12.6f %12.6f %12.6f %8.3f\n", label, nranks, count,
+                min, avg, max, avg > 0 ? max / avg : 1.0);
+        }
+    }
+}
+
+static int
+compare(char const *filename, json_object *run, json_object *base, double threshold, double min_time)
+{
+    int regressions = 0;
+
+    printf("%s vs. baseline\n", filename);
+    printf("%-40s %12s %12s %9s\n", "label", "base max", "max", "change");
+    {
+        json_object_object_foreach(run, label, timer)
+        {
+            json_object *base_timer;
+            int nranks, count;
+            double min, avg, max, bmax, change;
+
+            timer_stats(timer, &nranks, &count, &min, &avg, &max);
+            if (!json_object_object_get_ex(base, label, &base_timer))
+            {
+                printf("%-40s %12s %12.6f %9s\n", label, "-", max, "new");
+                continue;
+            }
+            timer_stats(base_timer, &nranks, &count, &min, &avg, &bmax);
+            change = bmax > 0 ? 100 * (max - bmax) / bmax : 0;
+            printf("%-40s %12.6f %12.6f %8.1f%%", label, bmax, max, change);
+            if (change > threshold && max - bmax > min_time)
+            {
+                printf("  REGRESSION");
+                regressions++;
+            }
+            printf("\n");
+        }
+    }
+
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    char const *baseline = 0;
+    double threshold = 10, min_time = 0.001;
+    json_object *base = 0;
+    int i, regressions = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--baseline") && i+1 < argc)
+            baseline = argv[++i];
+        else if (!strcmp(argv[i], "--threshold") && i+1 < argc)
+            threshold = strtod(argv[++i], 0);
+        else if (!strcmp(argv[i], "--min_time") && i+1 < argc)
+            min_time = strtod(argv[++i], 0);
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "usage: %s [--threshold PCT] [--min_time SECS] [--baseline FILE] FILE...\n", argv[0]);
+            return 2;
+        }
+        else
+            break;
+    }
+
+    if (baseline && !(base = load_run(baseline)))
+        return 2;
+
+    for (; i < argc; i++)
+    {
+        json_object *run = load_run(argv[i]);
+        if (!run) return 2;
+        if (base)
+            regressions += compare(argv[i], run, base, threshold, min_time);
+        else
+            summarize(argv[i], run);
+        json_object_put(run);
+    }
+
+    if (base) json_object_put(base);
+
+    return regressions ? 1 : 0;
+}
@@ -48,6 +48,8 @@ int main (int argc, char **argv)
             num_rows = strtol(argv[i]+9, 0, 10);
         else if (!strncasecmp(argv[i], "extra_lines=", 9))
             extra_lines = strtol(argv[i]+9, 0, 10);
+        else if (!strcasecmp(argv[i], "mpiio"))
+            MACSIO_LOG_UseMPIIO = 1;
     }
 
 #ifdef HAVE_MPI
@@ -25,6 +25,7 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 */
 
 #include <stdlib.h>
+#include <strings.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -83,6 +84,12 @@ int main(int argc, char **argv)
     char **timer_strs;
     int ntimer_strs, maxstrlen;
 
+    for (i = 0; i < argc; i++)
+    {
+        if (!strcasecmp(argv[i], "perf_counters"))
+            MACSIO_TIMING_UsePerfCounters = 1;
+    }
+
 #ifdef HAVE_MPI
     MPI_Init(&argc, &argv);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
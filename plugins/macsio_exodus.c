@@ -406,6 +406,7 @@ static void write_mesh_part_blocks_and_vars(int exoid, ex_global_init_params_t c
         {
             json_object *varobj = json_object_array_get_idx(vars_array, i);
             if (strcmp(JsonGetStr(varobj, "centering"), "zone")) continue;
+            if (strcmp(JsonGetStr(varobj, "type"), "scalar")) continue;
             num_elem_vars++;
         }
         if (num_elem_vars)
@@ -417,6 +418,7 @@ static void write_mesh_part_blocks_and_vars(int exoid, ex_global_init_params_t c
         {
             json_object *varobj = json_object_array_get_idx(vars_array, i);
             if (strcmp(JsonGetStr(varobj, "centering"), "zone")) continue;
+            if (strcmp(JsonGetStr(varobj, "type"), "scalar")) continue;
             elem_var_names[ev] = (char *) malloc((MAX_STRING_LEN+1) * sizeof (char));
             snprintf(elem_var_names[ev], MAX_STRING_LEN, "%s", JsonGetStr(varobj, "name"));
             ev++;
@@ -443,6 +445,7 @@ static void write_mesh_part_blocks_and_vars(int exoid, ex_global_init_params_t c
             void *vbuf = 0;
 
             if (strcmp(JsonGetStr(varobj, "centering"), "zone")) continue;
+            if (strcmp(JsonGetStr(varobj, "type"), "scalar")) continue;
 
             if (params->cpu_word_size == sizeof(double) && etype != json_extarr_type_flt64)
                 json_object_extarr_data_as_double(dataobj, (double**) &vbuf);
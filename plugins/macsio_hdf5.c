@@ -24,6 +24,7 @@ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
 Place, Suite 330, Boston, MA 02111-1307 USA
 */
 
+#include <fnmatch.h>
 #include <limits.h>
 #include <math.h>
 #include <stdlib.h>
@@ -31,12 +32,15 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #include <string.h>
 
 #include <json-cwx/json.h>
+#include <pthread.h>
+#include <zlib.h>
 
 #include <macsio_clargs.h>
 #include <macsio_iface.h>
 #include <macsio_log.h>
 #include <macsio_main.h>
 #include <macsio_mif.h>
+#include <macsio_timing.h>
 #include <macsio_utils.h>
 
 #ifdef HAVE_MPI
@@ -676,18 +680,47 @@ static char const *iface_ext = "h5";
 static int use_log = 0;
 static int no_collective = 0;
 static int no_single_chunk = 0;
+static int chunk_parts = 0;
+static int mif_packed = 0;
+static char mif_images_str[64];
+static int alignment = 0;
+static int compress_threads = 0;
+static int compress_chunk_size = 1<<20;
 static int silo_block_size = 0;
 static int silo_block_count = 0;
 static int sbuf_size = -1;
 static int mbuf_size = -1;
 static int rbuf_size = -1;
 static int lbuf_size = 0;
+static char fs_strategy_str[64];
+static int fs_page_size = -1;
+static int page_buf_size = -1;
+static int mdc_initial_size = 16 * 1024;
+static int mdc_min_size = 8 * 1024;
+static int mdc_max_size = 32 * 1024 * 1024;
+static int collective_metadata = 0;
+static json_object *log_names = 0; /* logs of the log VFD written this dump */
 static const char *filename;
 static hid_t fid;
 static hid_t dspc = -1;
 static int show_errors = 0;
 static char compression_alg_str[64];
 static char compression_params_str[512];
+static char compression_policy_str[1024];
+
+/* Paths queried for every part and var, compiled once at registration */
+static struct json_path *vars_path;
+static struct json_path *mesh_log_dims_path;
+static struct json_path *global_log_origin_path;
+static struct json_path *global_log_indices_path;
+static struct json_path *chunk_id_path;
+static struct json_path *data_path;
+static struct json_path *name_path;
+static struct json_path *centering_path;
+static struct json_path *type_path;
+static struct json_path *layout_path;
+static struct json_path *components_path;
+static struct json_path *subset_path;
 
 static hid_t make_fapl()
 {
@@ -701,7 +734,10 @@ static hid_t make_fapl()
         h5status |= H5Pset_meta_block_size(fapl_id, mbuf_size);
 
     if (rbuf_size >= 0)
-        h5status |= H5Pset_small_data_block_size(fapl_id, mbuf_size);
+        h5status |= H5Pset_small_data_block_size(fapl_id, rbuf_size);
+
+    if (alignment > 0)
+        h5status |= H5Pset_alignment(fapl_id, (hsize_t) alignment, (hsize_t) alignment);
 
 #if 0
     if (silo_block_size && silo_block_count)
@@ -710,16 +746,6 @@ static hid_t make_fapl()
         h5status |= H5Pset_silo_block_size_and_count(fapl_id, (hsize_t) silo_block_size,
             silo_block_count);
     }
-    else
-    if (use_log)
-    {
-        int flags = H5FD_LOG_LOC_IO|H5FD_LOG_NUM_IO|H5FD_LOG_TIME_IO|H5FD_LOG_ALLOC;
-
-        if (lbuf_size > 0)
-            flags = H5FD_LOG_ALL;
-
-        h5status |= H5Pset_fapl_log(fapl_id, "macsio_hdf5_log.out", flags, lbuf_size);
-    }
 #endif
 
     {
@@ -728,16 +754,23 @@ static hid_t make_fapl()
         /* Acquire a default mdc config struct */
         config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
         H5Pget_mdc_config(fapl_id, &config);
-#define MAINZER_PARAMS 1
-#if MAINZER_PARAMS
         config.set_initial_size = (hbool_t) 1;
-        config.initial_size = 16 * 1024;
-        config.min_size = 8 * 1024;
+        config.initial_size = (size_t) mdc_initial_size;
+        config.min_size = (size_t) mdc_min_size;
+        config.max_size = (size_t) mdc_max_size;
         config.epoch_length = 3000;
         config.lower_hr_threshold = 0.95;
-#endif
-        H5Pset_mdc_config(fapl_id, &config);
+        h5status |= H5Pset_mdc_config(fapl_id, &config);
+    }
+
+#if H5_HAVE_PARALLEL
+    /* only matters for files opened with the MPI-IO VFD, as in SIF mode */
+    if (collective_metadata)
+    {
+        h5status |= H5Pset_all_coll_metadata_ops(fapl_id, (hbool_t) 1);
+        h5status |= H5Pset_coll_metadata_write(fapl_id, (hbool_t) 1);
     }
+#endif
 
     if (h5status < 0)
     {
@@ -749,6 +782,143 @@ static hid_t make_fapl()
     return fapl_id;
 }
 
+/* File creation properties of the files of a dump, with the file space strategy and
+   page size of --fs_strategy and --fs_page_size */
+static hid_t make_fcpl()
+{
+    hid_t fcpl_id = H5Pcreate(H5P_FILE_CREATE);
+
+#if H5_VERSION_GE(1,10,1)
+    static char const *names[] = {"fsm_aggr", "page", "aggr", "none"};
+    static H5F_fspace_strategy_t const strategies[] = {H5F_FSPACE_STRATEGY_FSM_AGGR,
+        H5F_FSPACE_STRATEGY_PAGE, H5F_FSPACE_STRATEGY_AGGR, H5F_FSPACE_STRATEGY_NONE};
+    int i;
+
+    for (i = 0; i < (int) (sizeof(names) / sizeof(names[0])); i++)
+    {
+        if (!strcmp(fs_strategy_str, names[i]))
+            H5Pset_file_space_strategy(fcpl_id, strategies[i], (hbool_t) 0, (hsize_t) 1);
+    }
+    if (fs_page_size > 0)
+        H5Pset_file_space_page_size(fcpl_id, (hsize_t) fs_page_size);
+#endif
+
+    return fcpl_id;
+}
+
+/* File access properties of a file of a dump. On top of make_fapl()'s, a page buffer
+   when the file is paged and, with --log, the log VFD writing to a log per file and
+   rank, which log_io_histograms() summarizes at the end of the dump. */
+static hid_t make_dump_fapl(char const *fileName)
+{
+    hid_t fapl_id = make_fapl();
+
+#if H5_VERSION_GE(1,10,1)
+    if (page_buf_size > 0 && !strcmp(fs_strategy_str, "page"))
+        H5Pset_page_buffer_size(fapl_id, (size_t) page_buf_size, 0, 0);
+#endif
+
+    if (use_log && fileName)
+    {
+        char logName[300];
+        int flags = H5FD_LOG_LOC_IO|H5FD_LOG_NUM_IO|H5FD_LOG_TIME_IO|H5FD_LOG_ALLOC;
+
+        /* per-byte counts and flavors need a buffer as large as the file */
+        if (lbuf_size > 0)
+            flags = H5FD_LOG_ALL;
+
+        snprintf(logName, sizeof(logName), "%s.%05d.log", fileName, MACSIO_MAIN_Rank);
+        H5Pset_fapl_log(fapl_id, logName, flags, (size_t) MU_MAX(lbuf_size, 0));
+        if (!log_names)
+            log_names = json_object_new_array();
+        json_object_array_add(log_names, json_object_new_string(logName));
+    }
+
+    return fapl_id;
+}
+
+/*!
+\brief Summarize the I/O operations the log VFD logged for a file
+
+Each read and write the log VFD logs is counted in a histogram by the power of 2 its
+size rounds up to, with raw data and metadata operations apart. The histogram is
+appended to the log and its totals, raw data plus metadata operations, are logged.
+*/
+static void
+log_io_histogram(char const *logName)
+{
+    enum {MIN_LOG2 = 9, MAX_LOG2 = 30, NBINS = MAX_LOG2 - MIN_LOG2 + 1};
+    static char const *cols[] = {"raw writes", "meta writes", "raw reads", "meta reads"};
+    int counts[NBINS][4], totals[4] = {0, 0, 0, 0};
+    double nbytes[2] = {0, 0};
+    char line[512], wr_str[32], rd_str[32];
+    int i, j;
+    FILE *f = fopen(logName, "r+");
+
+    if (!f)
+    {
+        MACSIO_LOG_MSG(Warn, ("Unable to open HDF5 log \"%s\"", logName));
+        return;
+    }
+
+    memset(counts, 0, sizeof(counts));
+    while (fgets(line, sizeof(line), f))
+    {
+        unsigned long size;
+        char flavor[64], op[16];
+        int bin = MIN_LOG2, col;
+
+        /* e.g. "  2048-  402047 (  400000 bytes) (H5FD_MEM_DRAW) Written (0.000360s @ ...)" */
+        if (sscanf(line, "%*[^(](%lu bytes) (%63[^)]) %15s", &size, flavor, op) != 3)
+            continue;
+        if (strcmp(op, "Written") && strcmp(op, "Read"))
+            continue;
+        col = (op[0] == 'R' ? 2 : 0) + (strcmp(flavor, "H5FD_MEM_DRAW") ? 1 : 0);
+        while (bin < MAX_LOG2 && ((unsigned long) 1 << bin) < size)
+            bin++;
+        counts[bin - MIN_LOG2][col]++;
+        totals[col]++;
+        nbytes[col / 2] += size;
+    }
+
+    fseek(f, 0, SEEK_END);
+    fprintf(f, "I/O operation histogram, operations by size:\n%12s", "size <=");
+    for (j = 0; j < 4; j++)
+        fprintf(f, " %12s", cols[j]);
+    fprintf(f, "\n");
+    for (i = 0; i < NBINS; i++)
+    {
+        if (!counts[i][0] && !counts[i][1] && !counts[i][2] && !counts[i][3])
+            continue;
+        if (i == NBINS - 1)
+            fprintf(f, "%12s", "larger");
+        else
+            fprintf(f, "%12lu", (unsigned long) 1 << (i + MIN_LOG2));
+        for (j = 0; j < 4; j++)
+            fprintf(f, " %12d", counts[i][j]);
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    errno = 0; /* left set by HDF5, not an error */
+
+    MACSIO_LOG_MSG(Info, ("%s: %d+%d writes %s, %d+%d reads %s", logName, totals[0], totals[1],
+        MU_PrByts(nbytes[0], "%.3f", wr_str, sizeof(wr_str)), totals[2], totals[3],
+        MU_PrByts(nbytes[1], "%.3f", rd_str, sizeof(rd_str))));
+}
+
+/* Summarize the logs of the log VFD written this dump */
+static void
+log_io_histograms()
+{
+    int i;
+
+    for (i = 0; log_names && i < json_object_array_length(log_names); i++)
+        log_io_histogram(json_object_get_string(json_object_array_get_idx(log_names, i)));
+    if (log_names)
+        json_object_put(log_names);
+    log_names = 0;
+}
+
 static int
 get_tokval(char const *src_str, char const *token_to_match, void *val_ptr)
 {
@@ -926,12 +1096,394 @@ static hid_t make_dcpl(char const *alg_str, char const *params_str, hid_t space_
     return retval;
 }
 
+/*!
+\brief HDF5 datatype of a var
+
+Vector and tensor vars in the aos layout are written as a compound type with a
+member for each component so that their interleaved buffer is written as is.
+All other vars are written with the native type of their data. Those in the soa
+layout get an extra, slowest varying dimension for the component instead. The
+caller must close the returned type with H5Tclose().
+
+\return The datatype and, in \c nsoa, 1 if the var's dataspace needs a
+component dimension and 0 otherwise.
+*/
+static hid_t
+var_dtype(
+    json_object *var_obj, /**< [in] The var object */
+    int *ncomps,          /**< [out] The number of components of the var (1 for scalar vars) */
+    int *nsoa             /**< [out] 1 for a multi-component var in the soa layout */
+)
+{
+    json_object *data_obj = json_path_get_object(var_obj, data_path);
+    json_object *comps_obj = json_path_get_object(var_obj, components_path);
+    hid_t base_id = json_object_extarr_type(data_obj)==json_extarr_type_flt64?
+        H5T_NATIVE_DOUBLE:H5T_NATIVE_INT;
+    size_t size = H5Tget_size(base_id);
+    hid_t dtype_id;
+    int c;
+
+    *ncomps = comps_obj ? json_object_array_length(comps_obj) : 1;
+    *nsoa = comps_obj && strcmp(json_path_get_string(var_obj, layout_path), "aos") ? 1 : 0;
+    if (!comps_obj || *nsoa)
+        return H5Tcopy(base_id);
+
+    dtype_id = H5Tcreate(H5T_COMPOUND, *ncomps * size);
+    for (c = 0; c < *ncomps; c++)
+        H5Tinsert(dtype_id, json_object_get_string(json_object_array_get_idx(comps_obj, c)),
+            c * size, base_id);
+    return dtype_id;
+}
+
+/* A string with the white space at its ends cut off, in place */
+static char *
+trim_space(char *str)
+{
+    size_t n;
+
+    str += strspn(str, " \t\r");
+    n = strlen(str);
+    while (n && strchr(" \t\r", str[n-1]))
+        str[--n] = '\0';
+    return str;
+}
+
+/*!
+\brief Parse the rules of \c --compress_policy
+
+The policy is either the name of a file holding a rule per line, with blank lines and
+lines starting with \c # ignored, or the rules themselves separated by semicolons.
+
+\return An array of the rules, each an array of its match, algorithm and params
+*/
+static json_object *
+parse_compression_policy(char const *policy)
+{
+    json_object *rules = json_object_new_array();
+    FILE *f = fopen(policy, "r");
+    char *text, *line, *tofree;
+    char const *seps = ";";
+
+    if (f)
+    {
+        long len;
+        fseek(f, 0, SEEK_END);
+        len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        text = (char *) calloc(len + 1, 1);
+        len = (long) fread(text, 1, len, f);
+        fclose(f);
+        seps = "\n";
+    }
+    else
+    {
+        text = strdup(policy);
+        errno = 0;
+    }
+
+    tofree = text;
+    while ((line = strsep(&text, seps)) != NULL)
+    {
+        char *match, *alg, *params;
+        json_object *rule;
+
+        line = trim_space(line);
+        if (!line[0] || line[0] == '#')
+            continue;
+        match = trim_space(strsep(&line, ":"));
+        alg = line ? trim_space(strsep(&line, ":")) : 0;
+        if (!alg || !alg[0])
+        {
+            MACSIO_LOG_MSG(Warn, ("Ignoring compression policy rule \"%s\" without an algorithm", match));
+            continue;
+        }
+        params = line ? trim_space(line) : alg + strlen(alg);
+        rule = json_object_new_array();
+        json_object_array_add(rule, json_object_new_string(match));
+        json_object_array_add(rule, json_object_new_string(alg));
+        json_object_array_add(rule, json_object_new_string(params));
+        json_object_array_add(rules, rule);
+    }
+    free(tofree);
+    return rules;
+}
+
+/* Whether a policy rule's match applies to a var. A kind=<k> match applies to vars
+   whose data type (int or double), type (e.g. subset) or centering (node or zone) is
+   k. Any other match is a glob on the var's name. With no var object, as for mesh
+   datasets and the indices of subset vars, only globs apply. */
+static int
+policy_rule_matches(char const *match, char const *name, json_object *var_obj)
+{
+    if (strncmp(match, "kind=", 5))
+        return fnmatch(match, name, 0) == 0;
+    if (!var_obj)
+        return 0;
+    match += 5;
+    if (!strcmp(match, json_object_extarr_type(json_path_get_object(var_obj, data_path)) ==
+            json_extarr_type_flt64 ? "double" : "int"))
+        return 1;
+    return !strcmp(match, json_path_get_string(var_obj, type_path)) ||
+           !strcmp(match, json_path_get_string(var_obj, centering_path));
+}
+
+/*!
+\brief Compress a sample of a var with a codec to see how it fares
+
+The sample is written to a dataset of an in-memory file made with the core VFD,
+with the same filters \c make_dcpl() would set up.
+
+\return The bytes the sample was stored in, with the seconds writing it took in \c secs
+*/
+static hsize_t
+trial_compress(char const *alg, char const *params, hid_t dtype_id, void const *buf,
+    hsize_t nvals, double *secs)
+{
+    char name[64], trial_params[600];
+    hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+    hid_t fid, space_id, dcpl_id, ds_id;
+    hsize_t nbytes;
+    double t0;
+
+    H5Pset_fapl_core(fapl_id, 1<<20, 0);
+    snprintf(name, sizeof(name), "macsio_hdf5_trial_%05d", MACSIO_MAIN_Rank);
+    fid = H5Fcreate(name, H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
+    H5Pclose(fapl_id);
+
+    snprintf(trial_params, sizeof(trial_params), "%s%sminsize=0", params, params[0] ? "," : "");
+    space_id = H5Screate_simple(1, &nvals, 0);
+    dcpl_id = make_dcpl(alg, trial_params, space_id, dtype_id);
+    ds_id = H5Dcreate1(fid, "trial", dtype_id, space_id, dcpl_id);
+
+    /* the chunk is compressed when it leaves the chunk cache, here on close */
+    t0 = MT_Time();
+    H5Dwrite(ds_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf);
+    H5Dclose(ds_id);
+    *secs = MT_Time() - t0;
+
+    ds_id = H5Dopen2(fid, "trial", H5P_DEFAULT);
+    nbytes = H5Dget_storage_size(ds_id);
+    H5Dclose(ds_id);
+    H5Pclose(dcpl_id);
+    H5Sclose(space_id);
+    H5Fclose(fid);
+    return nbytes;
+}
+
+/*!
+\brief Pick the codec that writes a var fastest at a target bandwidth
+
+A sample of the var's values, \c sample=%d of them (default 65536), is compressed
+with each candidate codec. A codec's time to write a byte of the var is its time to
+compress it plus the time to write the compressed byte at the target bandwidth,
+\c target_bw=%f bytes per second (default 1e9), the same as a best ratio times
+throughput trade-off. Writing the var uncompressed is a candidate too. Only lossless
+codecs are candidates.
+*/
+static void
+choose_codec(json_object *var_obj, char const *auto_params, char *alg, char *params, size_t len)
+{
+    static char const *candidates[][2] = {
+        {"gzip", "level=1"},
+        {"gzip", "shuffle=0,level=1"},
+        {"gzip", "level=4"},
+        {"gzip", "level=9"},
+#ifdef HAVE_SZIP
+        {"szip", ""},
+        {"szip", "method=ec"},
+#endif
+    };
+    json_object *data_obj = json_path_get_object(var_obj, data_path);
+    char const *name = json_path_get_string(var_obj, name_path);
+    hid_t dtype_id = json_object_extarr_type(data_obj) == json_extarr_type_flt64 ?
+        H5T_NATIVE_DOUBLE : H5T_NATIVE_INT;
+    hsize_t raw_nbytes, nvals = json_object_extarr_nvals(data_obj);
+    int i, sample = 65536, best = -1;
+    float target_bw = 1e9;
+    double best_time, best_ratio = 1;
+    char *token, *string, *tofree;
+
+    tofree = string = strdup(auto_params);
+    while ((token = strsep(&string, ",")) != NULL)
+    {
+        if (get_tokval(token, "sample=%d", &sample))
+            continue;
+        get_tokval(token, "target_bw=%f", &target_bw);
+    }
+    free(tofree);
+
+    if ((hsize_t) sample < nvals)
+        nvals = sample;
+    raw_nbytes = nvals * H5Tget_size(dtype_id);
+    best_time = 1 / (double) target_bw; /* uncompressed */
+
+    for (i = 0; nvals && i < (int) (sizeof(candidates) / sizeof(candidates[0])); i++)
+    {
+        double secs, time, ratio;
+        hsize_t nbytes = trial_compress(candidates[i][0], candidates[i][1], dtype_id,
+            json_object_extarr_data(data_obj), nvals, &secs);
+
+        if (!nbytes)
+            continue;
+        ratio = (double) raw_nbytes / nbytes;
+        time = secs / raw_nbytes + 1 / (ratio * target_bw);
+        if (time < best_time)
+        {
+            best = i;
+            best_time = time;
+            best_ratio = ratio;
+        }
+    }
+
+    snprintf(alg, len, "%s", best < 0 ? "" : candidates[best][0]);
+    snprintf(params, len, "%s", best < 0 ? "" : candidates[best][1]);
+    errno = 0; /* left set by the trials, not an error */
+    MACSIO_LOG_MSG(Info, ("Auto compression of \"%s\": %s %s, ratio %.3f", name,
+        best < 0 ? "none" : alg, params, best_ratio));
+}
+
+static json_object *policy_rules = 0;   /* rules of --compress_policy */
+static json_object *policy_choices = 0; /* codec chosen for each var, kept across dumps */
+
+/* The algorithm and params of the first policy rule matching a var, else those of
+   --compression */
+static void
+policy_rule(char const *name, json_object *var_obj, char const **alg, char const **params)
+{
+    int i;
+
+    *alg = compression_alg_str;
+    *params = compression_params_str;
+    for (i = 0; policy_rules && i < json_object_array_length(policy_rules); i++)
+    {
+        json_object *rule = json_object_array_get_idx(policy_rules, i);
+        if (policy_rule_matches(json_object_get_string(json_object_array_get_idx(rule, 0)), name, var_obj))
+        {
+            *alg = json_object_get_string(json_object_array_get_idx(rule, 1));
+            *params = json_object_get_string(json_object_array_get_idx(rule, 2));
+            return;
+        }
+    }
+}
+
+/* The algorithm and params for a dataset, the choice made for its var if there is one.
+   Empty for none, as for auto with no choice made, such as for mesh datasets. */
+static void
+policy_lookup(char const *name, char const **alg, char const **params)
+{
+    json_object *choice;
+
+    if (policy_choices && json_object_object_get_ex(policy_choices, name, &choice))
+    {
+        *alg = json_object_get_string(json_object_array_get_idx(choice, 0));
+        *params = json_object_get_string(json_object_array_get_idx(choice, 1));
+        return;
+    }
+    policy_rule(name, 0, alg, params);
+    if (!strcmp(*alg, "none") || !strcmp(*alg, "auto"))
+        *alg = "";
+}
+
+/* Dataset creation properties for a dataset, compressed as the policy says */
+static hid_t
+make_var_dcpl(char const *name, hid_t space_id, hid_t dtype_id)
+{
+    char const *alg, *params;
+
+    policy_lookup(name, &alg, &params);
+    return make_dcpl(alg, params, space_id, dtype_id);
+}
+
+/*!
+\brief Decide how to compress each var of a dump
+
+Each var of this rank's first part is matched against the \c --compress_policy
+rules, in order, falling back to \c --compression. Vars whose codec is \c auto get
+one picked by \c choose_codec(). Choices are kept for later dumps, so sampling only
+happens the first time a var is seen. Only the lowest rank with parts decides, and
+all ranks use its choices, so that datasets shared by ranks in SIF mode are created
+alike.
+*/
+static void
+resolve_compression(json_object *main_obj)
+{
+    json_object *parts = json_object_path_get_array(main_obj, "problem/parts");
+    json_object *vars_array = json_object_array_length(parts) ?
+        json_path_get_object(json_object_array_get_idx(parts, 0), vars_path) : 0;
+    int i, root = 0;
+
+    /* the policy is the same for every dump */
+    if (!policy_rules && strlen(compression_policy_str))
+        policy_rules = parse_compression_policy(compression_policy_str);
+    if (!policy_rules && strcmp(compression_alg_str, "auto"))
+        return;
+    if (!policy_choices)
+        policy_choices = json_object_new_object();
+
+#ifdef HAVE_MPI
+    {
+        int has_parts = vars_array ? MACSIO_MAIN_Rank : MACSIO_MAIN_Size;
+        MPI_Allreduce(&has_parts, &root, 1, MPI_INT, MPI_MIN, MACSIO_MAIN_Comm);
+    }
+    if (root == MACSIO_MAIN_Size)
+        return;
+#endif
+
+    for (i = 0; MACSIO_MAIN_Rank == root && vars_array && i < json_object_array_length(vars_array); i++)
+    {
+        json_object *var_obj = json_object_array_get_idx(vars_array, i);
+        char const *name = json_path_get_string(var_obj, name_path);
+        char const *alg, *params;
+        char chosen_alg[64], chosen_params[512];
+        json_object *choice;
+
+        if (json_object_object_get_ex(policy_choices, name, &choice))
+            continue;
+
+        policy_rule(name, var_obj, &alg, &params);
+        if (!strcmp(alg, "auto"))
+            choose_codec(var_obj, params, chosen_alg, chosen_params, sizeof(chosen_params));
+        else
+        {
+            snprintf(chosen_alg, sizeof(chosen_alg), "%s", strcmp(alg, "none") ? alg : "");
+            snprintf(chosen_params, sizeof(chosen_params), "%s", params);
+        }
+        choice = json_object_new_array();
+        json_object_array_add(choice, json_object_new_string(chosen_alg));
+        json_object_array_add(choice, json_object_new_string(chosen_params));
+        json_object_object_add(policy_choices, name, choice);
+    }
+
+#ifdef HAVE_MPI
+    {
+        char const *str = json_object_to_json_string(policy_choices);
+        int len = MACSIO_MAIN_Rank == root ? (int) strlen(str) + 1 : 0;
+        char *buf;
+
+        MPI_Bcast(&len, 1, MPI_INT, root, MACSIO_MAIN_Comm);
+        buf = (char *) malloc(len);
+        if (MACSIO_MAIN_Rank == root)
+            memcpy(buf, str, len);
+        MPI_Bcast(buf, len, MPI_CHAR, root, MACSIO_MAIN_Comm);
+        if (MACSIO_MAIN_Rank != root)
+        {
+            json_object_put(policy_choices);
+            policy_choices = json_tokener_parse(buf);
+        }
+        free(buf);
+    }
+#endif
+}
+
 static int process_args(int argi, int argc, char *argv[])
 {
     const MACSIO_CLARGS_ArgvFlags_t argFlags = {MACSIO_CLARGS_WARN, MACSIO_CLARGS_TOMEM};
 
     char *c_alg = compression_alg_str;
     char *c_params = compression_params_str;
+    char *c_policy = compression_policy_str;
+    char *c_fs_strategy = fs_strategy_str;
+    char *mif_images = mif_images_str;
 
     MACSIO_CLARGS_ProcessCmdline(0, argFlags, argi, argc, argv,
         "--show_errors", "",
@@ -985,18 +1537,73 @@ static int process_args(int argi, int argc, char *argv[])
             "        but worst compression whereas level=9 results in best compression\n"
             "        but worst speed. Values outside [1,9] are clamped. Default is 9.\n"
             "\n"
+            "\"auto\"\n"
+            "    At the first dump, test-compress a sample of each var with each\n"
+            "    lossless codec and pick the one that writes it fastest at a target\n"
+            "    bandwidth, the best trade-off of ratio and compress throughput.\n"
+            "    The choice is kept for later dumps.\n"
+            "    sample=%d : number of values to sample. Default is 65536.\n"
+            "    target_bw=%f : bandwidth, in bytes per second, compressed data is\n"
+            "        expected to be written at. Default is 1e9.\n"
+            "\n"
             "Examples:\n"
             "    --compression lindstrom-zfp rate=18.5\n"
             "    --compression gzip minsize=1024,level=9\n"
             "    --compression szip shuffle=0,options=nn,pixels_per_block=16\n"
             "\n",
             &c_alg, &c_params,
+        "--compress_policy %s", MACSIO_CLARGS_NODEFAULT,
+            "Compress vars as rules say rather than all as --compression says. The\n"
+            "argument is a file with a rule per line (# starts a comment) or rules\n"
+            "separated by semicolons. A rule is match:algorithm[:params], with the\n"
+            "algorithm and params as for --compression, \"auto\" included, or \"none\".\n"
+            "A match is a glob on var names or kind=<k> for vars of data type, type or\n"
+            "centering k (int, double, subset, node, zone, ...). A var is compressed\n"
+            "by the first rule it matches, else as --compression says. For example\n"
+            "    --compress_policy \"xlayers:gzip:level=1;kind=double:auto;*:none\"",
+            &c_policy,
+        "--compress_threads %d", "0",
+            "In MIF mode, with gzip compression, compress datasets a chunk at a time\n"
+            "in this many threads rather than in H5Dwrite and write the compressed\n"
+            "chunks with H5Dwrite_chunk, compressing the next chunks while writing\n"
+            "the current ones. The output is the same as HDF5's shuffle and deflate\n"
+            "filters would make. Not used with --mif_packed. Needs HDF5 1.10.3 or newer.",
+            &compress_threads,
+        "--compress_chunk_size %d", "1048576",
+            "With --compress_threads, the target size in bytes of the chunks\n"
+            "datasets are split into along their slowest varying dimension. With\n"
+            "--mif_packed, the size in bytes of the packed datasets' chunks.",
+            &compress_chunk_size,
         "--no_collective", "",
             "Use independent, not collective, I/O calls in SIF mode.",
             &no_collective,
         "--no_single_chunk", "",
             "Do not single chunk the datasets (currently ignored).",
             &no_single_chunk,
+        "--chunk_parts", "",
+            "In SIF mode, chunk the datasets over the global mesh so that each part's\n"
+            "data fills whole chunks no other part writes to. Without it, datasets\n"
+            "are contiguous, or single chunked when compressed. With --alignment,\n"
+            "chunks smaller than the alignment are grown to span several parts.",
+            &chunk_parts,
+        "--mif_packed", "",
+            "In MIF mode, write each var to one dataset per file holding all the\n"
+            "parts written to the file, one after the other, rather than to a dataset\n"
+            "per part in a group per part. For each var, a <name>_index dataset has\n"
+            "a row per part of its chunk id, the offset of its data in the packed\n"
+            "dataset and its dims.",
+            &mif_packed,
+        "--mif_images %s", MACSIO_CLARGS_NODEFAULT,
+            "In MIF mode, instead of passing a baton from rank to rank in each group,\n"
+            "each rank builds its parts in an HDF5 file image in memory (with the core\n"
+            "VFD) and sends it to the first rank of its group, which alone writes the\n"
+            "group's file. Images are limited to 2 GiB. The argument says what the\n"
+            "aggregator does with them.\n"
+            "\"copy\" : copy the contents of each image into the file with H5Ocopy, so\n"
+            "    the file has the same layout as one written with the baton. Not\n"
+            "    supported with --mif_packed, which is ignored.\n"
+            "\"store\" : store each image as is in an opaque dataset named image_<rank>.",
+            &mif_images,
         "--sieve_buf_size %d", MACSIO_CLARGS_NODEFAULT,
             "Specify sieve buffer size (see H5Pset_sieve_buf_size)",
             &sbuf_size,
@@ -1007,9 +1614,45 @@ static int process_args(int argi, int argc, char *argv[])
             "Specify threshold size for data blocks considered to be 'small'\n"
             "(see H5Pset_small_data_block_size)",
             &rbuf_size,
+        "--fs_strategy %s", MACSIO_CLARGS_NODEFAULT,
+            "File space strategy of the files of a dump (see H5Pset_file_space_strategy).\n"
+            "\"fsm_aggr\" : free-space managers and aggregators, HDF5's default.\n"
+            "\"page\" : paged aggregation, allocating metadata and raw data in pages of\n"
+            "    their own, of --fs_page_size bytes.\n"
+            "\"aggr\" : aggregators only.\n"
+            "\"none\" : allocate at the end of the file only.\n"
+            "Needs HDF5 1.10.1 or newer.",
+            &c_fs_strategy,
+        "--fs_page_size %d", MACSIO_CLARGS_NODEFAULT,
+            "With --fs_strategy page, the size in bytes of file space pages, at least\n"
+            "512 (see H5Pset_file_space_page_size). Default is 4096.",
+            &fs_page_size,
+        "--page_buffer_size %d", MACSIO_CLARGS_NODEFAULT,
+            "With --fs_strategy page, the size in bytes of the page buffer, at least a\n"
+            "page, caching pages of the files of a dump (see H5Pset_page_buffer_size).\n"
+            "Not supported in SIF mode with parallel HDF5.",
+            &page_buf_size,
+        "--mdc_sizes %d %d %d", "16384 8192 33554432",
+            "Initial, minimum and maximum sizes in bytes of the metadata cache (see\n"
+            "H5Pset_mdc_config). The cache is resized between the minimum and maximum\n"
+            "by its hit rate.",
+            &mdc_initial_size, &mdc_min_size, &mdc_max_size,
+        "--collective_metadata", "",
+            "Make metadata reads and writes collective (see H5Pset_all_coll_metadata_ops\n"
+            "and H5Pset_coll_metadata_write). Only affects SIF mode with parallel HDF5.",
+            &collective_metadata,
         "--log", "",
-            "Use logging Virtual File Driver (see H5Pset_fapl_log)",
+            "Use logging Virtual File Driver (see H5Pset_fapl_log) for the files of a\n"
+            "dump. Each rank logs the I/O operations on each file it writes to\n"
+            "<file>.<rank>.log. At the end of each dump, a histogram of the sizes of\n"
+            "the operations, raw data and metadata apart, is appended to each log.\n"
+            "Not supported in SIF mode with parallel HDF5.",
             &use_log,
+        "--log_buf_size %d", MACSIO_CLARGS_NODEFAULT,
+            "With --log, also log how many times each byte is read and written and\n"
+            "the kind of data it holds, which needs a buffer of at least as many bytes\n"
+            "as the largest file.",
+            &lbuf_size,
 #ifdef HAVE_SILO
         "--silo_fapl %d %d", MACSIO_CLARGS_NODEFAULT,
             "Use Silo's block-based VFD and specify block size and block count", 
@@ -1017,384 +1660,2803 @@ static int process_args(int argi, int argc, char *argv[])
 #endif
            MACSIO_CLARGS_END_OF_ARGS);
 
+    if (strlen(fs_strategy_str) && strcmp(fs_strategy_str, "fsm_aggr") && strcmp(fs_strategy_str, "page") &&
+        strcmp(fs_strategy_str, "aggr") && strcmp(fs_strategy_str, "none"))
+        MACSIO_LOG_MSG(Warn, ("Ignoring unknown --fs_strategy \"%s\"", fs_strategy_str));
+#if !H5_VERSION_GE(1,10,1)
+    if (strlen(fs_strategy_str) || fs_page_size > 0 || page_buf_size > 0)
+        MACSIO_LOG_MSG(Warn, ("Ignoring file space options older HDF5 lacks"));
+#endif
+    if (page_buf_size > 0 && strcmp(fs_strategy_str, "page"))
+        MACSIO_LOG_MSG(Warn, ("Ignoring --page_buffer_size without --fs_strategy page"));
+    if (mdc_min_size > mdc_initial_size || mdc_initial_size > mdc_max_size)
+    {
+        MACSIO_LOG_MSG(Warn, ("Ignoring --mdc_sizes with initial size out of min/max range"));
+        mdc_initial_size = 16 * 1024;
+        mdc_min_size = 8 * 1024;
+        mdc_max_size = 32 * 1024 * 1024;
+    }
+
     if (!show_errors)
         H5Eset_auto1(0,0);
     return 0;
 }
 
-static void main_dump_sif(json_object *main_obj, int dumpn, double dumpt)
-{
 #ifdef HAVE_MPI
-    int ndims;
-    int i, v, p;
-    char const *mesh_type = json_object_path_get_string(main_obj, "clargs/part_type");
-    char fileName[256];
-    int use_part_count;
-
-    hid_t h5file_id;
-    hid_t fapl_id = make_fapl();
-    hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
-    hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
-    hid_t null_space_id = H5Screate(H5S_NULL);
-    hid_t fspace_nodal_id, fspace_zonal_id;
-    hsize_t global_log_dims_nodal[3];
-    hsize_t global_log_dims_zonal[3];
-
-    MPI_Info mpiInfo = MPI_INFO_NULL;
-
-#warning WE ARE DOING SIF SLIGHTLY WRONG, DUPLICATING SHARED NODES
-#warning INCLUDE ARGS FOR ISTORE AND K_SYM
-#warning INCLUDE ARG PROCESS FOR HINTS
-#warning FAPL PROPS: ALIGNMENT 
-#if H5_HAVE_PARALLEL
-    H5Pset_fapl_mpio(fapl_id, MACSIO_MAIN_Comm, mpiInfo);
-#endif
-
-#warning FOR MIF, NEED A FILEROOT ARGUMENT OR CHANGE TO FILEFMT ARGUMENT
-    /* Construct name for the HDF5 file */
-    sprintf(fileName, "%s_hdf5_%03d.%s",
-        json_object_path_get_string(main_obj, "clargs/filebase"),
-        dumpn,
-        json_object_path_get_string(main_obj, "clargs/fileext"));
-
-    h5file_id = H5Fcreate(fileName, H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
+/* A dataset write of a SIF dump, set up ahead of time so several can be made at once */
+typedef struct _sif_write_t {
+    hid_t ds_id;
+    hid_t dtype_id;
+    hid_t mspace_id;
+    hid_t fspace_id;
+    void const *buf;
+    void *gathered;    /* buffer to free after the write when buf had to be gathered */
+} sif_write_t;
+
+/* A row of a part's box in a file dataspace: its coordinates in all but the fastest
+   varying dimension followed by its first coordinate in that one */
+typedef struct _sif_row_t {
+    hsize_t key[4];
+    char const *src;
+    size_t nbytes;
+} sif_row_t;
+
+static int compare_sif_rows(void const *a, void const *b)
+{
+    sif_row_t const *ra = (sif_row_t const *) a;
+    sif_row_t const *rb = (sif_row_t const *) b;
+    int i;
 
-    /* Create an HDF5 Dataspace for the global whole of mesh and var objects in the file. */
-    ndims = json_object_path_get_int(main_obj, "clargs/part_dim");
-    json_object *global_log_dims_array =
-        json_object_path_get_array(main_obj, "problem/global/LogDims");
-    json_object *global_parts_log_dims_array =
-        json_object_path_get_array(main_obj, "problem/global/PartsLogDims");
-    /* Note that global zonal array is smaller in each dimension by one *ON*EACH*BLOCK*
-       in the associated dimension. */
-    for (i = 0; i < ndims; i++)
+    for (i = 0; i < 4; i++)
     {
-        int parts_log_dims_val = JsonGetInt(global_parts_log_dims_array, "", i);
-        global_log_dims_nodal[ndims-1-i] = (hsize_t) JsonGetInt(global_log_dims_array, "", i);
-        global_log_dims_zonal[ndims-1-i] = global_log_dims_nodal[ndims-1-i] -
-            JsonGetInt(global_parts_log_dims_array, "", i);
+        if (ra->key[i] != rb->key[i])
+            return ra->key[i] < rb->key[i] ? -1 : 1;
     }
-    fspace_nodal_id = H5Screate_simple(ndims, global_log_dims_nodal, 0);
-    fspace_zonal_id = H5Screate_simple(ndims, global_log_dims_zonal, 0);
+    return 0;
+}
 
-    /* Get the list of vars on the first part as a guide to loop over vars */
-    json_object *part_array = json_object_path_get_array(main_obj, "problem/parts");
-    json_object *first_part_obj = json_object_array_get_idx(part_array, 0);
-    json_object *first_part_vars_array = json_object_path_get_array(first_part_obj, "Vars");
+/*!
+\brief Gather the buffers of several parts for the union of their hyperslabs
 
-    /* Dataset transfer property list used in all H5Dwrite calls */
-#if H5_HAVE_PARALLEL
-    if (no_collective)
-        H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_INDEPENDENT);
-    else
-        H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
-#endif
+HDF5 pairs the elements of a memory selection with those of a file selection in the
+file selection's row-major order. In the union of the boxes of several parts, the rows
+of parts that sit side by side interleave in that order so the parts' buffers cannot
+just be appended. Instead, the rows of all parts are sorted by their position in the
+file and copied out in that order.
 
+\return A buffer holding all of the parts' data that the caller must free
+*/
+static void *
+gather_parts(
+    int nparts,                /**< [in] Number of parts */
+    int rank,                  /**< [in] Rank of the file dataspace */
+    hsize_t const *starts,     /**< [in] nparts*rank starts of the parts' boxes */
+    hsize_t const *counts,     /**< [in] nparts*rank sizes of the parts' boxes */
+    hsize_t const *mdims,      /**< [in] nparts*rank dims of the parts' buffers */
+    void const * const *bufs,  /**< [in] Each part's buffer, its box at the buffer's origin */
+    size_t elsize              /**< [in] Size in bytes of one element */
+)
+{
+    int p, d;
+    hsize_t i, nrows = 0, r = 0;
+    size_t nbytes = 0;
+    sif_row_t *rows;
+    char *gathered, *dst;
 
-    /* Loop over vars and then over parts */
-    /* currently assumes all vars exist on all ranks. but not all parts */
-    for (v = -1; v < json_object_array_length(first_part_vars_array); v++) /* -1 start is for Mesh */
+    for (p = 0; p < nparts; p++)
     {
+        hsize_t n = 1;
+        for (d = 0; d < rank-1; d++)
+            n *= counts[p*rank+d];
+        nrows += n;
+    }
+    rows = (sif_row_t *) calloc(nrows ? nrows : 1, sizeof(sif_row_t));
 
-#warning SKIPPING MESH
-        if (v == -1) continue; /* All ranks skip mesh (coords) for now */
-
-        /* Inspect the first part's var object for name, datatype, etc. */
-        json_object *var_obj = json_object_array_get_idx(first_part_vars_array, v);
-        char const *varName = json_object_path_get_string(var_obj, "name");
-        char *centering = strdup(json_object_path_get_string(var_obj, "centering"));
-        json_object *dataobj = json_object_path_get_extarr(var_obj, "data");
-#warning JUST ASSUMING TWO TYPES NOW. CHANGE TO A FUNCTION
-        hid_t dtype_id = json_object_extarr_type(dataobj)==json_extarr_type_flt64? 
-                H5T_NATIVE_DOUBLE:H5T_NATIVE_INT;
-        hid_t fspace_id = H5Scopy(strcmp(centering, "zone") ? fspace_nodal_id : fspace_zonal_id);
-        hid_t dcpl_id = make_dcpl(compression_alg_str, compression_params_str, fspace_id, dtype_id);
-
-        /* Create the file dataset (using old-style H5Dcreate API here) */
-#warning USING DEFAULT DCPL: LATER ADD COMPRESSION, ETC.
-        
-        hid_t ds_id = H5Dcreate1(h5file_id, varName, dtype_id, fspace_id, dcpl_id); 
-        H5Sclose(fspace_id);
-        H5Pclose(dcpl_id);
-
-        /* Loop to make write calls for this var for each part on this rank */
-#warning USE NEW MULTI-DATASET API WHEN AVAILABLE TO AGLOMERATE ALL PARTS INTO ONE CALL
-        use_part_count = (int) ceil(json_object_path_get_double(main_obj, "clargs/avg_num_parts"));
-        for (p = 0; p < use_part_count; p++)
+    for (p = 0; p < nparts; p++)
+    {
+        hsize_t const *start = starts + p*rank, *count = counts + p*rank, *mdim = mdims + p*rank;
+        hsize_t idx[4] = {0, 0, 0, 0}, stride[4], n = 1;
+        size_t rowbytes = count[rank-1] * elsize;
+
+        stride[rank-1] = 1;
+        for (d = rank-2; d >= 0; d--)
+            stride[d] = stride[d+1] * mdim[d+1];
+        for (d = 0; d < rank-1; d++)
+            n *= count[d];
+        for (i = 0; i < n; i++, r++)
         {
-            json_object *part_obj = json_object_array_get_idx(part_array, p);
-            json_object *var_obj = 0;
-            hid_t mspace_id = H5Scopy(null_space_id);
-            void const *buf = 0;
+            hsize_t offset = 0;
 
-            fspace_id = H5Scopy(null_space_id);
-
-            /* this rank actually has something to contribute to the H5Dwrite call */
-            if (part_obj)
+            for (d = 0; d < rank-1; d++)
             {
-                int i;
-                hsize_t starts[3], counts[3];
-                json_object *vars_array = json_object_path_get_array(part_obj, "Vars");
-                json_object *mesh_obj = json_object_path_get_object(part_obj, "Mesh");
-                json_object *var_obj = json_object_array_get_idx(vars_array, v);
-                json_object *extarr_obj = json_object_path_get_extarr(var_obj, "data");
-                json_object *global_log_origin_array =
-                    json_object_path_get_array(part_obj, "GlobalLogOrigin");
-                json_object *global_log_indices_array =
-                    json_object_path_get_array(part_obj, "GlobalLogIndices");
-                json_object *mesh_dims_array = json_object_path_get_array(mesh_obj, "LogDims");
-                for (i = 0; i < ndims; i++)
-                {
-                    starts[ndims-1-i] =
-                        json_object_get_int(json_object_array_get_idx(global_log_origin_array,i));
-                    counts[ndims-1-i] =
-                        json_object_get_int(json_object_array_get_idx(mesh_dims_array,i));
-                    if (!strcmp(centering, "zone"))
-                    {
-                        counts[ndims-1-i]--;
-                        starts[ndims-1-i] -=
-                            json_object_get_int(json_object_array_get_idx(global_log_indices_array,i));
-                    }
-                }
-
-                /* set selection of filespace */
-                fspace_id = H5Dget_space(ds_id);
-                H5Sselect_hyperslab(fspace_id, H5S_SELECT_SET, starts, 0, counts, 0);
-
-                /* set dataspace of data in memory */
-                mspace_id = H5Screate_simple(ndims, counts, 0);
-                buf = json_object_extarr_data(extarr_obj);
+                rows[r].key[d] = start[d] + idx[d];
+                offset += idx[d] * stride[d];
             }
+            rows[r].key[rank-1] = start[rank-1];
+            rows[r].src = (char const *) bufs[p] + offset * elsize;
+            rows[r].nbytes = rowbytes;
 
-            H5Dwrite(ds_id, dtype_id, mspace_id, fspace_id, dxpl_id, buf);
-            H5Sclose(fspace_id);
-            H5Sclose(mspace_id);
-
+            /* next row of this part's box */
+            for (d = rank-2; d >= 0; d--)
+            {
+                if (++idx[d] < count[d]) break;
+                idx[d] = 0;
+            }
         }
+        nbytes += n * rowbytes;
+    }
 
-        H5Dclose(ds_id);
-        free(centering);
+    qsort(rows, nrows, sizeof(sif_row_t), compare_sif_rows);
+    dst = gathered = (char *) malloc(nbytes ? nbytes : 1);
+    for (r = 0; r < nrows; r++)
+    {
+        memcpy(dst, rows[r].src, rows[r].nbytes);
+        dst += rows[r].nbytes;
     }
+    free(rows);
 
-    H5Sclose(fspace_nodal_id);
-    H5Sclose(fspace_zonal_id);
-    H5Sclose(null_space_id);
-    H5Pclose(dxpl_id);
+    return gathered;
+}
+
+/*!
+\brief Set up the write of boxes of several parts' buffers to a SIF dataset
+
+Each part's box sits at the origin of its buffer and may be smaller than the buffer
+where the part does not own all of its elements. The file selection is the union of
+the parts' boxes so a rank makes one write however many parts it has. A rank with no
+parts still makes the write, with empty selections.
+*/
+static void
+add_boxes_sif_write(
+    sif_write_t *w,            /**< [out] The write */
+    hid_t ds_id,               /**< [in] The dataset, which the write takes over */
+    hid_t dtype_id,            /**< [in] The memory datatype, which the write takes over */
+    int nparts,                /**< [in] Number of parts */
+    int rank,                  /**< [in] Rank of the dataset */
+    hsize_t const *starts,     /**< [in] nparts*rank starts of the parts' boxes in the file */
+    hsize_t const *counts,     /**< [in] nparts*rank sizes of the parts' boxes */
+    hsize_t const *mdims,      /**< [in] nparts*rank dims of the parts' buffers */
+    void const * const *bufs   /**< [in] The parts' buffers */
+)
+{
+    hsize_t const zeros[4] = {0, 0, 0, 0};
+    int p;
+
+    w->ds_id = ds_id;
+    w->dtype_id = dtype_id;
+    w->buf = 0;
+    w->gathered = 0;
+
+    if (nparts == 0)
+    {
+        w->fspace_id = H5Screate(H5S_NULL);
+        w->mspace_id = H5Screate(H5S_NULL);
+        return;
+    }
+
+    w->fspace_id = H5Dget_space(ds_id);
+    for (p = 0; p < nparts; p++)
+        H5Sselect_hyperslab(w->fspace_id, p ? H5S_SELECT_OR : H5S_SELECT_SET,
+            starts + p*rank, 0, counts + p*rank, 0);
+
+    if (nparts == 1)
+    {
+        w->mspace_id = H5Screate_simple(rank, mdims, 0);
+        H5Sselect_hyperslab(w->mspace_id, H5S_SELECT_SET, zeros, 0, counts, 0);
+        w->buf = bufs[0];
+    }
+    else
+    {
+        hsize_t npoints = (hsize_t) H5Sget_select_npoints(w->fspace_id);
+        w->mspace_id = H5Screate_simple(1, &npoints, 0);
+        w->gathered = gather_parts(nparts, rank, starts, counts, mdims, bufs, H5Tget_size(dtype_id));
+        w->buf = w->gathered;
+    }
+}
+
+/*!
+\brief The box of a part in a SIF dataset over the global logical mesh
+
+Neighboring parts share the nodes on their common boundary. In the file, each shared
+node is written once, by the part on its low side, so a part's box covers all of its
+own nodes only along dimensions in which it is the last part. Boxes are in HDF5 order,
+slowest varying dimension first.
+*/
+static void
+part_box(
+    json_object *part_obj,      /**< [in] The part */
+    int ndims,                  /**< [in] Number of spatial dimensions */
+    int const *parts_log_dims,  /**< [in] Number of parts in each dimension */
+    int nodal,                  /**< [in] Bit i set if the dataset is over nodes, not zones, in dimension i */
+    hsize_t *start,             /**< [out] Start of the part's box in the file */
+    hsize_t *count,             /**< [out] Size of the part's box */
+    hsize_t *mdims              /**< [out] Dims of the part's buffer */
+)
+{
+    json_object *origin_array = json_path_get_object(part_obj, global_log_origin_path);
+    json_object *indices_array = json_path_get_object(part_obj, global_log_indices_path);
+    json_object *dims_array = json_path_get_object(part_obj, mesh_log_dims_path);
+    int i;
+
+    for (i = 0; i < ndims; i++)
+    {
+        int index = json_object_get_int(json_object_array_get_idx(indices_array, i));
+        int nnodes = json_object_get_int(json_object_array_get_idx(dims_array, i));
+        int is_nodal = (nodal >> i) & 0x1;
+
+        start[ndims-1-i] = json_object_get_int(json_object_array_get_idx(origin_array, i)) - index;
+        mdims[ndims-1-i] = nnodes - !is_nodal;
+        count[ndims-1-i] = nnodes - 1 + (is_nodal && index == parts_log_dims[i] - 1);
+    }
+}
+
+/*!
+\brief Set up the write of one var of all of a rank's parts to a SIF file
+*/
+static void
+add_var_sif_write(
+    sif_write_t *w,             /**< [out] The write */
+    hid_t ds_id,                /**< [in] The var's dataset, which the write takes over */
+    hid_t dtype_id,             /**< [in] The var's datatype, which the write takes over */
+    json_object *part_array,    /**< [in] This rank's parts */
+    int v,                      /**< [in] Index of the var in each part's Vars */
+    int ndims,                  /**< [in] Number of spatial dimensions */
+    int const *parts_log_dims,  /**< [in] Number of parts in each dimension */
+    int ncomps,                 /**< [in] Number of components of the var */
+    int nsoa,                   /**< [in] 1 if the dataset has a leading component dimension */
+    int zonal                   /**< [in] Non-zero for a zone centered var */
+)
+{
+    int nparts = json_object_array_length(part_array);
+    int rank = ndims + nsoa;
+    hsize_t *starts = (hsize_t *) malloc((nparts ? nparts : 1) * rank * sizeof(hsize_t));
+    hsize_t *counts = (hsize_t *) malloc((nparts ? nparts : 1) * rank * sizeof(hsize_t));
+    hsize_t *mdims = (hsize_t *) malloc((nparts ? nparts : 1) * rank * sizeof(hsize_t));
+    void const **bufs = (void const **) malloc((nparts ? nparts : 1) * sizeof(void const *));
+    int p;
+
+    for (p = 0; p < nparts; p++)
+    {
+        json_object *part_obj = json_object_array_get_idx(part_array, p);
+        json_object *vars_array = json_path_get_object(part_obj, vars_path);
+        json_object *var_obj = json_object_array_get_idx(vars_array, v);
+
+        starts[p*rank] = 0;
+        counts[p*rank] = mdims[p*rank] = ncomps;
+        part_box(part_obj, ndims, parts_log_dims, zonal ? 0 : 0x7,
+            starts + p*rank + nsoa, counts + p*rank + nsoa, mdims + p*rank + nsoa);
+        bufs[p] = json_object_extarr_data(json_path_get_object(var_obj, data_path));
+    }
+    add_boxes_sif_write(w, ds_id, dtype_id, nparts, rank, starts, counts, mdims, bufs);
+
+    free(starts);
+    free(counts);
+    free(mdims);
+    free(bufs);
+}
+
+/*!
+\brief Renumber a part's node or face references to the global logical mesh
+
+A part numbers its nodes over its own logical dims, x varying fastest, and its faces
+in blocks of x-, y- then z-perpendicular faces each numbered the same way. The global
+mesh numbers them likewise over the deduplicated global logical dims. A face reference
+may be negated with ~ to flip its orientation, which is kept.
+*/
+static void
+renumber_refs(
+    int const *src,         /**< [in] The part's references */
+    int n,                  /**< [in] Number of references */
+    int *dst,               /**< [out] The global references */
+    int nblocks,            /**< [in] 0 for node references, else the number of face blocks */
+    int const *origin,      /**< [in] The part's first node in the global mesh, x, y, z */
+    int const *lnodes,      /**< [in] The part's number of nodes, x, y, z */
+    int const *gnodes       /**< [in] The global mesh's number of nodes, x, y, z */
+)
+{
+    int ld[3][3], gd[3][3], lofs[4], gofs[4];
+    int i, b, d, nb = nblocks ? nblocks : 1;
+
+    lofs[0] = gofs[0] = 0;
+    for (b = 0; b < nb; b++)
+    {
+        int lsize = 1, gsize = 1;
+        for (d = 0; d < 3; d++)
+        {
+            /* a face block is over nodes in its own dimension and zones in the others */
+            int is_nodal = !nblocks || d == b;
+            ld[b][d] = is_nodal ? lnodes[d] : MU_MAX(lnodes[d]-1,1);
+            gd[b][d] = is_nodal ? gnodes[d] : MU_MAX(gnodes[d]-1,1);
+            lsize *= ld[b][d];
+            gsize *= gd[b][d];
+        }
+        lofs[b+1] = lofs[b] + lsize;
+        gofs[b+1] = gofs[b] + gsize;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        int id = src[i], flip = id < 0;
+        int l0, l1, l2, g;
+
+        if (flip) id = ~id;
+        for (b = 0; b < nb-1 && id >= lofs[b+1]; b++);
+        id -= lofs[b];
+        l0 = id % ld[b][0];
+        l1 = (id / ld[b][0]) % ld[b][1];
+        l2 = id / (ld[b][0] * ld[b][1]);
+        g = gofs[b] + (origin[0] + l0) + gd[b][0] * ((origin[1] + l1) + gd[b][1] * (origin[2] + l2));
+        dst[i] = flip ? ~g : g;
+    }
+}
+
+/*!
+\brief Set up the write of a block of node or face references of all of a rank's parts
+
+The references of each part are read from the extarr at \c path, starting at row
+\c row_block, renumbered to the global mesh and written to the box of the part in the
+dataset, whose fastest varying dimension holds the \c ncols references of a row.
+*/
+static void
+add_refs_sif_write(
+    sif_write_t *w,             /**< [out] The write */
+    hid_t ds_id,                /**< [in] The dataset, which the write takes over */
+    json_object *part_array,    /**< [in] This rank's parts */
+    char const *path,           /**< [in] Path of the references in a part */
+    int ndims,                  /**< [in] Number of spatial dimensions */
+    int const *parts_log_dims,  /**< [in] Number of parts in each dimension */
+    int const *gnodes,          /**< [in] The global mesh's number of nodes, x, y, z */
+    int nodal,                  /**< [in] As for part_box(), for the rows */
+    int row_block,              /**< [in] -1 for rows over zones, else the face block of the rows */
+    int nblocks,                /**< [in] As for renumber_refs(), for the references */
+    int ncols                   /**< [in] Number of references in a row */
+)
+{
+    int nparts = json_object_array_length(part_array);
+    int rank = ndims + 1;
+    hsize_t *starts = (hsize_t *) malloc((nparts ? nparts : 1) * rank * sizeof(hsize_t));
+    hsize_t *counts = (hsize_t *) malloc((nparts ? nparts : 1) * rank * sizeof(hsize_t));
+    hsize_t *mdims = (hsize_t *) malloc((nparts ? nparts : 1) * rank * sizeof(hsize_t));
+    void const **bufs = (void const **) malloc((nparts ? nparts : 1) * sizeof(void const *));
+    int **refs = (int **) malloc((nparts ? nparts : 1) * sizeof(int *));
+    int p, i, b;
+
+    for (p = 0; p < nparts; p++)
+    {
+        json_object *part_obj = json_object_array_get_idx(part_array, p);
+        json_object *origin_array = json_path_get_object(part_obj, global_log_origin_path);
+        json_object *indices_array = json_path_get_object(part_obj, global_log_indices_path);
+        json_object *dims_array = json_path_get_object(part_obj, mesh_log_dims_path);
+        int const *src = (int const *) json_object_extarr_data(json_object_path_get_extarr(part_obj, path));
+        int origin[3] = {0, 0, 0}, lnodes[3] = {1, 1, 1};
+        int nrows = 1, row0 = 0, nrefs;
+
+        for (i = 0; i < ndims; i++)
+        {
+            origin[i] = json_object_get_int(json_object_array_get_idx(origin_array, i)) -
+                json_object_get_int(json_object_array_get_idx(indices_array, i));
+            lnodes[i] = json_object_get_int(json_object_array_get_idx(dims_array, i));
+        }
+
+        /* rows of the face blocks before this one */
+        for (b = 0; b < row_block; b++)
+        {
+            int n = 1;
+            for (i = 0; i < 3; i++)
+                n *= i == b ? lnodes[i] : MU_MAX(lnodes[i]-1,1);
+            row0 += n;
+        }
+
+        part_box(part_obj, ndims, parts_log_dims, nodal, starts + p*rank, counts + p*rank, mdims + p*rank);
+        starts[p*rank+ndims] = 0;
+        counts[p*rank+ndims] = mdims[p*rank+ndims] = ncols;
+        for (i = 0; i < ndims; i++)
+            nrows *= mdims[p*rank+i];
+
+        nrefs = nrows * ncols;
+        refs[p] = (int *) malloc((nrefs ? nrefs : 1) * sizeof(int));
+        renumber_refs(src + row0 * ncols, nrefs, refs[p], nblocks, origin, lnodes, gnodes);
+        bufs[p] = refs[p];
+    }
+    add_boxes_sif_write(w, ds_id, H5Tcopy(H5T_NATIVE_INT), nparts, rank, starts, counts, mdims, bufs);
+
+    /* a single part's buffer is written as is so it goes with the write */
+    if (nparts == 1 && !w->gathered)
+        w->gathered = refs[0];
+    else for (p = 0; p < nparts; p++)
+        free(refs[p]);
+
+    free(refs);
+    free(starts);
+    free(counts);
+    free(mdims);
+    free(bufs);
+}
+
+static void
+write_string_attr(hid_t loc_id, char const *name, char const *val)
+{
+    hid_t type_id = H5Tcopy(H5T_C_S1);
+    hid_t space_id = H5Screate(H5S_SCALAR);
+    hid_t attr_id;
+
+    H5Tset_size(type_id, strlen(val) + 1);
+    attr_id = H5Acreate1(loc_id, name, type_id, space_id, H5P_DEFAULT);
+    H5Awrite(attr_id, type_id, val);
+    H5Aclose(attr_id);
+    H5Sclose(space_id);
+    H5Tclose(type_id);
+}
+
+static void
+write_array_attr(hid_t loc_id, char const *name, hid_t type_id, hsize_t n, void const *vals)
+{
+    hid_t space_id = H5Screate_simple(1, &n, 0);
+    hid_t attr_id = H5Acreate1(loc_id, name, type_id, space_id, H5P_DEFAULT);
+
+    H5Awrite(attr_id, type_id, vals);
+    H5Aclose(attr_id);
+    H5Sclose(space_id);
+}
+
+/* Create a SIF dataset, chunked as \c chunk_dims when given. With \c --alignment, chunks
+   smaller than the alignment are grown over whole multiples of them, slowest dimension
+   first, so that every chunk is at least as large and starts on an alignment boundary. */
+static hid_t
+create_sif_dataset(hid_t loc_id, char const *name, hid_t dtype_id, int rank, hsize_t const *dims,
+    hsize_t const *chunk_dims)
+{
+    hid_t space_id = H5Screate_simple(rank, dims, 0);
+    hid_t dcpl_id = make_var_dcpl(name, space_id, dtype_id);
+    hid_t ds_id;
+
+    if (chunk_dims)
+    {
+        hsize_t chunk[4], nbytes = H5Tget_size(dtype_id);
+        int i;
+
+        for (i = 0; i < rank; i++)
+        {
+            chunk[i] = chunk_dims[i];
+            nbytes *= chunk[i];
+        }
+        for (i = 0; i < rank && nbytes < (hsize_t) alignment; i++)
+        {
+            hsize_t grow = (alignment + nbytes - 1) / nbytes;
+            if (chunk[i] * grow > dims[i])
+                grow = dims[i] / chunk[i];
+            chunk[i] *= grow;
+            nbytes *= grow;
+        }
+        H5Pset_chunk(dcpl_id, rank, chunk);
+    }
+    ds_id = H5Dcreate1(loc_id, name, dtype_id, space_id, dcpl_id);
+
+    H5Pclose(dcpl_id);
+    H5Sclose(space_id);
+    return ds_id;
+}
+
+/*!
+\brief Set up the writes of the mesh of all of a rank's parts to a SIF file
+
+The parts make up one global mesh in the file's \c mesh group, with the nodes parts
+share on their boundaries appearing once. Its coordinates are over the global logical
+nodes, as are nodal vars, and for unstructured and arbitrary parts its connectivity
+refers to nodes and faces by their numbers in the global logical mesh, x varying
+fastest. A zone's references are at its place in the global logical zones, as for
+zonal vars. An arbitrary mesh's faces are in a dataset per direction, over the global
+logical faces perpendicular to it, each holding the face's nodes, and its \c Facelist
+refers to them numbered as the x faces, then the y faces then the z faces. The
+connectivity of a structured mesh is implicit so only its element type is written.
+
+\return The number of writes set up
+*/
+static int
+add_mesh_sif_writes(
+    sif_write_t *w,             /**< [out] The writes */
+    hid_t h5file_id,            /**< [in] The SIF file */
+    json_object *main_obj,      /**< [in] The main object */
+    json_object *part_array,    /**< [in] This rank's parts */
+    int ndims,                  /**< [in] Number of spatial dimensions */
+    int const *parts_log_dims,  /**< [in] Number of parts in each dimension */
+    hsize_t const *nodal_dims,  /**< [in] Global logical nodes, slowest varying first */
+    hsize_t const *zonal_dims,  /**< [in] Global logical zones, slowest varying first */
+    hsize_t const *chunk_dims   /**< [in] A part's zones, slowest varying first, to chunk on or null */
+)
+{
+    static char const *elem_types[] = {"Beam2", "Quad4", "Hex8"};
+    static char const *axes[] = {"X", "Y", "Z"};
+    char const *mesh_type = json_object_path_get_string(main_obj, "clargs/part_type");
+    int nparts = json_object_array_length(part_array);
+    int gnodes[3] = {1, 1, 1};
+    int i, p, nwrites = 0;
+    hsize_t chunk[4];
+    hid_t grp_id = H5Gcreate1(h5file_id, "mesh", 0);
+
+    for (i = 0; i < ndims; i++)
+        gnodes[i] = (int) nodal_dims[ndims-1-i];
+
+    /* 1D arbitrary parts have no faces; their zones are just beams */
+    write_string_attr(grp_id, "MeshType", mesh_type);
+    write_string_attr(grp_id, "ElemType", !strcmp(mesh_type, "arbitrary") && ndims > 1 ?
+        "Arbitrary" : elem_types[ndims-1]);
+    write_array_attr(grp_id, "LogDims", H5T_NATIVE_HSIZE, ndims, nodal_dims);
+
+    if (!strcmp(mesh_type, "uniform"))
+    {
+        json_object *bounds_array = json_object_path_get_array(main_obj, "problem/global/Bounds");
+        double origin[3], delta[3];
+
+        for (i = 0; i < ndims; i++)
+        {
+            origin[i] = JsonGetDbl(bounds_array, "", i);
+            delta[i] = (JsonGetDbl(bounds_array, "", i+3) - origin[i]) / MU_MAX(gnodes[i]-1,1);
+        }
+        write_array_attr(grp_id, "Origin", H5T_NATIVE_DOUBLE, ndims, origin);
+        write_array_attr(grp_id, "Delta", H5T_NATIVE_DOUBLE, ndims, delta);
+    }
+    else if (!strcmp(mesh_type, "rectilinear"))
+    {
+        hsize_t *starts = (hsize_t *) malloc((nparts ? nparts : 1) * 3 * sizeof(hsize_t));
+        void const **bufs = (void const **) malloc((nparts ? nparts : 1) * sizeof(void const *));
+
+        /* each axis' coordinates come from the parts in the first row of parts along it */
+        for (i = 0; i < ndims; i++)
+        {
+            hsize_t *counts = starts + (nparts ? nparts : 1), *mdims = counts + (nparts ? nparts : 1);
+            hsize_t dims[1];
+            char name[32];
+            int n = 0;
+
+            for (p = 0; p < nparts; p++)
+            {
+                json_object *part_obj = json_object_array_get_idx(part_array, p);
+                hsize_t start[3], count[3], mdim[3];
+                int j, first_row = 1;
+
+                for (j = 0; j < ndims; j++)
+                    if (j != i && JsonGetInt(part_obj, "GlobalLogIndices", j) != 0) first_row = 0;
+                if (!first_row) continue;
+
+                part_box(part_obj, ndims, parts_log_dims, 0x7, start, count, mdim);
+                starts[n] = start[ndims-1-i];
+                counts[n] = count[ndims-1-i];
+                mdims[n] = mdim[ndims-1-i];
+                snprintf(name, sizeof(name), "Mesh/Coords/%sAxisCoords", axes[i]);
+                bufs[n++] = json_object_extarr_data(json_object_path_get_extarr(part_obj, name));
+            }
+
+            dims[0] = gnodes[i];
+            if (chunk_dims)
+                chunk[0] = chunk_dims[ndims-1-i];
+            snprintf(name, sizeof(name), "%sAxisCoords", axes[i]);
+            add_boxes_sif_write(&w[nwrites++],
+                create_sif_dataset(grp_id, name, H5T_NATIVE_DOUBLE, 1, dims, chunk_dims ? chunk : 0),
+                H5Tcopy(H5T_NATIVE_DOUBLE), n, 1, starts, counts, mdims, bufs);
+        }
+        free(starts);
+        free(bufs);
+    }
+    else
+    {
+        hsize_t *starts = (hsize_t *) malloc((nparts ? nparts : 1) * 3 * ndims * sizeof(hsize_t));
+        hsize_t *counts = starts + (nparts ? nparts : 1) * ndims;
+        hsize_t *mdims = counts + (nparts ? nparts : 1) * ndims;
+        void const **bufs = (void const **) malloc((nparts ? nparts : 1) * sizeof(void const *));
+        hsize_t dims[4];
+        char name[32];
+
+        for (i = 0; i < ndims; i++)
+        {
+            for (p = 0; p < nparts; p++)
+            {
+                json_object *part_obj = json_object_array_get_idx(part_array, p);
+                part_box(part_obj, ndims, parts_log_dims, 0x7,
+                    starts + p*ndims, counts + p*ndims, mdims + p*ndims);
+                snprintf(name, sizeof(name), "Mesh/Coords/%sCoords", axes[i]);
+                bufs[p] = json_object_extarr_data(json_object_path_get_extarr(part_obj, name));
+            }
+            snprintf(name, sizeof(name), "%sCoords", axes[i]);
+            add_boxes_sif_write(&w[nwrites++],
+                create_sif_dataset(grp_id, name, H5T_NATIVE_DOUBLE, ndims, nodal_dims, chunk_dims),
+                H5Tcopy(H5T_NATIVE_DOUBLE), nparts, ndims, starts, counts, mdims, bufs);
+        }
+        free(starts);
+        free(bufs);
+
+        /* a part's references fill whole chunks too */
+        if (chunk_dims)
+            memcpy(chunk, chunk_dims, ndims * sizeof(hsize_t));
+
+        if (!strcmp(mesh_type, "unstructured"))
+        {
+            memcpy(dims, zonal_dims, ndims * sizeof(hsize_t));
+            dims[ndims] = chunk[ndims] = 1 << ndims;
+            add_refs_sif_write(&w[nwrites++],
+                create_sif_dataset(grp_id, "Nodelist", H5T_NATIVE_INT, ndims+1, dims, chunk_dims ? chunk : 0),
+                part_array, "Mesh/Topology/Nodelist", ndims, parts_log_dims, gnodes,
+                0, -1, 0, 1 << ndims);
+        }
+        else if (!strcmp(mesh_type, "arbitrary") && ndims > 1)
+        {
+            for (i = 0; i < ndims; i++)
+            {
+                int j;
+                for (j = 0; j < ndims; j++)
+                    dims[ndims-1-j] = j == i ? nodal_dims[ndims-1-j] : zonal_dims[ndims-1-j];
+                dims[ndims] = chunk[ndims] = 1 << (ndims-1);
+                snprintf(name, sizeof(name), "%sFaces", axes[i]);
+                add_refs_sif_write(&w[nwrites++],
+                    create_sif_dataset(grp_id, name, H5T_NATIVE_INT, ndims+1, dims, chunk_dims ? chunk : 0),
+                    part_array, "Mesh/Topology/Nodelist", ndims, parts_log_dims, gnodes,
+                    1 << i, i, 0, 1 << (ndims-1));
+            }
+            memcpy(dims, zonal_dims, ndims * sizeof(hsize_t));
+            dims[ndims] = chunk[ndims] = 2 * ndims;
+            add_refs_sif_write(&w[nwrites++],
+                create_sif_dataset(grp_id, "Facelist", H5T_NATIVE_INT, ndims+1, dims, chunk_dims ? chunk : 0),
+                part_array, "Mesh/Topology/Facelist", ndims, parts_log_dims, gnodes,
+                0, -1, ndims, 2 * ndims);
+        }
+    }
+
+    H5Gclose(grp_id);
+    return nwrites;
+}
+
+/*!
+\brief Set up the writes of one subset var of all of a rank's parts to a SIF file
+
+The values of a subset var do not map onto the global logical mesh so they are
+written as a 1D dataset holding the values of all parts one after the other, in
+rank order, with the zone indices of each value in a companion dataset with a
+\c _subset suffix. Each rank's offset into the datasets is computed with an
+exclusive scan of the number of values on each rank. A rank's parts are contiguous
+in the datasets so each rank makes one write to each.
+*/
+static void
+add_subset_var_sif_writes(
+    sif_write_t *w,          /**< [out] The two writes, one for the values and one for the indices */
+    hid_t h5file_id,         /**< [in] The SIF file */
+    json_object *part_array, /**< [in] This rank's parts */
+    int v,                   /**< [in] Index of the var in each part's Vars */
+    char const *varName      /**< [in] Name of the var */
+)
+{
+    int nparts = json_object_array_length(part_array);
+    int p, q;
+    long long nlocal = 0, offset = 0, ntotal = 0;
+    char subset_name[256];
+    hid_t const dtype_ids[2] = {H5T_NATIVE_DOUBLE, H5T_NATIVE_INT};
+    struct json_path *paths[2] = {data_path, subset_path};
+    hsize_t dims[1], start[1], count[1];
+    hid_t fspace_id;
+
+    for (p = 0; p < nparts; p++)
+    {
+        json_object *vars_array = json_path_get_object(json_object_array_get_idx(part_array, p), vars_path);
+        nlocal += json_object_extarr_nvals(json_path_get_object(
+            json_object_array_get_idx(vars_array, v), data_path));
+    }
+    MPI_Exscan(&nlocal, &offset, 1, MPI_LONG_LONG, MPI_SUM, MACSIO_MAIN_Comm);
+    if (MACSIO_MAIN_Rank == 0) offset = 0;
+    MPI_Allreduce(&nlocal, &ntotal, 1, MPI_LONG_LONG, MPI_SUM, MACSIO_MAIN_Comm);
+
+    snprintf(subset_name, sizeof(subset_name), "%s_subset", varName);
+    dims[0] = (hsize_t) ntotal;
+    start[0] = (hsize_t) offset;
+    count[0] = (hsize_t) nlocal;
+    fspace_id = H5Screate_simple(1, dims, 0);
+    for (q = 0; q < 2; q++)
+    {
+        hid_t dcpl_id = make_var_dcpl(q ? subset_name : varName, fspace_id, dtype_ids[q]);
+        size_t elsize = H5Tget_size(dtype_ids[q]);
+
+        w[q].ds_id = H5Dcreate1(h5file_id, q ? subset_name : varName, dtype_ids[q], fspace_id, dcpl_id);
+        w[q].dtype_id = H5Tcopy(dtype_ids[q]);
+        w[q].buf = 0;
+        w[q].gathered = 0;
+        H5Pclose(dcpl_id);
+
+        if (nlocal == 0)
+        {
+            w[q].fspace_id = H5Screate(H5S_NULL);
+            w[q].mspace_id = H5Screate(H5S_NULL);
+            continue;
+        }
+
+        w[q].fspace_id = H5Dget_space(w[q].ds_id);
+        H5Sselect_hyperslab(w[q].fspace_id, H5S_SELECT_SET, start, 0, count, 0);
+        w[q].mspace_id = H5Screate_simple(1, count, 0);
+
+        /* the parts' buffers appended one after the other */
+        if (nparts == 1)
+        {
+            json_object *vars_array = json_path_get_object(json_object_array_get_idx(part_array, 0), vars_path);
+            w[q].buf = json_object_extarr_data(json_path_get_object(
+                json_object_array_get_idx(vars_array, v), paths[q]));
+        }
+        else
+        {
+            char *dst = (char *) malloc(nlocal * elsize);
+            w[q].buf = w[q].gathered = dst;
+            for (p = 0; p < nparts; p++)
+            {
+                json_object *vars_array = json_path_get_object(json_object_array_get_idx(part_array, p), vars_path);
+                json_object *extarr_obj = json_path_get_object(json_object_array_get_idx(vars_array, v), paths[q]);
+                size_t nbytes = json_object_extarr_nvals(extarr_obj) * elsize;
+                memcpy(dst, json_object_extarr_data(extarr_obj), nbytes);
+                dst += nbytes;
+            }
+        }
+    }
+    H5Sclose(fspace_id);
+}
+
+/*!
+\brief Make a SIF dump's writes
+
+With HDF5 1.14 or later, they are all made with a single H5Dwrite_multi() call.
+Otherwise, each is made with its own H5Dwrite(). The writes' datasets, types and
+dataspaces are closed and gathered buffers freed.
+*/
+static void
+flush_sif_writes(sif_write_t *writes, int nwrites, hid_t dxpl_id)
+{
+    int i;
+
+#if H5_VERSION_GE(1,14,0)
+    if (nwrites)
+    {
+        hid_t *ids = (hid_t *) malloc(4 * nwrites * sizeof(hid_t));
+        void const **bufs = (void const **) malloc(nwrites * sizeof(void const *));
+        for (i = 0; i < nwrites; i++)
+        {
+            ids[i] = writes[i].ds_id;
+            ids[nwrites+i] = writes[i].dtype_id;
+            ids[2*nwrites+i] = writes[i].mspace_id;
+            ids[3*nwrites+i] = writes[i].fspace_id;
+            bufs[i] = writes[i].buf;
+        }
+        H5Dwrite_multi((size_t) nwrites, ids, ids + nwrites, ids + 2*nwrites, ids + 3*nwrites,
+            dxpl_id, bufs);
+        free(ids);
+        free(bufs);
+    }
+#else
+    for (i = 0; i < nwrites; i++)
+        H5Dwrite(writes[i].ds_id, writes[i].dtype_id, writes[i].mspace_id, writes[i].fspace_id,
+            dxpl_id, writes[i].buf);
+#endif
+
+    for (i = 0; i < nwrites; i++)
+    {
+        H5Sclose(writes[i].mspace_id);
+        H5Sclose(writes[i].fspace_id);
+        H5Tclose(writes[i].dtype_id);
+        H5Dclose(writes[i].ds_id);
+        free(writes[i].gathered);
+    }
+}
+#endif
+
+#ifdef HAVE_MPI
+/*!
+\brief The vars of the parts, without their data, on every rank
+
+Every rank takes part in the creation and write of every SIF dataset, including
+ranks with fewer parts than others or none at all. The ranks exchange their part
+counts and, when some rank has no parts, the lowest rank with parts sends it the
+names, types and shapes of its first part's vars. The \c data and \c subset extarrs
+of those vars have no buffer.
+
+\return A Vars array the caller must put
+*/
+static json_object *
+sif_vars_template(json_object *part_array)
+{
+    int nparts = json_object_array_length(part_array);
+    int *part_counts = (int *) malloc(MACSIO_MAIN_Size * sizeof(int));
+    json_object *vars_array = 0;
+    char *str = 0;
+    int i, len = 0, root = -1, all_have_parts = 1;
+
+    MPI_Allgather(&nparts, 1, MPI_INT, part_counts, 1, MPI_INT, MACSIO_MAIN_Comm);
+    for (i = 0; i < MACSIO_MAIN_Size; i++)
+    {
+        if (!part_counts[i])
+            all_have_parts = 0;
+        else if (root == -1)
+            root = i;
+    }
+    free(part_counts);
+
+    if (nparts)
+        vars_array = json_object_get(json_path_get_object(
+            json_object_array_get_idx(part_array, 0), vars_path));
+    if (all_have_parts)
+        return vars_array;
+
+    if (MACSIO_MAIN_Rank == root)
+    {
+        str = strdup(json_object_to_json_string_ext(vars_array, JSON_C_TO_STRING_NO_EXTARR_VALS));
+        len = strlen(str) + 1;
+    }
+    MPI_Bcast(&len, 1, MPI_INT, root, MACSIO_MAIN_Comm);
+    if (MACSIO_MAIN_Rank != root)
+        str = (char *) malloc(len);
+    MPI_Bcast(str, len, MPI_CHAR, root, MACSIO_MAIN_Comm);
+
+    if (!nparts)
+    {
+        /* Without their values, extarrs print as [type, ndims, dims...] */
+        static char const *extarr_keys[] = {"data", "subset"};
+        vars_array = json_tokener_parse(str);
+        for (i = 0; i < json_object_array_length(vars_array); i++)
+        {
+            json_object *var_obj = json_object_array_get_idx(vars_array, i);
+            int k, d;
+
+            for (k = 0; k < 2; k++)
+            {
+                json_object *desc = 0;
+                int dims[4];
+
+                if (!json_object_object_get_ex(var_obj, extarr_keys[k], &desc))
+                    continue;
+                for (d = 0; d < json_object_get_int(json_object_array_get_idx(desc, 1)); d++)
+                    dims[d] = json_object_get_int(json_object_array_get_idx(desc, d+2));
+                json_object_object_add(var_obj, extarr_keys[k], json_object_new_extarr(0,
+                    (enum json_extarr_type) json_object_get_int(json_object_array_get_idx(desc, 0)),
+                    d, dims, JSON_C_EXTARR_DONT_FREE));
+            }
+        }
+    }
+    free(str);
+
+    return vars_array;
+}
+#endif
+
+static void main_dump_sif(json_object *main_obj, int dumpn, double dumpt)
+{
+#ifdef HAVE_MPI
+    int ndims;
+    int i, v;
+    char const *mesh_type = json_object_path_get_string(main_obj, "clargs/part_type");
+    char fileName[256];
+    int nvars, nwrites = 0;
+    sif_write_t *writes;
+
+    hid_t h5file_id;
+    hid_t fapl_id, fcpl_id = make_fcpl();
+    hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+    hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    hsize_t global_log_dims_nodal[3];
+    hsize_t global_log_dims_zonal[3];
+    hsize_t part_chunk_dims[3];
+    int parts_log_dims[3];
+
+#warning FOR MIF, NEED A FILEROOT ARGUMENT OR CHANGE TO FILEFMT ARGUMENT
+    /* Construct name for the HDF5 file */
+    sprintf(fileName, "%s_hdf5_%03d.%s",
+        json_object_path_get_string(main_obj, "clargs/filebase"),
+        dumpn,
+        json_object_path_get_string(main_obj, "clargs/fileext"));
+
+#warning INCLUDE ARGS FOR ISTORE AND K_SYM
+#if H5_HAVE_PARALLEL
+    /* the log VFD and page buffering are serial only */
+    if ((use_log || page_buf_size > 0) && MACSIO_MAIN_Rank == 0)
+        MACSIO_LOG_MSG(Warn, ("Ignoring --log and --page_buffer_size in SIF mode"));
+    fapl_id = make_fapl();
+    H5Pset_fapl_mpio(fapl_id, MACSIO_MAIN_Comm, MACSIO_MAIN_MPIInfo);
+#else
+    fapl_id = make_dump_fapl(fileName);
+#endif
+
+    h5file_id = H5Fcreate(fileName, H5F_ACC_TRUNC, fcpl_id, fapl_id);
+    H5Pclose(fcpl_id);
+
+    /* Create an HDF5 Dataspace for the global whole of mesh and var objects in the file. */
+    ndims = json_object_path_get_int(main_obj, "clargs/part_dim");
+    json_object *global_log_dims_array =
+        json_object_path_get_array(main_obj, "problem/global/LogDims");
+    json_object *global_parts_log_dims_array =
+        json_object_path_get_array(main_obj, "problem/global/PartsLogDims");
+    /* Global LogDims counts the nodes parts share on their boundaries once for each
+       part. In the file, they appear only once. */
+    for (i = 0; i < ndims; i++)
+    {
+        parts_log_dims[i] = JsonGetInt(global_parts_log_dims_array, "", i);
+        global_log_dims_zonal[ndims-1-i] = (hsize_t) JsonGetInt(global_log_dims_array, "", i) -
+            parts_log_dims[i];
+        global_log_dims_nodal[ndims-1-i] = global_log_dims_zonal[ndims-1-i] + 1;
+
+        /* All parts are the same size. The nodes a part owns are as many as its zones
+           but for the last part in each dimension, whose extra nodes are the partial
+           chunk at the end of the dimension. */
+        part_chunk_dims[ndims-1-i] = global_log_dims_zonal[ndims-1-i] / parts_log_dims[i];
+    }
+
+    /* The vars of the first part on any rank as a guide to loop over vars */
+    json_object *part_array = json_object_path_get_array(main_obj, "problem/parts");
+    json_object *vars_template = sif_vars_template(part_array);
+
+    /* Dataset transfer property list used in all H5Dwrite calls */
+#if H5_HAVE_PARALLEL
+    if (no_collective)
+        H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_INDEPENDENT);
+    else
+        H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+#endif
+
+
+    /* Loop over vars, setting up one write of all of this rank's parts for each */
+    nvars = json_object_array_length(vars_template);
+    writes = (sif_write_t *) malloc((2 * nvars + 8) * sizeof(sif_write_t)); /* a subset var needs two */
+    for (v = -1; v < nvars; v++) /* -1 start is for Mesh */
+    {
+        if (v == -1)
+        {
+            nwrites += add_mesh_sif_writes(&writes[nwrites], h5file_id, main_obj, part_array,
+                ndims, parts_log_dims, global_log_dims_nodal, global_log_dims_zonal,
+                chunk_parts ? part_chunk_dims : 0);
+#if !H5_VERSION_GE(1,14,0)
+            flush_sif_writes(writes, nwrites, dxpl_id);
+            nwrites = 0;
+#endif
+            continue;
+        }
+
+        /* Inspect the first part's var object for name, datatype, etc. */
+        json_object *var_obj = json_object_array_get_idx(vars_template, v);
+        char const *varName = json_path_get_string(var_obj, name_path);
+        char *centering = strdup(json_path_get_string(var_obj, centering_path));
+        int ncomps, nsoa;
+        hid_t dtype_id = var_dtype(var_obj, &ncomps, &nsoa);
+        hid_t ds_id;
+
+        if (!strcmp(json_path_get_string(var_obj, type_path), "subset"))
+        {
+            add_subset_var_sif_writes(&writes[nwrites], h5file_id, part_array, v, varName);
+            nwrites += 2;
+            H5Tclose(dtype_id);
+        }
+        else
+        {
+            hsize_t dims[4], chunk[4];
+
+            /* a multi-component var in the soa layout has a leading component dimension,
+               chunked a component at a time */
+            dims[0] = ncomps;
+            chunk[0] = 1;
+            memcpy(dims + nsoa, strcmp(centering, "zone") ? global_log_dims_nodal :
+                global_log_dims_zonal, ndims * sizeof(hsize_t));
+            memcpy(chunk + nsoa, part_chunk_dims, ndims * sizeof(hsize_t));
+
+            /* Create the file dataset (using old-style H5Dcreate API here) */
+            ds_id = create_sif_dataset(h5file_id, varName, dtype_id, ndims + nsoa, dims,
+                chunk_parts ? chunk : 0);
+
+            add_var_sif_write(&writes[nwrites++], ds_id, dtype_id, part_array, v, ndims,
+                parts_log_dims, ncomps, nsoa, !strcmp(centering, "zone"));
+        }
+        free(centering);
+
+#if !H5_VERSION_GE(1,14,0)
+        /* without H5Dwrite_multi(), nothing is gained by holding writes back */
+        flush_sif_writes(writes, nwrites, dxpl_id);
+        nwrites = 0;
+#endif
+    }
+    flush_sif_writes(writes, nwrites, dxpl_id);
+    free(writes);
+    json_object_put(vars_template);
+
+    H5Pclose(dxpl_id);
+    H5Pclose(fapl_id);
+    H5Fclose(h5file_id);
+
+#endif
+}
+
+typedef struct _user_data {
+    hid_t groupId;
+} user_data_t;
+
+static void *CreateHDF5File(const char *fname, const char *nsname, void *userData)
+{
+    hid_t *retval = 0;
+    hid_t fcpl_id = make_fcpl();
+    hid_t fapl_id = make_dump_fapl(fname);
+    hid_t h5File = H5Fcreate(fname, H5F_ACC_TRUNC, fcpl_id, fapl_id);
+    H5Pclose(fapl_id);
+    H5Pclose(fcpl_id);
+    if (h5File >= 0)
+    {
+#warning USE NEWER GROUP CREATION SETTINGS OF HDF5
+        if (nsname && userData)
+        {
+            user_data_t *ud = (user_data_t *) userData;
+            ud->groupId = H5Gcreate1(h5File, nsname, 0);
+        }
+        retval = (hid_t *) malloc(sizeof(hid_t));
+        *retval = h5File;
+    }
+    return (void *) retval;
+}
+
+static void *OpenHDF5File(const char *fname, const char *nsname,
+                   MACSIO_MIF_ioFlags_t ioFlags, void *userData)
+{
+    hid_t *retval = 0;
+    hid_t fapl_id = make_dump_fapl(fname);
+    hid_t h5File = H5Fopen(fname, ioFlags.do_wr ? H5F_ACC_RDWR : H5F_ACC_RDONLY, fapl_id);
+    H5Pclose(fapl_id);
+    if (h5File >= 0)
+    {
+        if (ioFlags.do_wr && nsname && userData)
+        {
+            user_data_t *ud = (user_data_t *) userData;
+            ud->groupId = H5Gcreate1(h5File, nsname, 0);
+        }
+        retval = (hid_t *) malloc(sizeof(hid_t));
+        *retval = h5File;
+    }
+    return (void *) retval;
+}
+
+static void CloseHDF5File(void *file, void *userData)
+{
+    if (userData)
+    {
+        user_data_t *ud = (user_data_t *) userData;
+        H5Gclose(ud->groupId);
+    }
+    H5Fclose(*((hid_t*) file));
+    free(file);
+}
+
+/* Dims of the dataset a part's var is written to in MIF mode. For a multi-component
+   var, the component is the extarr's slowest varying dimension. In the soa layout it
+   stays a dimension of the dataset. In the aos layout it is the compound type's members. */
+static int
+mif_var_dims(json_object *data_obj, int ncomps, int nsoa, hsize_t *var_dims)
+{
+    int j, ndims = json_object_extarr_ndims(data_obj);
+
+    if (ncomps > 1 && nsoa)
+    {
+        var_dims[0] = ncomps;
+        for (j = 0; j < ndims-1; j++)
+            var_dims[j+1] = json_object_extarr_dim(data_obj, j);
+    }
+    else if (ncomps > 1)
+    {
+        for (j = 1; j < ndims; j++)
+            var_dims[j-1] = json_object_extarr_dim(data_obj, j);
+        ndims--;
+    }
+    else
+    {
+        for (j = 0; j < ndims; j++)
+            var_dims[j] = json_object_extarr_dim(data_obj, j);
+    }
+    return ndims;
+}
+
+#if H5_VERSION_GE(1,10,3)
+/* A chunk of a dataset to compress in a pipeline thread and write directly */
+typedef struct _pipe_chunk_t {
+    hid_t ds_id;          /* the chunk's dataset */
+    hsize_t offset[H5S_MAX_RANK];
+    void const *src;      /* the chunk's data */
+    size_t src_nbytes;    /* bytes of data, fewer than nbytes in a partial chunk at the edge */
+    size_t nbytes;        /* bytes of a whole chunk */
+    size_t shuffle_size;  /* element size to shuffle bytes on or 0 not to shuffle */
+    int level;            /* deflate level */
+    int deflate_bit;      /* bit of the deflate filter in the filter mask */
+    void *out;            /* the filtered chunk */
+    size_t out_nbytes;
+    unsigned mask;        /* filters skipped */
+    int done;
+} pipe_chunk_t;
+
+/*!
+\brief A pipeline compressing chunks in threads ahead of their direct writes
+
+Chunks are compressed in the order they were added by a pool of threads, no more than
+a window of chunks ahead of the last chunk written, and written in the same order by
+the calling thread with \c H5Dwrite_chunk as they are done.
+*/
+typedef struct _compress_pipe_t {
+    pipe_chunk_t *chunks;
+    int nchunks, maxchunks;
+    hid_t *dsets;         /* datasets to close when all their chunks are written */
+    int ndsets, maxdsets;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int next;             /* next chunk to compress */
+    int written;          /* chunks written */
+    int window;
+    double compress_secs; /* summed over threads */
+    int busy;             /* threads compressing */
+    double busy_since, busy_secs; /* time with any thread compressing, not stalls */
+    double write_secs;
+} compress_pipe_t;
+
+static compress_pipe_t *
+pipe_new(void)
+{
+    compress_pipe_t *pipe = (compress_pipe_t *) calloc(1, sizeof(compress_pipe_t));
+
+    pthread_mutex_init(&pipe->lock, 0);
+    pthread_cond_init(&pipe->cond, 0);
+    pipe->window = 4 * compress_threads;
+    return pipe;
+}
+
+static void
+pipe_free(compress_pipe_t *pipe)
+{
+    pthread_cond_destroy(&pipe->cond);
+    pthread_mutex_destroy(&pipe->lock);
+    free(pipe->chunks);
+    free(pipe->dsets);
+    free(pipe);
+}
+
+/*!
+\brief Chunk a dataset's creation properties for the pipeline, if it can filter them
+
+The pipeline applies the shuffle and deflate filters itself, so only datasets
+\c make_dcpl() chunked with no other filters can go through it. Those are
+rechunked along their slowest varying dimension into chunks of about
+\c --compress_chunk_size bytes.
+
+\return Non-zero if the dataset's chunks can go through the pipeline
+*/
+static int
+pipe_chunk_dcpl(hid_t dcpl_id, hid_t dtype_id, int ndims, hsize_t const *dims)
+{
+    hsize_t chunk[H5S_MAX_RANK];
+    size_t row_nbytes = H5Tget_size(dtype_id);
+    int i, nfilters;
+
+    if (H5Pget_layout(dcpl_id) != H5D_CHUNKED || ndims < 1)
+        return 0;
+    nfilters = H5Pget_nfilters(dcpl_id);
+    for (i = 0; i < nfilters; i++)
+    {
+        unsigned flags, cd_values[8];
+        size_t ncd = 8;
+        H5Z_filter_t filter = H5Pget_filter2(dcpl_id, i, &flags, &ncd, cd_values, 0, 0, 0);
+        if (filter != H5Z_FILTER_SHUFFLE && filter != H5Z_FILTER_DEFLATE)
+            return 0;
+    }
+
+    for (i = 1; i < ndims; i++)
+        row_nbytes *= dims[i];
+    memcpy(chunk, dims, ndims * sizeof(hsize_t));
+    chunk[0] = MU_MAX((hsize_t) compress_chunk_size / MU_MAX(row_nbytes, 1), 1);
+    if (chunk[0] > dims[0])
+        chunk[0] = MU_MAX(dims[0], 1);
+    H5Pset_chunk(dcpl_id, ndims, chunk);
+    return 1;
+}
+
+/* Queue all the chunks of a dataset created with pipe_chunk_dcpl(). The pipeline
+   closes the dataset. */
+static void
+pipe_add(compress_pipe_t *pipe, hid_t ds_id, void const *buf)
+{
+    hid_t dcpl_id = H5Dget_create_plist(ds_id);
+    hid_t space_id = H5Dget_space(ds_id);
+    hid_t type_id = H5Dget_type(ds_id);
+    hsize_t dims[H5S_MAX_RANK], chunk[H5S_MAX_RANK];
+    int i, ndims = H5Sget_simple_extent_ndims(space_id);
+    int nfilters = H5Pget_nfilters(dcpl_id);
+    size_t shuffle_size = 0, row_nbytes = H5Tget_size(type_id);
+    int level = 0, deflate_bit = 0;
+    hsize_t row;
+
+    H5Sget_simple_extent_dims(space_id, dims, 0);
+    H5Pget_chunk(dcpl_id, ndims, chunk);
+    for (i = 0; i < nfilters; i++)
+    {
+        unsigned flags, cd_values[8];
+        size_t ncd = 8;
+        H5Z_filter_t filter = H5Pget_filter2(dcpl_id, i, &flags, &ncd, cd_values, 0, 0, 0);
+        if (filter == H5Z_FILTER_SHUFFLE)
+            shuffle_size = cd_values[0]; /* the element size, set when the dataset was created */
+        else if (filter == H5Z_FILTER_DEFLATE)
+        {
+            level = cd_values[0];
+            deflate_bit = i;
+        }
+    }
+    for (i = 1; i < ndims; i++)
+        row_nbytes *= dims[i];
+    H5Tclose(type_id);
+    H5Sclose(space_id);
+    H5Pclose(dcpl_id);
+
+    for (row = 0; row < dims[0]; row += chunk[0])
+    {
+        pipe_chunk_t *c;
+        hsize_t nrows = dims[0] - row;
+
+        if (pipe->nchunks == pipe->maxchunks)
+        {
+            pipe->maxchunks = pipe->maxchunks ? 2 * pipe->maxchunks : 64;
+            pipe->chunks = (pipe_chunk_t *) realloc(pipe->chunks, pipe->maxchunks * sizeof(pipe_chunk_t));
+        }
+        c = &pipe->chunks[pipe->nchunks++];
+        memset(c, 0, sizeof(pipe_chunk_t));
+        c->ds_id = ds_id;
+        c->offset[0] = row;
+        c->src = (char const *) buf + row * row_nbytes;
+        c->nbytes = chunk[0] * row_nbytes;
+        c->src_nbytes = (nrows < chunk[0] ? nrows : chunk[0]) * row_nbytes;
+        c->shuffle_size = shuffle_size;
+        c->level = level;
+        c->deflate_bit = deflate_bit;
+    }
+
+    if (pipe->ndsets == pipe->maxdsets)
+    {
+        pipe->maxdsets = pipe->maxdsets ? 2 * pipe->maxdsets : 16;
+        pipe->dsets = (hid_t *) realloc(pipe->dsets, pipe->maxdsets * sizeof(hid_t));
+    }
+    pipe->dsets[pipe->ndsets++] = ds_id;
+}
+
+/* Shuffle and deflate a chunk as HDF5's filters would. A partial chunk is padded
+   with zeros to a whole chunk. A chunk deflate does not shrink is stored shuffled
+   but not deflated, with the deflate filter's bit set in its filter mask. */
+static void
+pipe_compress(pipe_chunk_t *c)
+{
+    unsigned char const *in = (unsigned char const *) c->src;
+    unsigned char *padded = 0, *shuffled = 0;
+    uLongf out_nbytes = compressBound(c->nbytes);
+
+    if (c->src_nbytes < c->nbytes)
+    {
+        padded = (unsigned char *) calloc(c->nbytes, 1);
+        memcpy(padded, in, c->src_nbytes);
+        in = padded;
+    }
+    if (c->shuffle_size > 1)
+    {
+        size_t i, j, n = c->nbytes / c->shuffle_size;
+        shuffled = (unsigned char *) malloc(c->nbytes);
+        for (j = 0; j < c->shuffle_size; j++)
+            for (i = 0; i < n; i++)
+                shuffled[j*n + i] = in[i*c->shuffle_size + j];
+        memcpy(shuffled + n * c->shuffle_size, in + n * c->shuffle_size, c->nbytes % c->shuffle_size);
+        in = shuffled;
+    }
+
+    c->out = malloc(out_nbytes);
+    if (compress2((Bytef *) c->out, &out_nbytes, in, c->nbytes, c->level) != Z_OK ||
+        out_nbytes >= c->nbytes)
+    {
+        memcpy(c->out, in, c->nbytes);
+        out_nbytes = c->nbytes;
+        c->mask |= 1u << c->deflate_bit;
+    }
+    c->out_nbytes = out_nbytes;
+
+    free(shuffled);
+    free(padded);
+}
+
+static void *
+pipe_worker(void *arg)
+{
+    compress_pipe_t *pipe = (compress_pipe_t *) arg;
+
+    pthread_mutex_lock(&pipe->lock);
+    while (1)
+    {
+        int i;
+        double t0, t1;
+
+        while (pipe->next < pipe->nchunks && pipe->next >= pipe->written + pipe->window)
+            pthread_cond_wait(&pipe->cond, &pipe->lock);
+        if (pipe->next >= pipe->nchunks)
+            break;
+        i = pipe->next++;
+        t0 = MT_Time();
+        if (pipe->busy++ == 0)
+            pipe->busy_since = t0;
+        pthread_mutex_unlock(&pipe->lock);
+
+        pipe_compress(&pipe->chunks[i]);
+
+        pthread_mutex_lock(&pipe->lock);
+        t1 = MT_Time();
+        pipe->chunks[i].done = 1;
+        pipe->compress_secs += t1 - t0;
+        if (--pipe->busy == 0)
+            pipe->busy_secs += t1 - pipe->busy_since;
+        pthread_cond_broadcast(&pipe->cond);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+    return 0;
+}
+
+/* Compress and write all the chunks queued, then log how it went */
+static void
+pipe_run(compress_pipe_t *pipe)
+{
+    pthread_t *threads = (pthread_t *) malloc(compress_threads * sizeof(pthread_t));
+    double raw_nbytes = 0, out_nbytes = 0;
+    char raw_str[32], out_str[32], bw_str[32], cbw_str[32], wbw_str[32];
+    int i, nthreads = 0;
+
+    for (i = 0; i < compress_threads; i++)
+        if (pthread_create(&threads[nthreads], 0, pipe_worker, pipe) == 0)
+            nthreads++;
+    if (!nthreads)
+    {
+        pipe->window = pipe->nchunks;
+        pipe_worker(pipe); /* compress them all up front */
+    }
+
+    for (i = 0; i < pipe->nchunks; i++)
+    {
+        pipe_chunk_t *c = &pipe->chunks[i];
+        double t1;
+
+        pthread_mutex_lock(&pipe->lock);
+        while (!c->done)
+            pthread_cond_wait(&pipe->cond, &pipe->lock);
+        pthread_mutex_unlock(&pipe->lock);
+
+        t1 = MT_Time();
+        if (H5Dwrite_chunk(c->ds_id, H5P_DEFAULT, c->mask, c->offset, c->out_nbytes, c->out) < 0)
+            MACSIO_LOG_MSG(Warn, ("Direct write of a compressed chunk failed"));
+        pipe->write_secs += MT_Time() - t1;
+        raw_nbytes += c->nbytes;
+        out_nbytes += c->out_nbytes;
+        free(c->out);
+
+        pthread_mutex_lock(&pipe->lock);
+        pipe->written++;
+        pthread_cond_broadcast(&pipe->cond);
+        pthread_mutex_unlock(&pipe->lock);
+    }
+
+    for (i = 0; i < nthreads; i++)
+        pthread_join(threads[i], 0);
+    free(threads);
+    for (i = 0; i < pipe->ndsets; i++)
+        H5Dclose(pipe->dsets[i]);
+
+    if (!pipe->nchunks)
+        return;
+    MACSIO_LOG_MSG(Info, ("Compressed %d chunks: %s to %s, ratio %.3f", pipe->nchunks,
+        MU_PrByts(raw_nbytes, 0, raw_str, sizeof(raw_str)),
+        MU_PrByts(out_nbytes, 0, out_str, sizeof(out_str)),
+        out_nbytes ? raw_nbytes / out_nbytes : 0.0));
+    MACSIO_LOG_MSG(Info, ("Compress BW: %s per thread, %s in %d threads",
+        MU_PrBW(raw_nbytes, pipe->compress_secs, 0, cbw_str, sizeof(cbw_str)),
+        MU_PrBW(raw_nbytes, pipe->busy_secs, 0, bw_str, sizeof(bw_str)),
+        nthreads ? nthreads : 1));
+    MACSIO_LOG_MSG(Info, ("Direct chunk write BW: %s",
+        MU_PrBW(out_nbytes, pipe->write_secs, 0, wbw_str, sizeof(wbw_str))));
+}
+#else
+typedef struct _compress_pipe_t compress_pipe_t;
+#endif
+
+/* Create a dataset of a MIF file and write it, through the compression pipeline
+   when there is one and it can filter the dataset */
+static void
+write_mif_dataset(hid_t h5loc, char const *name, hid_t dtype_id, int ndims, hsize_t const *dims,
+    void const *buf, compress_pipe_t *pipe)
+{
+    hid_t fspace_id = H5Screate_simple(ndims, dims, 0);
+    hid_t dcpl_id = make_var_dcpl(name, fspace_id, dtype_id);
+    hid_t ds_id;
+
+#if H5_VERSION_GE(1,10,3)
+    if (pipe && pipe_chunk_dcpl(dcpl_id, dtype_id, ndims, dims))
+    {
+        ds_id = H5Dcreate1(h5loc, name, dtype_id, fspace_id, dcpl_id);
+        pipe_add(pipe, ds_id, buf);
+        H5Pclose(dcpl_id);
+        H5Sclose(fspace_id);
+        return;
+    }
+#endif
+    ds_id = H5Dcreate1(h5loc, name, dtype_id, fspace_id, dcpl_id);
+    H5Dwrite(ds_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf);
+    H5Dclose(ds_id);
+    H5Pclose(dcpl_id);
+    H5Sclose(fspace_id);
+}
+
+static void write_mesh_part(hid_t h5loc, json_object *part_obj, compress_pipe_t *pipe)
+{
+#warning WERE SKPPING THE MESH (COORDS) OBJECT PRESENTLY
+    int i;
+    json_object *vars_array = json_path_get_object(part_obj, vars_path);
+
+    for (i = 0; i < json_object_array_length(vars_array); i++)
+    {
+        int ncomps, nsoa, ndims;
+        hsize_t var_dims[4];
+        json_object *var_obj = json_object_array_get_idx(vars_array, i);
+        json_object *data_obj = json_path_get_object(var_obj, data_path);
+        char const *varname = json_path_get_string(var_obj, name_path);
+        hid_t dtype_id = var_dtype(var_obj, &ncomps, &nsoa);
+
+        ndims = mif_var_dims(data_obj, ncomps, nsoa, var_dims);
+        write_mif_dataset(h5loc, varname, dtype_id, ndims, var_dims,
+            json_object_extarr_data(data_obj), pipe);
+        H5Tclose(dtype_id);
+
+        /* the zone indices of a subset var go alongside its values */
+        if (!strcmp(json_path_get_string(var_obj, type_path), "subset"))
+        {
+            json_object *subset_obj = json_path_get_object(var_obj, subset_path);
+            char subset_name[256];
+
+            snprintf(subset_name, sizeof(subset_name), "%s_subset", varname);
+            var_dims[0] = json_object_extarr_nvals(subset_obj);
+            write_mif_dataset(h5loc, subset_name, H5T_NATIVE_INT, 1, var_dims,
+                json_object_extarr_data(subset_obj), pipe);
+        }
+    }
+}
+
+/* Columns of a packed index row: chunk id, offset then up to 4 dims */
+#define PACKED_INDEX_NCOLS 6
+/* Rows of a packed index chunk */
+#define PACKED_INDEX_CHUNK_ROWS 64
+
+/*!
+\brief Append the slabs of all of a rank's parts to a packed MIF dataset
+
+A packed dataset is 1D and extendible. It holds the slabs of all the parts written to
+the file, one after the other. The first rank to write to the file creates it and each
+rank extends it with a single write of all of its parts' slabs. Its \c <name>_index
+dataset gets a row for each part holding the part's chunk id, the offset of its slab
+in elements and the dims of the dataset the part would have had in the unpacked
+layout, 0 beyond its rank.
+*/
+static void
+append_packed(
+    hid_t h5loc,               /**< [in] Where the packed datasets live */
+    char const *name,          /**< [in] Name of the packed dataset */
+    hid_t dtype_id,            /**< [in] Type of the slabs' elements */
+    int nparts,                /**< [in] Number of parts */
+    void const * const *bufs,  /**< [in] Each part's slab */
+    hsize_t const *nvals,      /**< [in] Number of elements of each part's slab */
+    long long *rows            /**< [in,out] nparts index rows, filled in here with offsets */
+)
+{
+    char index_name[256];
+    hsize_t total = 0, dims[2], maxdims[2] = {H5S_UNLIMITED, PACKED_INDEX_NCOLS};
+    hsize_t start[2] = {0, 0}, count[2] = {0, PACKED_INDEX_NCOLS};
+    size_t elsize = H5Tget_size(dtype_id);
+    hid_t ds_id, idx_id, fspace_id, mspace_id;
+    char *buf, *dst;
+    int p;
+
+    for (p = 0; p < nparts; p++)
+        total += nvals[p];
+
+    snprintf(index_name, sizeof(index_name), "%s_index", name);
+    if (H5Lexists(h5loc, name, H5P_DEFAULT) > 0)
+    {
+        ds_id = H5Dopen2(h5loc, name, H5P_DEFAULT);
+        idx_id = H5Dopen2(h5loc, index_name, H5P_DEFAULT);
+    }
+    else
+    {
+        /* chunked as --compress_chunk_size says, not by what the first rank to write
+           has, so the layout does not depend on which rank that is */
+        hid_t dcpl_id;
+
+        dims[0] = total ? total : 1;
+        fspace_id = H5Screate_simple(1, dims, 0);
+        dcpl_id = make_var_dcpl(name, fspace_id, dtype_id);
+        dims[0] = MU_MAX((hsize_t) compress_chunk_size / elsize, 1);
+        H5Pset_chunk(dcpl_id, 1, dims);
+        H5Sclose(fspace_id);
+        dims[0] = 0;
+        fspace_id = H5Screate_simple(1, dims, maxdims);
+        ds_id = H5Dcreate1(h5loc, name, dtype_id, fspace_id, dcpl_id);
+        H5Sclose(fspace_id);
+        H5Pclose(dcpl_id);
+
+        dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+        dims[0] = PACKED_INDEX_CHUNK_ROWS;
+        dims[1] = PACKED_INDEX_NCOLS;
+        H5Pset_chunk(dcpl_id, 2, dims);
+        dims[0] = 0;
+        fspace_id = H5Screate_simple(2, dims, maxdims);
+        idx_id = H5Dcreate1(h5loc, index_name, H5T_NATIVE_LLONG, fspace_id, dcpl_id);
+        H5Sclose(fspace_id);
+        H5Pclose(dcpl_id);
+    }
+
+    /* this rank's slabs go after those of the ranks before it */
+    fspace_id = H5Dget_space(ds_id);
+    H5Sget_simple_extent_dims(fspace_id, start, 0);
+    H5Sclose(fspace_id);
+    for (p = 0; p < nparts; p++)
+    {
+        rows[p*PACKED_INDEX_NCOLS+1] = (long long) start[0];
+        start[0] += nvals[p];
+    }
+    start[0] -= total;
+
+    if (total)
+    {
+        dims[0] = start[0] + total;
+        H5Dset_extent(ds_id, dims);
+        fspace_id = H5Dget_space(ds_id);
+        H5Sselect_hyperslab(fspace_id, H5S_SELECT_SET, start, 0, &total, 0);
+        mspace_id = H5Screate_simple(1, &total, 0);
+        if (nparts == 1)
+            buf = (char *) bufs[0];
+        else
+        {
+            buf = dst = (char *) malloc(total * elsize);
+            for (p = 0; p < nparts; p++)
+            {
+                memcpy(dst, bufs[p], nvals[p] * elsize);
+                dst += nvals[p] * elsize;
+            }
+        }
+        H5Dwrite(ds_id, dtype_id, mspace_id, fspace_id, H5P_DEFAULT, buf);
+        if (nparts > 1)
+            free(buf);
+        H5Sclose(mspace_id);
+        H5Sclose(fspace_id);
+    }
+
+    fspace_id = H5Dget_space(idx_id);
+    H5Sget_simple_extent_dims(fspace_id, dims, 0);
+    H5Sclose(fspace_id);
+    start[0] = dims[0];
+    count[0] = nparts;
+    dims[0] += nparts;
+    H5Dset_extent(idx_id, dims);
+    fspace_id = H5Dget_space(idx_id);
+    H5Sselect_hyperslab(fspace_id, H5S_SELECT_SET, start, 0, count, 0);
+    mspace_id = H5Screate_simple(2, count, 0);
+    H5Dwrite(idx_id, H5T_NATIVE_LLONG, mspace_id, fspace_id, H5P_DEFAULT, rows);
+    H5Sclose(mspace_id);
+    H5Sclose(fspace_id);
+
+    H5Dclose(idx_id);
+    H5Dclose(ds_id);
+}
+
+/* Write the vars of all of a rank's parts to packed datasets, a var at a time */
+static void write_packed_parts(hid_t h5loc, json_object *parts)
+{
+    int i, p, nparts = json_object_array_length(parts);
+    json_object *vars_array;
+    void const **bufs;
+    hsize_t *nvals;
+    long long *rows;
+
+    if (!nparts)
+        return;
+
+    vars_array = json_path_get_object(json_object_array_get_idx(parts, 0), vars_path);
+    bufs = (void const **) malloc(nparts * sizeof(void const *));
+    nvals = (hsize_t *) malloc(nparts * sizeof(hsize_t));
+    rows = (long long *) malloc(nparts * PACKED_INDEX_NCOLS * sizeof(long long));
+
+    for (i = 0; i < json_object_array_length(vars_array); i++)
+    {
+        json_object *var_obj = json_object_array_get_idx(vars_array, i);
+        char const *varname = json_path_get_string(var_obj, name_path);
+        int is_subset = !strcmp(json_path_get_string(var_obj, type_path), "subset");
+        int ncomps, nsoa;
+        hid_t dtype_id = var_dtype(var_obj, &ncomps, &nsoa);
+
+        for (p = 0; p < nparts; p++)
+        {
+            json_object *part_obj = json_object_array_get_idx(parts, p);
+            json_object *part_var_obj = json_object_array_get_idx(
+                json_path_get_object(part_obj, vars_path), i);
+            json_object *data_obj = json_path_get_object(part_var_obj, data_path);
+            long long *row = rows + p*PACKED_INDEX_NCOLS;
+            hsize_t var_dims[4] = {0, 0, 0, 0};
+            int d, ndims = mif_var_dims(data_obj, ncomps, nsoa, var_dims);
+
+            bufs[p] = json_object_extarr_data(data_obj);
+            row[0] = json_path_get_int(part_obj, chunk_id_path);
+            for (d = 0, nvals[p] = 1; d < 4; d++)
+            {
+                row[2+d] = (long long) var_dims[d];
+                if (d < ndims) nvals[p] *= var_dims[d];
+            }
+        }
+        append_packed(h5loc, varname, dtype_id, nparts, bufs, nvals, rows);
+        H5Tclose(dtype_id);
+
+        /* the zone indices of a subset var go alongside its values */
+        if (is_subset)
+        {
+            char subset_name[256];
+
+            for (p = 0; p < nparts; p++)
+            {
+                json_object *part_obj = json_object_array_get_idx(parts, p);
+                json_object *subset_obj = json_path_get_object(json_object_array_get_idx(
+                    json_path_get_object(part_obj, vars_path), i), subset_path);
+                long long *row = rows + p*PACKED_INDEX_NCOLS;
+
+                bufs[p] = json_object_extarr_data(subset_obj);
+                nvals[p] = json_object_extarr_nvals(subset_obj);
+                row[0] = json_path_get_int(part_obj, chunk_id_path);
+                row[2] = (long long) nvals[p];
+                row[3] = row[4] = row[5] = 0;
+            }
+            snprintf(subset_name, sizeof(subset_name), "%s_subset", varname);
+            append_packed(h5loc, subset_name, H5T_NATIVE_INT, nparts, bufs, nvals, rows);
+        }
+    }
+
+    free(rows);
+    free(nvals);
+    free(bufs);
+}
+
+/* Write all of a rank's parts to a MIF file, packed or a group per part */
+static void write_mif_parts(hid_t h5loc, json_object *parts, int packed)
+{
+    compress_pipe_t *pipe = 0;
+
+    if (packed)
+    {
+        write_packed_parts(h5loc, parts);
+        return;
+    }
+
+#if H5_VERSION_GE(1,10,3)
+    if (compress_threads > 0)
+        pipe = pipe_new();
+#endif
+
+    for (int i = 0; i < json_object_array_length(parts); i++)
+    {
+        char domain_dir[256];
+        json_object *this_part = json_object_array_get_idx(parts, i);
+        hid_t domain_group_id;
+
+        snprintf(domain_dir, sizeof(domain_dir), "domain_%07d",
+            json_path_get_int(this_part, chunk_id_path));
+ 
+        domain_group_id = H5Gcreate1(h5loc, domain_dir, 0);
+
+        write_mesh_part(domain_group_id, this_part, pipe);
+
+        H5Gclose(domain_group_id);
+    }
+
+#if H5_VERSION_GE(1,10,3)
+    if (pipe)
+    {
+        pipe_run(pipe);
+        pipe_free(pipe);
+    }
+#endif
+}
+
+/* MPI tag of the baton used to group ranks for file images */
+#define MIF_IMAGE_TAG 4
+
+/* The images themselves are tagged per dump, so that an image a fast rank sends for the
+   next dump is never received as part of the current one. MPI guarantees tags up to
+   32767. */
+#define MIF_IMAGE_DUMP_TAG(dumpn) (16 + (dumpn) % 32000)
+
+/*!
+\brief Build a rank's parts in an HDF5 file image
+
+The image is built with the core VFD, without a backing store, just as the parts would
+be written to a MIF file.
+
+\return The image, which the caller must free
+*/
+static void *
+make_file_image(
+    json_object *parts, /**< [in] The rank's parts */
+    int packed,         /**< [in] Use the packed layout */
+    size_t *nbytes      /**< [out] Size of the image in bytes */
+)
+{
+    char name[64];
+    hid_t fapl_id = make_fapl();
+    hid_t fid;
+    ssize_t n;
+    void *image;
+
+    H5Pset_fapl_core(fapl_id, 1<<20, 0);
+    snprintf(name, sizeof(name), "macsio_hdf5_image_%05d", MACSIO_MAIN_Rank);
+    fid = H5Fcreate(name, H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
     H5Pclose(fapl_id);
-    H5Fclose(h5file_id);
 
-#endif
+    write_mif_parts(fid, parts, packed);
+    H5Fflush(fid, H5F_SCOPE_GLOBAL);
+
+    n = H5Fget_file_image(fid, 0, 0);
+    if (n < 0)
+        MACSIO_LOG_MSG(Die, ("Unable to get the size of the file image"));
+    if (n > INT_MAX)
+        MACSIO_LOG_MSG(Die, ("File image of %lld bytes exceeds the 2 GiB limit",
+            (long long) n));
+    image = malloc(n > 0 ? n : 1);
+    if (n > 0 && H5Fget_file_image(fid, image, n) < 0)
+        MACSIO_LOG_MSG(Die, ("Unable to get the file image"));
+    H5Fclose(fid);
+
+    *nbytes = (size_t) n;
+    return image;
+}
+
+static herr_t copy_image_object(hid_t loc_id, char const *name, H5L_info_t const *info,
+    void *dst_file)
+{
+    return H5Ocopy(loc_id, name, *((hid_t *) dst_file), name, H5P_DEFAULT, H5P_DEFAULT);
+}
+
+/* Copy the objects at the root of a file image to the root of a file */
+static void merge_file_image(hid_t fid, void *image, size_t nbytes)
+{
+    hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+    hid_t img_id;
+
+    H5Pset_fapl_core(fapl_id, 1<<20, 0);
+    H5Pset_file_image(fapl_id, image, nbytes);
+    img_id = H5Fopen("macsio_hdf5_image", H5F_ACC_RDONLY, fapl_id);
+    H5Pclose(fapl_id);
+
+    H5Literate(img_id, H5_INDEX_NAME, H5_ITER_NATIVE, 0, copy_image_object, &fid);
+    H5Fclose(img_id);
+}
+
+/* Store a file image as is, in an opaque dataset named for the rank it came from */
+static void store_file_image(hid_t fid, void const *image, size_t nbytes, int src)
+{
+    char name[64];
+    hsize_t dims = nbytes;
+    hid_t type_id = H5Tcreate(H5T_OPAQUE, 1);
+    hid_t space_id = H5Screate_simple(1, &dims, 0);
+    hid_t ds_id;
+
+    H5Tset_tag(type_id, "HDF5 file image");
+    snprintf(name, sizeof(name), "image_%05d", src);
+    ds_id = H5Dcreate1(fid, name, type_id, space_id, H5P_DEFAULT);
+    H5Dwrite(ds_id, type_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, image);
+    H5Dclose(ds_id);
+    H5Sclose(space_id);
+    H5Tclose(type_id);
+}
+
+/*!
+\brief Write MIF files with file images shipped to aggregators
+
+Ranks are grouped as for the baton. The first rank of each group is its aggregator and
+creates the group's file. Every other rank builds its parts in a file image and sends it
+to the aggregator with a tag derived from the dump number. The aggregator receives the
+dump's images in the order they arrive, each sized with \c MPI_Get_count after probing
+for it, and copies or stores them in the file. In copy mode, the aggregator writes its
+own parts directly to the file.
+*/
+static void main_dump_mif_images(json_object *main_obj, int numFiles, int dumpn, double dumpt)
+{
+    MACSIO_MIF_ioFlags_t ioFlags = {MACSIO_MIF_WRITE, 0};
+    MACSIO_MIF_baton_t *bat = MACSIO_MIF_Init(numFiles, ioFlags, MACSIO_MAIN_Comm, MIF_IMAGE_TAG,
+        CreateHDF5File, OpenHDF5File, CloseHDF5File, 0);
+    json_object *parts = json_object_path_get_array(main_obj, "problem/parts");
+    int rank = MACSIO_MAIN_Rank;
+    int group = MACSIO_MIF_RankOfGroup(bat, rank);
+    int agg = rank - MACSIO_MIF_RankInGroup(bat, rank);
+    int copy = !strcmp(mif_images_str, "copy");
+    int packed = mif_packed && !copy;
+    int tag = MIF_IMAGE_DUMP_TAG(dumpn);
+    size_t nbytes;
+    void *image;
+
+    if (strcmp(mif_images_str, "copy") && strcmp(mif_images_str, "store"))
+        MACSIO_LOG_MSG(Die, ("--mif_images must be either \"copy\" or \"store\""));
+    if (mif_packed && copy && rank == 0)
+        MACSIO_LOG_MSG(Warn, ("--mif_packed is ignored with --mif_images copy"));
+
+    if (rank != agg)
+    {
+        image = make_file_image(parts, packed, &nbytes);
+        mpi_errno = MPI_Send(image, (int) nbytes, MPI_BYTE, agg, tag, MACSIO_MAIN_Comm);
+        free(image);
+    }
+    else
+    {
+        char fileName[256];
+        hid_t fapl_id, fcpl_id = make_fcpl();
+        hid_t fid;
+        int src, nsrcs = 0;
+
+        sprintf(fileName, "%s_hdf5_%05d_%03d.%s",
+            json_object_path_get_string(main_obj, "clargs/filebase"), group, dumpn,
+            json_object_path_get_string(main_obj, "clargs/fileext"));
+        fapl_id = make_dump_fapl(fileName);
+        fid = H5Fcreate(fileName, H5F_ACC_TRUNC, fcpl_id, fapl_id);
+        H5Pclose(fapl_id);
+        H5Pclose(fcpl_id);
+
+        if (copy)
+            write_mif_parts(fid, parts, 0);
+        else
+        {
+            image = make_file_image(parts, packed, &nbytes);
+            store_file_image(fid, image, nbytes, rank);
+            free(image);
+        }
+
+        for (src = agg + 1; src < MACSIO_MAIN_Size && MACSIO_MIF_RankOfGroup(bat, src) == group; src++)
+            nsrcs++;
+        for (src = 0; src < nsrcs; src++)
+        {
+            MPI_Status status;
+            int count;
+
+            MPI_Probe(MPI_ANY_SOURCE, tag, MACSIO_MAIN_Comm, &status);
+            MPI_Get_count(&status, MPI_BYTE, &count);
+            image = malloc(count > 0 ? count : 1);
+            mpi_errno = MPI_Recv(image, count, MPI_BYTE, status.MPI_SOURCE, tag,
+                MACSIO_MAIN_Comm, MPI_STATUS_IGNORE);
+            if (copy)
+                merge_file_image(fid, image, (size_t) count);
+            else
+                store_file_image(fid, image, (size_t) count, status.MPI_SOURCE);
+            free(image);
+        }
+
+        H5Fclose(fid);
+    }
+
+    MACSIO_MIF_Finish(bat);
+}
+
+static void main_dump_mif(json_object *main_obj, int numFiles, int dumpn, double dumpt)
+{
+    int size, rank;
+    hid_t *h5File_ptr;
+    hid_t h5File;
+    hid_t h5Group;
+    char fileName[256];
+    int i, len;
+    int *theData;
+    user_data_t userData;
+    MACSIO_MIF_ioFlags_t ioFlags = {MACSIO_MIF_WRITE,
+        JsonGetInt(main_obj, "clargs/exercise_scr")&0x1};
+
+    if (strlen(mif_images_str))
+    {
+        main_dump_mif_images(main_obj, numFiles, dumpn, dumpt);
+        return;
+    }
+
+#warning MAKE WHOLE FILE USE HDF5 1.8 INTERFACE
+#warning SET FILE AND DATASET PROPERTIES
+#warning DIFFERENT MPI TAGS FOR DIFFERENT PLUGINS AND CONTEXTS
+    MACSIO_MIF_baton_t *bat = MACSIO_MIF_Init(numFiles, ioFlags, MACSIO_MAIN_Comm, 3,
+        CreateHDF5File, OpenHDF5File, CloseHDF5File, &userData);
+
+    rank = json_object_path_get_int(main_obj, "parallel/mpi_rank");
+    size = json_object_path_get_int(main_obj, "parallel/mpi_size");
+
+    /* Construct name for the silo file */
+    sprintf(fileName, "%s_hdf5_%05d_%03d.%s",
+        json_object_path_get_string(main_obj, "clargs/filebase"),
+        MACSIO_MIF_RankOfGroup(bat, rank),
+        dumpn,
+        json_object_path_get_string(main_obj, "clargs/fileext"));
+
+    h5File_ptr = (hid_t *) MACSIO_MIF_WaitForBaton(bat, fileName, 0);
+    h5File = *h5File_ptr;
+    h5Group = userData.groupId;
+
+    json_object *parts = json_object_path_get_array(main_obj, "problem/parts");
+
+    write_mif_parts(h5File, parts, mif_packed);
+
+    /* If this is the 'root' processor, also write Silo's multi-XXX objects */
+#if 0
+    if (rank == 0)
+        WriteMultiXXXObjects(main_obj, siloFile, bat);
+#endif
+
+    /* Hand off the baton to the next processor. This winds up closing
+     * the file so that the next processor that opens it can be assured
+     * of getting a consistent and up to date view of the file's contents. */
+    MACSIO_MIF_HandOffBaton(bat, h5File_ptr);
+
+    /* We're done using MACSIO_MIF, so finish it off */
+    MACSIO_MIF_Finish(bat);
+
+}
+
+static void main_dump(int argi, int argc, char **argv, json_object *main_obj,
+    int dumpn, double dumpt)
+{
+    int rank, size, numFiles;
+
+#warning SET ERROR MODE OF HDF5 LIBRARY
+
+    /* Without this barrier, I get strange behavior with Silo's MACSIO_MIF interface */
+    mpi_errno = MPI_Barrier(MACSIO_MAIN_Comm);
+
+    /* process cl args */
+    process_args(argi, argc, argv);
+    alignment = json_object_path_get_int(main_obj, "clargs/alignment");
+    resolve_compression(main_obj);
+
+    rank = json_object_path_get_int(main_obj, "parallel/mpi_rank");
+    size = json_object_path_get_int(main_obj, "parallel/mpi_size");
+
+#warning MOVE TO A FUNCTION
+    /* ensure we're in MIF mode and determine the file count */
+    json_object *parfmode_obj = json_object_path_get_array(main_obj, "clargs/parallel_file_mode");
+    if (parfmode_obj)
+    {
+        json_object *modestr = json_object_array_get_idx(parfmode_obj, 0);
+        json_object *filecnt = json_object_array_get_idx(parfmode_obj, 1);
+#warning ERRORS NEED TO GO TO LOG FILES AND ERROR BEHAVIOR NEEDS TO BE HONORED
+        if (!strcmp(json_object_get_string(modestr), "SIF"))
+        {
+            main_dump_sif(main_obj, dumpn, dumpt);
+        }
+        else
+        {
+            numFiles = json_object_get_int(filecnt);
+            main_dump_mif(main_obj, numFiles, dumpn, dumpt);
+        }
+    }
+    else
+    {
+        char const * modestr = json_object_path_get_string(main_obj, "clargs/parallel_file_mode");
+        if (!strcmp(modestr, "SIF"))
+            main_dump_sif(main_obj, dumpn, dumpt);
+        else
+        {
+            if (!strcmp(modestr, "MIFMAX"))
+                numFiles = json_object_path_get_int(main_obj, "parallel/mpi_size");
+            else if (!strcmp(modestr, "MIFAUTO"))
+            {
+                /* Call utility to determine optimal file count */
+#warning ADD UTILIT TO DETERMINE OPTIMAL FILE COUNT
+            }
+            main_dump_mif(main_obj, numFiles, dumpn, dumpt);
+        }
+    }
+
+    log_io_histograms();
+}
+
+/* Whether --read_vars, a comma or space separated list, names a var. All vars are
+   read when it is "all" or empty. */
+static int
+read_var_wanted(char const *read_vars, char const *name)
+{
+    size_t n = strlen(name);
+    char const *p = read_vars;
+
+    if (!read_vars[0] || !strcmp(read_vars, "all"))
+        return 1;
+    while (*(p += strspn(p, ", ")))
+    {
+        size_t len = strcspn(p, ", ");
+        if (len == n && !strncmp(p, name, n))
+            return 1;
+        p += len;
+    }
+    return 0;
+}
+
+typedef struct _list_names_t {
+    H5I_type_t type;
+    json_object *names;
+} list_names_t;
+
+static herr_t list_name(hid_t loc_id, char const *name, H5L_info_t const *info, void *data)
+{
+    list_names_t *ln = (list_names_t *) data;
+    hid_t obj_id = H5Oopen(loc_id, name, H5P_DEFAULT);
+
+    if (obj_id < 0)
+        return 0;
+    if (H5Iget_type(obj_id) == ln->type)
+        json_object_array_add(ln->names, json_object_new_string(name));
+    H5Oclose(obj_id);
+    return 0;
+}
+
+/* The names of the groups or datasets in a group, in name order. The caller owns the array. */
+static json_object *
+list_names(hid_t loc_id, H5I_type_t type)
+{
+    list_names_t ln = {type, json_object_new_array()};
+
+    H5Literate(loc_id, H5_INDEX_NAME, H5_ITER_INC, 0, list_name, &ln);
+    return ln.names;
+}
+
+static int
+has_name(json_object *names, char const *name)
+{
+    int i;
+
+    for (i = 0; i < json_object_array_length(names); i++)
+        if (!strcmp(json_object_get_string(json_object_array_get_idx(names, i)), name))
+            return 1;
+    return 0;
+}
+
+/*!
+\brief The vars in a group of a file written by \c main_dump() that \c --read_vars names
+
+Every dataset in the group is a var but for the \c _subset companions of subset vars
+and, in a packed MIF file, the \c _index companions of the packed datasets.
+
+\return An array of the names of the vars, in name order. The caller owns it.
+*/
+static json_object *
+list_read_vars(hid_t grp_id, char const *read_vars)
+{
+    static char const *suffixes[] = {"_index", "_subset"};
+    json_object *names = list_names(grp_id, H5I_DATASET);
+    json_object *vars = json_object_new_array();
+    int i, s;
+
+    for (i = 0; i < json_object_array_length(names); i++)
+    {
+        char const *name = json_object_get_string(json_object_array_get_idx(names, i));
+        int n = (int) strlen(name), companion = 0;
+
+        for (s = 0; s < 2 && !companion; s++)
+        {
+            int m = (int) strlen(suffixes[s]);
+            char base[256];
+
+            if (n <= m || strcmp(name + n - m, suffixes[s]))
+                continue;
+            snprintf(base, sizeof(base), "%.*s", n - m, name);
+            companion = has_name(names, base);
+        }
+        if (!companion && read_var_wanted(read_vars, name))
+            json_object_array_add(vars, json_object_new_string(name));
+    }
+    json_object_put(names);
+    return vars;
+}
+
+/*!
+\brief Make an extarr to read elements of a dataset into
+
+The extarr has the given dims and, for a dataset of a compound type, such as a
+multi-component var in the aos layout, a trailing dimension for the members.
+
+\return The extarr, or null when the dataset's type is not one an extarr holds. The
+native type to read into it is returned in \c mtype_id, which the caller must close.
+*/
+static json_object *
+new_read_extarr(
+    hid_t ds_id,           /**< [in] The dataset */
+    int ndims,             /**< [in] Number of dims of the elements to read */
+    hsize_t const *dims,   /**< [in] Dims of the elements to read */
+    hid_t *mtype_id        /**< [out] The native type of the dataset */
+)
+{
+    hid_t ftype_id = H5Dget_type(ds_id);
+    hid_t ntype_id = H5Tget_native_type(ftype_id, H5T_DIR_ASCEND);
+    int is_compound = H5Tget_class(ntype_id) == H5T_COMPOUND;
+    hid_t base_id = is_compound ? H5Tget_member_type(ntype_id, 0) : H5Tcopy(ntype_id);
+    size_t size = H5Tget_size(base_id);
+    enum json_extarr_type etype = json_extarr_type_null;
+    int i, xdims[H5S_MAX_RANK+1];
+
+    if (H5Tget_class(base_id) == H5T_FLOAT)
+        etype = size == 4 ? json_extarr_type_flt32 : size == 8 ? json_extarr_type_flt64 :
+            json_extarr_type_null;
+    else if (H5Tget_class(base_id) == H5T_INTEGER)
+        etype = size == 1 ? json_extarr_type_byt08 : size == 4 ? json_extarr_type_int32 :
+            size == 8 ? json_extarr_type_int64 : json_extarr_type_null;
+
+    for (i = 0; i < ndims; i++)
+        xdims[i] = (int) dims[i];
+    if (is_compound)
+    {
+        xdims[ndims++] = H5Tget_nmembers(ntype_id);
+        if (H5Tget_size(ntype_id) != xdims[ndims-1] * size)
+            etype = json_extarr_type_null;
+    }
+    H5Tclose(base_id);
+    H5Tclose(ftype_id);
+
+    if (etype == json_extarr_type_null)
+    {
+        H5Tclose(ntype_id);
+        return 0;
+    }
+    *mtype_id = ntype_id;
+    return json_object_new_extarr_alloc(etype, ndims, xdims, 0);
+}
+
+/*!
+\brief Read a block of a dataset
+
+The block is this rank's share of the dataset split along dimension \c split into as
+equal shares over \c size ranks as can be, or the whole dataset when \c split is
+negative. With a collective \c dxpl_id, all ranks must call this together.
+
+\return The block as an extarr or null when the dataset's type is not one an extarr holds
+*/
+static json_object *
+read_block(hid_t ds_id, int split, int rank, int size, hid_t dxpl_id)
+{
+    hid_t fspace_id = H5Dget_space(ds_id);
+    hid_t mspace_id, mtype_id;
+    int d, ndims = H5Sget_simple_extent_ndims(fspace_id);
+    hsize_t start[H5S_MAX_RANK], count[H5S_MAX_RANK], nvals = 1;
+    json_object *xa;
+
+    H5Sget_simple_extent_dims(fspace_id, count, 0);
+    for (d = 0; d < ndims; d++)
+        start[d] = 0;
+    if (split >= 0 && split < ndims)
+    {
+        hsize_t n = count[split];
+        start[split] = n * rank / size;
+        count[split] = n * (rank + 1) / size - start[split];
+    }
+    for (d = 0; d < ndims; d++)
+        nvals *= count[d];
+
+    mspace_id = H5Screate_simple(ndims, count, 0);
+    if (nvals)
+        H5Sselect_hyperslab(fspace_id, H5S_SELECT_SET, start, 0, count, 0);
+    else
+    {
+        H5Sselect_none(fspace_id);
+        H5Sselect_none(mspace_id);
+    }
+
+    xa = new_read_extarr(ds_id, ndims, count, &mtype_id);
+    if (xa)
+    {
+        H5Dread(ds_id, mtype_id, mspace_id, fspace_id, dxpl_id, (void *) json_object_extarr_data(xa));
+        H5Tclose(mtype_id);
+    }
+    H5Sclose(mspace_id);
+    H5Sclose(fspace_id);
+    return xa;
 }
 
-typedef struct _user_data {
-    hid_t groupId;
-} user_data_t;
+static int
+dataset_rank(hid_t loc_id, char const *name)
+{
+    hid_t ds_id = H5Dopen2(loc_id, name, H5P_DEFAULT);
+    hid_t space_id = H5Dget_space(ds_id);
+    int n = H5Sget_simple_extent_ndims(space_id);
 
-static void *CreateHDF5File(const char *fname, const char *nsname, void *userData)
+    H5Sclose(space_id);
+    H5Dclose(ds_id);
+    return n;
+}
+
+/* Add the bytes and seconds of a read to those stats holds for what was read */
+static void
+add_read_stats(json_object *stats, char const *name, int64_t nbytes, double secs)
 {
-    hid_t *retval = 0;
-    hid_t h5File = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-    if (h5File >= 0)
+    json_object *entry;
+
+    if (!json_object_object_get_ex(stats, name, &entry))
     {
-#warning USE NEWER GROUP CREATION SETTINGS OF HDF5
-        if (nsname && userData)
-        {
-            user_data_t *ud = (user_data_t *) userData;
-            ud->groupId = H5Gcreate1(h5File, nsname, 0);
-        }
-        retval = (hid_t *) malloc(sizeof(hid_t));
-        *retval = h5File;
+        entry = json_object_new_array();
+        json_object_array_add(entry, json_object_new_int64(0));
+        json_object_array_add(entry, json_object_new_double(0));
+        json_object_object_add(stats, name, entry);
     }
-    return (void *) retval;
+    json_object_set_int64(json_object_array_get_idx(entry, 0),
+        json_object_get_int64(json_object_array_get_idx(entry, 0)) + nbytes);
+    json_object_set_double(json_object_array_get_idx(entry, 1),
+        json_object_get_double(json_object_array_get_idx(entry, 1)) + secs);
 }
 
-static void *OpenHDF5File(const char *fname, const char *nsname,
-                   MACSIO_MIF_ioFlags_t ioFlags, void *userData)
+static void
+log_read_stats(json_object *stats)
 {
-    hid_t *retval;
-    hid_t h5File = H5Fopen(fname, ioFlags.do_wr ? H5F_ACC_RDWR : H5F_ACC_RDONLY, H5P_DEFAULT);
-    if (h5File >= 0)
+    json_object_object_foreach(stats, name, entry)
     {
-        if (ioFlags.do_wr && nsname && userData)
-        {
-            user_data_t *ud = (user_data_t *) userData;
-            ud->groupId = H5Gcreate1(h5File, nsname, 0);
-        }
-        retval = (hid_t *) malloc(sizeof(hid_t));
-        *retval = h5File;
+        double nbytes = (double) json_object_get_int64(json_object_array_get_idx(entry, 0));
+        double secs = json_object_get_double(json_object_array_get_idx(entry, 1));
+        char nbytes_str[32], seconds_str[32], bandwidth_str[32];
+
+        MACSIO_LOG_MSG(Info, ("Read \"%s\": %s in %s, BW = %s", name,
+            MU_PrByts(nbytes, 0, nbytes_str, sizeof(nbytes_str)),
+            MU_PrSecs(secs, 0, seconds_str, sizeof(seconds_str)),
+            MU_PrBW(nbytes, secs, 0, bandwidth_str, sizeof(bandwidth_str))));
     }
-    return (void *) retval;
 }
 
-static void CloseHDF5File(void *file, void *userData)
+/*!
+\brief Read a var, and the zone indices of a subset var, into a var object
+
+The var object holds the var's \c name, its values in \c data and, for a subset var,
+its zone indices in \c subset, read as \c read_block() does.
+
+\return The var object or null when the var's type is not one an extarr holds
+*/
+static json_object *
+read_var(hid_t loc_id, char const *name, int split, int rank, int size, hid_t dxpl_id,
+    json_object *stats)
 {
-    if (userData)
+    char subset_name[256];
+    double t0 = MT_Time();
+    hid_t ds_id = H5Dopen2(loc_id, name, H5P_DEFAULT);
+    json_object *xa = read_block(ds_id, split, rank, size, dxpl_id);
+    json_object *var_obj;
+    int64_t nbytes;
+
+    H5Dclose(ds_id);
+    if (!xa)
     {
-        user_data_t *ud = (user_data_t *) userData;
-        H5Gclose(ud->groupId);
+        MACSIO_LOG_MSG(Warn, ("Not reading \"%s\", of a type MACSio does not hold", name));
+        return 0;
     }
-    H5Fclose(*((hid_t*) file));
-    free(file);
+    nbytes = json_object_extarr_nbytes(xa);
+    var_obj = json_object_new_object();
+    json_object_object_add(var_obj, "name", json_object_new_string(name));
+    json_object_object_add(var_obj, "data", xa);
+
+    snprintf(subset_name, sizeof(subset_name), "%s_subset", name);
+    if (H5Lexists(loc_id, subset_name, H5P_DEFAULT) > 0)
+    {
+        ds_id = H5Dopen2(loc_id, subset_name, H5P_DEFAULT);
+        xa = read_block(ds_id, split, rank, size, dxpl_id);
+        H5Dclose(ds_id);
+        nbytes += json_object_extarr_nbytes(xa);
+        json_object_object_add(var_obj, "subset", xa);
+    }
+
+    add_read_stats(stats, name, nbytes, MT_Time() - t0);
+    return var_obj;
 }
 
-static void write_mesh_part(hid_t h5loc, json_object *part_obj)
+/*!
+\brief Read the datasets of a mesh group into a part's mesh object
+
+In a SIF file, each dataset is split over the ranks along its slowest varying
+dimension but for the axis coordinates of a rectilinear mesh, which every rank reads
+whole.
+
+\return Zero when there is no such mesh
+*/
+static int
+read_mesh_group(
+    hid_t loc_id,          /**< [in] Where the mesh group lives */
+    char const *mesh_name, /**< [in] The mesh group's name */
+    json_object *mesh_obj, /**< [in,out] The part's mesh object */
+    int ndims,             /**< [in] Number of spatial dimensions, 0 if the mesh is a part's */
+    int rank,              /**< [in] This rank */
+    int size,              /**< [in] Number of ranks reading the mesh */
+    hid_t dxpl_id,         /**< [in] Dataset transfer properties */
+    json_object *stats     /**< [in,out] Read stats */
+)
 {
-#warning WERE SKPPING THE MESH (COORDS) OBJECT PRESENTLY
+    double t0 = MT_Time();
+    int64_t nbytes = 0;
+    json_object *names;
+    hid_t grp_id;
     int i;
-    json_object *vars_array = json_object_path_get_array(part_obj, "Vars");
 
-    for (i = 0; i < json_object_array_length(vars_array); i++)
-    {
-        int j;
-        hsize_t var_dims[3];
-        hid_t fspace_id, ds_id, dcpl_id;
-        json_object *var_obj = json_object_array_get_idx(vars_array, i);
-        json_object *data_obj = json_object_path_get_extarr(var_obj, "data");
-        char const *varname = json_object_path_get_string(var_obj, "name");
-        int ndims = json_object_extarr_ndims(data_obj);
-        void const *buf = json_object_extarr_data(data_obj);
-        hid_t dtype_id = json_object_extarr_type(data_obj)==json_extarr_type_flt64? 
-                H5T_NATIVE_DOUBLE:H5T_NATIVE_INT;
+    if (H5Lexists(loc_id, mesh_name, H5P_DEFAULT) <= 0)
+        return 0;
 
-        for (j = 0; j < ndims; j++)
-            var_dims[j] = json_object_extarr_dim(data_obj, j);
+    grp_id = H5Gopen2(loc_id, mesh_name, H5P_DEFAULT);
+    names = list_names(grp_id, H5I_DATASET);
+    for (i = 0; i < json_object_array_length(names); i++)
+    {
+        char const *name = json_object_get_string(json_object_array_get_idx(names, i));
+        int split = ndims > 1 && dataset_rank(grp_id, name) == 1 ? -1 : 0;
+        hid_t ds_id = H5Dopen2(grp_id, name, H5P_DEFAULT);
+        json_object *xa = read_block(ds_id, split, rank, size, dxpl_id);
 
-        fspace_id = H5Screate_simple(ndims, var_dims, 0);
-        dcpl_id = make_dcpl(compression_alg_str, compression_params_str, fspace_id, dtype_id);
-        ds_id = H5Dcreate1(h5loc, varname, dtype_id, fspace_id, dcpl_id); 
-        H5Dwrite(ds_id, dtype_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf);
         H5Dclose(ds_id);
-        H5Pclose(dcpl_id);
-        H5Sclose(fspace_id);
+        if (!xa) continue;
+        nbytes += json_object_extarr_nbytes(xa);
+        json_object_object_add(mesh_obj, name, xa);
     }
+    json_object_put(names);
+    H5Gclose(grp_id);
+
+    add_read_stats(stats, mesh_name, nbytes, MT_Time() - t0);
+    return 1;
 }
 
-static void main_dump_mif(json_object *main_obj, int numFiles, int dumpn, double dumpt)
+/* Name of file n of a load. A path without a conversion is a single file. */
+static void
+load_file_name(char const *path, int n, char *fname, size_t len)
 {
-    int size, rank;
-    hid_t *h5File_ptr;
-    hid_t h5File;
-    hid_t h5Group;
-    char fileName[256];
-    int i, len;
-    int *theData;
-    user_data_t userData;
-    MACSIO_MIF_ioFlags_t ioFlags = {MACSIO_MIF_WRITE,
-        JsonGetInt(main_obj, "clargs/exercise_scr")&0x1};
+    if (strchr(path, '%'))
+        snprintf(fname, len, path, n);
+    else
+        snprintf(fname, len, "%s", path);
+}
 
-#warning MAKE WHOLE FILE USE HDF5 1.8 INTERFACE
-#warning SET FILE AND DATASET PROPERTIES
-#warning DIFFERENT MPI TAGS FOR DIFFERENT PLUGINS AND CONTEXTS
-    MACSIO_MIF_baton_t *bat = MACSIO_MIF_Init(numFiles, ioFlags, MACSIO_MAIN_Comm, 3,
-        CreateHDF5File, OpenHDF5File, CloseHDF5File, &userData);
+/* Read index rows a through b-1 of a packed dataset. The caller must free them. */
+static long long *
+read_packed_index(hid_t fid, char const *index_name, int a, int b)
+{
+    hsize_t start[2] = {(hsize_t) a, 0}, count[2] = {(hsize_t) (b - a), PACKED_INDEX_NCOLS};
+    long long *rows = (long long *) malloc((b > a ? b - a : 1) * PACKED_INDEX_NCOLS * sizeof(long long));
+    hid_t ds_id = H5Dopen2(fid, index_name, H5P_DEFAULT);
+    hid_t fspace_id = H5Dget_space(ds_id);
+    hid_t mspace_id = H5Screate_simple(2, count, 0);
+
+    H5Sselect_hyperslab(fspace_id, H5S_SELECT_SET, start, 0, count, 0);
+    H5Dread(ds_id, H5T_NATIVE_LLONG, mspace_id, fspace_id, H5P_DEFAULT, rows);
+    H5Sclose(mspace_id);
+    H5Sclose(fspace_id);
+    H5Dclose(ds_id);
+    return rows;
+}
 
-    rank = json_object_path_get_int(main_obj, "parallel/mpi_rank");
-    size = json_object_path_get_int(main_obj, "parallel/mpi_size");
+/* Read the slabs of parts a through b-1 of a packed dataset into xas, with the dims
+   their parts' datasets have in the unpacked layout */
+static void
+read_packed(hid_t fid, char const *name, int a, int b, json_object **xas)
+{
+    char index_name[256];
+    long long *rows;
+    hid_t ds_id = H5Dopen2(fid, name, H5P_DEFAULT);
+    int k;
+
+    snprintf(index_name, sizeof(index_name), "%s_index", name);
+    rows = read_packed_index(fid, index_name, a, b);
+    for (k = a; k < b; k++)
+    {
+        long long const *row = rows + (k-a)*PACKED_INDEX_NCOLS;
+        hsize_t start = (hsize_t) row[1], count, dims[4];
+        hid_t fspace_id = H5Dget_space(ds_id), mspace_id, mtype_id;
+        int ndims;
+
+        dims[0] = count = (hsize_t) row[2];
+        for (ndims = 1; ndims < 4 && row[2+ndims]; ndims++)
+            count *= dims[ndims] = (hsize_t) row[2+ndims];
+
+        mspace_id = H5Screate_simple(1, &count, 0);
+        if (count)
+            H5Sselect_hyperslab(fspace_id, H5S_SELECT_SET, &start, 0, &count, 0);
+        else
+            H5Sselect_none(fspace_id);
+        xas[k-a] = new_read_extarr(ds_id, ndims, dims, &mtype_id);
+        if (xas[k-a])
+        {
+            H5Dread(ds_id, mtype_id, mspace_id, fspace_id, H5P_DEFAULT,
+                (void *) json_object_extarr_data(xas[k-a]));
+            H5Tclose(mtype_id);
+        }
+        H5Sclose(mspace_id);
+        H5Sclose(fspace_id);
+    }
+    free(rows);
+    H5Dclose(ds_id);
+}
 
-    /* Construct name for the silo file */
-    sprintf(fileName, "%s_hdf5_%05d_%03d.%s",
-        json_object_path_get_string(main_obj, "clargs/filebase"),
-        MACSIO_MIF_RankOfGroup(bat, rank),
-        dumpn,
-        json_object_path_get_string(main_obj, "clargs/fileext"));
+static json_object *
+new_read_part(int chunk_id)
+{
+    json_object *part_obj = json_object_new_object();
+    json_object *mesh_obj = json_object_new_object();
 
-    h5File_ptr = (hid_t *) MACSIO_MIF_WaitForBaton(bat, fileName, 0);
-    h5File = *h5File_ptr;
-    h5Group = userData.groupId;
+    json_object_object_add(mesh_obj, "ChunkID", json_object_new_int(chunk_id));
+    json_object_object_add(part_obj, "Mesh", mesh_obj);
+    json_object_object_add(part_obj, "Vars", json_object_new_array());
+    return part_obj;
+}
 
-    json_object *parts = json_object_path_get_array(main_obj, "problem/parts");
+/* The domain groups of a MIF file, in name and so chunk id order. The caller owns the array. */
+static json_object *
+list_domains(hid_t fid)
+{
+    json_object *groups = list_names(fid, H5I_GROUP);
+    json_object *domains = json_object_new_array();
+    int i;
 
-    for (int i = 0; i < json_object_array_length(parts); i++)
+    for (i = 0; i < json_object_array_length(groups); i++)
     {
-        char domain_dir[256];
-        json_object *this_part = json_object_array_get_idx(parts, i);
-        hid_t domain_group_id;
+        char const *name = json_object_get_string(json_object_array_get_idx(groups, i));
+        if (!strncmp(name, "domain_", 7))
+            json_object_array_add(domains, json_object_new_string(name));
+    }
+    json_object_put(groups);
+    return domains;
+}
 
-        snprintf(domain_dir, sizeof(domain_dir), "domain_%07d",
-            json_object_path_get_int(this_part, "Mesh/ChunkID"));
- 
-        domain_group_id = H5Gcreate1(h5File, domain_dir, 0);
+/* The name of the first _index dataset of a packed MIF file, or 0 if there is none */
+static int
+first_packed_index(hid_t fid, char *index_name, size_t len)
+{
+    json_object *names = list_names(fid, H5I_DATASET);
+    int i, found = 0;
 
-        write_mesh_part(domain_group_id, this_part);
+    for (i = 0; i < json_object_array_length(names) && !found; i++)
+    {
+        char const *name = json_object_get_string(json_object_array_get_idx(names, i));
+        size_t n = strlen(name);
+        if (n > 6 && !strcmp(name + n - 6, "_index"))
+        {
+            snprintf(index_name, len, "%s", name);
+            found = 1;
+        }
+    }
+    json_object_put(names);
+    return found;
+}
 
-        H5Gclose(domain_group_id);
+/* Number of parts in a MIF file, as domain groups or packed index rows */
+static int
+count_mif_parts(hid_t fid, char const *fname)
+{
+    json_object *domains = list_domains(fid);
+    int nparts = json_object_array_length(domains);
+    char index_name[256];
+
+    json_object_put(domains);
+    if (!nparts && first_packed_index(fid, index_name, sizeof(index_name)))
+    {
+        hid_t ds_id = H5Dopen2(fid, index_name, H5P_DEFAULT);
+        hid_t space_id = H5Dget_space(ds_id);
+        hsize_t dims[2];
+
+        H5Sget_simple_extent_dims(space_id, dims, 0);
+        nparts = (int) dims[0];
+        H5Sclose(space_id);
+        H5Dclose(ds_id);
     }
+    else if (!nparts && H5Lexists(fid, "image_00000", H5P_DEFAULT) > 0)
+        MACSIO_LOG_MSG(Warn, ("\"%s\" holds file images stored with --mif_images store, "
+            "which are not read", fname));
+    return nparts;
+}
 
-    /* If this is the 'root' processor, also write Silo's multi-XXX objects */
-#if 0
-    if (rank == 0)
-        WriteMultiXXXObjects(main_obj, siloFile, bat);
-#endif
+/*!
+\brief Find the files of a load and count the parts in each
 
-    /* Hand off the baton to the next processor. This winds up closing
-     * the file so that the next processor that opens it can be assured
-     * of getting a consistent and up to date view of the file's contents. */
-    MACSIO_MIF_HandOffBaton(bat, h5File_ptr);
+\return The number of files found, with whether they are a SIF file in \c is_sif and
+the parts of each MIF file in \c nparts, which the caller must free
+*/
+static int
+scan_load_files(char const *path, int *is_sif, int **nparts)
+{
+    int n;
 
-    /* We're done using MACSIO_MIF, so finish it off */
-    MACSIO_MIF_Finish(bat);
+    *is_sif = 0;
+    *nparts = 0;
+    for (n = 0; n == 0 || strchr(path, '%'); n++)
+    {
+        char fname[1024];
+        hid_t fapl_id = make_fapl();
+        hid_t fid;
+
+        load_file_name(path, n, fname, sizeof(fname));
+        fid = H5Fopen(fname, H5F_ACC_RDONLY, fapl_id);
+        H5Pclose(fapl_id);
+        if (fid < 0)
+        {
+            if (n == 0)
+                MACSIO_LOG_MSG(Err, ("Unable to open \"%s\"", fname));
+            break;
+        }
 
+        *nparts = (int *) realloc(*nparts, (n + 1) * sizeof(int));
+        if (H5Lexists(fid, "mesh", H5P_DEFAULT) > 0)
+        {
+            *is_sif = 1;
+            (*nparts)[n++] = 0;
+            H5Fclose(fid);
+            break;
+        }
+        (*nparts)[n] = count_mif_parts(fid, fname);
+        H5Fclose(fid);
+    }
+    return n;
 }
 
-static void main_dump(int argi, int argc, char **argv, json_object *main_obj,
-    int dumpn, double dumpt)
+/*!
+\brief Read this rank's share of the global datasets of a SIF file
+
+Each var is split over the ranks along its slowest varying spatial dimension, after
+the leading component dimension of a multi-component var in the soa layout, and read
+with a collective hyperslab read unless \c --no_collective is given. A subset var
+has no spatial dimensions and is split along its only one. The rank's blocks are
+returned as a single part whose \c ChunkID is the rank.
+*/
+static void
+load_sif(char const *fname, int rank, int size, char const *read_vars, char const *read_mesh,
+    json_object *parts, json_object *stats)
 {
-    int rank, size, numFiles;
+    hid_t fapl_id = make_fapl();
+    hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+    hid_t fid, attr_id, space_id;
+    json_object *part_obj, *vars, *vars_array;
+    int i, ndims;
 
-#warning SET ERROR MODE OF HDF5 LIBRARY
+#if H5_HAVE_PARALLEL
+    H5Pset_fapl_mpio(fapl_id, MACSIO_MAIN_Comm, MACSIO_MAIN_MPIInfo);
+    if (no_collective)
+        H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_INDEPENDENT);
+    else
+        H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+#endif
 
-    /* Without this barrier, I get strange behavior with Silo's MACSIO_MIF interface */
-    mpi_errno = MPI_Barrier(MACSIO_MAIN_Comm);
+    fid = H5Fopen(fname, H5F_ACC_RDONLY, fapl_id);
+    H5Pclose(fapl_id);
 
-    /* process cl args */
-    process_args(argi, argc, argv);
+    /* the global mesh's LogDims has an entry per spatial dimension */
+    attr_id = H5Aopen_by_name(fid, "mesh", "LogDims", H5P_DEFAULT, H5P_DEFAULT);
+    space_id = H5Aget_space(attr_id);
+    ndims = (int) H5Sget_simple_extent_npoints(space_id);
+    H5Sclose(space_id);
+    H5Aclose(attr_id);
+
+    part_obj = new_read_part(rank);
+    if (read_mesh[0] && !read_mesh_group(fid, read_mesh,
+            json_object_path_get_object(part_obj, "Mesh"), ndims, rank, size, dxpl_id, stats))
+        MACSIO_LOG_MSG(Warn, ("No mesh \"%s\" in \"%s\"", read_mesh, fname));
+
+    vars_array = json_object_path_get_array(part_obj, "Vars");
+    vars = list_read_vars(fid, read_vars);
+    for (i = 0; i < json_object_array_length(vars); i++)
+    {
+        char const *name = json_object_get_string(json_object_array_get_idx(vars, i));
+        int split = MU_MAX(dataset_rank(fid, name) - ndims, 0);
+        json_object *var_obj = read_var(fid, name, split, rank, size, dxpl_id, stats);
 
-    rank = json_object_path_get_int(main_obj, "parallel/mpi_rank");
-    size = json_object_path_get_int(main_obj, "parallel/mpi_size");
+        if (var_obj)
+            json_object_array_add(vars_array, var_obj);
+    }
+    json_object_put(vars);
+    json_object_array_add(parts, part_obj);
 
-#warning MOVE TO A FUNCTION
-    /* ensure we're in MIF mode and determine the file count */
-    json_object *parfmode_obj = json_object_path_get_array(main_obj, "clargs/parallel_file_mode");
-    if (parfmode_obj)
+    H5Pclose(dxpl_id);
+    H5Fclose(fid);
+}
+
+/* Read parts a through b-1 of a MIF file with a domain group per part */
+static void
+load_mif_domains(hid_t fid, json_object *domains, int a, int b, char const *read_vars,
+    char const *read_mesh, json_object *parts, json_object *stats, int *nmeshes)
+{
+    int i, k;
+
+    for (k = a; k < b; k++)
     {
-        json_object *modestr = json_object_array_get_idx(parfmode_obj, 0);
-        json_object *filecnt = json_object_array_get_idx(parfmode_obj, 1);
-#warning ERRORS NEED TO GO TO LOG FILES AND ERROR BEHAVIOR NEEDS TO BE HONORED
-        if (!strcmp(json_object_get_string(modestr), "SIF"))
-        {
-            main_dump_sif(main_obj, dumpn, dumpt);
-        }
-        else
+        char const *domain = json_object_get_string(json_object_array_get_idx(domains, k));
+        hid_t grp_id = H5Gopen2(fid, domain, H5P_DEFAULT);
+        json_object *part_obj = new_read_part(atoi(domain + 7));
+        json_object *vars_array = json_object_path_get_array(part_obj, "Vars");
+        json_object *vars = list_read_vars(grp_id, read_vars);
+
+        if (read_mesh[0])
+            *nmeshes += read_mesh_group(grp_id, read_mesh, json_object_path_get_object(part_obj, "Mesh"),
+                0, 0, 1, H5P_DEFAULT, stats);
+        for (i = 0; i < json_object_array_length(vars); i++)
         {
-            numFiles = json_object_get_int(filecnt);
-            main_dump_mif(main_obj, numFiles, dumpn, dumpt);
+            json_object *var_obj = read_var(grp_id,
+                json_object_get_string(json_object_array_get_idx(vars, i)), -1, 0, 1, H5P_DEFAULT, stats);
+            if (var_obj)
+                json_object_array_add(vars_array, var_obj);
         }
+        json_object_put(vars);
+        json_object_array_add(parts, part_obj);
+        H5Gclose(grp_id);
     }
-    else
+}
+
+/* Read parts a through b-1 of a packed MIF file, a packed dataset at a time */
+static void
+load_mif_packed(hid_t fid, int a, int b, char const *read_vars, json_object *parts,
+    json_object *stats)
+{
+    json_object **xas = (json_object **) malloc(2 * (b - a) * sizeof(json_object *));
+    json_object **subsets = xas + (b - a);
+    json_object *vars = list_read_vars(fid, read_vars);
+    int i, k, first = json_object_array_length(parts);
+    char index_name[256];
+    long long *rows;
+
+    first_packed_index(fid, index_name, sizeof(index_name));
+    rows = read_packed_index(fid, index_name, a, b);
+    for (k = a; k < b; k++)
+        json_object_array_add(parts, new_read_part((int) rows[(k-a)*PACKED_INDEX_NCOLS]));
+    free(rows);
+
+    for (i = 0; i < json_object_array_length(vars); i++)
     {
-        char const * modestr = json_object_path_get_string(main_obj, "clargs/parallel_file_mode");
-        if (!strcmp(modestr, "SIF"))
+        char const *name = json_object_get_string(json_object_array_get_idx(vars, i));
+        char subset_name[256];
+        int has_subset;
+        double t0 = MT_Time();
+        int64_t nbytes = 0;
+
+        snprintf(subset_name, sizeof(subset_name), "%s_subset", name);
+        has_subset = H5Lexists(fid, subset_name, H5P_DEFAULT) > 0;
+        read_packed(fid, name, a, b, xas);
+        if (has_subset)
+            read_packed(fid, subset_name, a, b, subsets);
+
+        for (k = 0; k < b - a; k++)
         {
-            float avg_num_parts = json_object_path_get_double(main_obj, "clargs/avg_num_parts");
-            if (avg_num_parts == (float ((int) avg_num_parts)))
-                main_dump_sif(main_obj, dumpn, dumpt);
-            else
+            json_object *var_obj;
+
+            if (!xas[k])
+            {
+                if (has_subset) json_object_put(subsets[k]);
+                continue;
+            }
+            var_obj = json_object_new_object();
+            json_object_object_add(var_obj, "name", json_object_new_string(name));
+            json_object_object_add(var_obj, "data", xas[k]);
+            nbytes += json_object_extarr_nbytes(xas[k]);
+            if (has_subset)
             {
-#warning CURRENTLY, SIF CAN WORK ONLY ON WHOLE PART COUNTS
-                MACSIO_LOG_MSG(Die, ("HDF5 plugin cannot currently handle SIF mode where "
-                    "there are different numbers of parts on each MPI rank. "
-                    "Set --avg_num_parts to an integral value." ));
+                json_object_object_add(var_obj, "subset", subsets[k]);
+                nbytes += json_object_extarr_nbytes(subsets[k]);
             }
+            json_object_array_add(json_object_path_get_array(
+                json_object_array_get_idx(parts, first + k), "Vars"), var_obj);
         }
-        else if (!strcmp(modestr, "MIFMAX"))
-            numFiles = json_object_path_get_int(main_obj, "parallel/mpi_size");
-        else if (!strcmp(modestr, "MIFAUTO"))
+        add_read_stats(stats, name, nbytes, MT_Time() - t0);
+    }
+
+    json_object_put(vars);
+    free(xas);
+}
+
+/*!
+\brief Read this rank's share of the parts of MIF files
+
+The parts of all the files, in file then chunk id order, are split into contiguous
+blocks over the reading ranks, which need not be as many as wrote them. A rank opens
+only the files holding its parts.
+*/
+static void
+load_mif(char const *path, int nfiles, int const *nparts, int rank, int size,
+    char const *read_vars, char const *read_mesh, json_object *parts, json_object *stats)
+{
+    long long total = 0;
+    int f, base, lo, hi, nmeshes = 0;
+
+    for (f = 0; f < nfiles; f++)
+        total += nparts[f];
+    lo = (int) (total * rank / size);
+    hi = (int) (total * (rank + 1) / size);
+
+    for (f = 0, base = 0; f < nfiles; base += nparts[f++])
+    {
+        int a = MU_MAX(lo, base) - base;
+        int b = (hi < base + nparts[f] ? hi : base + nparts[f]) - base;
+        char fname[1024];
+        json_object *domains;
+        hid_t fapl_id, fid;
+
+        if (a >= b)
+            continue;
+
+        load_file_name(path, f, fname, sizeof(fname));
+        fapl_id = make_fapl();
+        fid = H5Fopen(fname, H5F_ACC_RDONLY, fapl_id);
+        H5Pclose(fapl_id);
+        if (fid < 0)
         {
-            /* Call utility to determine optimal file count */
-#warning ADD UTILIT TO DETERMINE OPTIMAL FILE COUNT
+            MACSIO_LOG_MSG(Err, ("Unable to open \"%s\"", fname));
+            continue;
         }
-        main_dump_mif(main_obj, numFiles, dumpn, dumpt);
+
+        domains = list_domains(fid);
+        if (json_object_array_length(domains))
+            load_mif_domains(fid, domains, a, b, read_vars, read_mesh, parts, stats, &nmeshes);
+        else
+            load_mif_packed(fid, a, b, read_vars, parts, stats);
+        json_object_put(domains);
+        H5Fclose(fid);
+    }
+
+    if (read_mesh[0] && json_object_array_length(parts) && !nmeshes)
+        MACSIO_LOG_MSG(Warn, ("No mesh \"%s\" in the parts of MIF files", read_mesh));
+}
+
+/*!
+\brief Main load implementation for this plugin
+
+Reads back a dump written by \c main_dump(), in any of its file modes and layouts but
+for file images stored with \c --mif_images \c store, on any number of ranks. The
+vars \c --read_vars names are read and, when \c --read_mesh names one, the datasets
+of the mesh group of that name. The bytes read, time and bandwidth of each var are
+logged.
+
+\c path is a SIF file, a MIF file or, to read all the files of a MIF dump, a printf
+format with a conversion for the file number, e.g. \c macsio_hdf5_%05d_000.h5,
+in which case the files numbered from 0 until the first that does not exist are read.
+
+\return In \c data_read_obj, an array of the parts read by this rank, each with a
+\c Mesh object holding its \c ChunkID and any mesh datasets read and a \c Vars array
+of var objects. The caller owns it.
+*/
+static void main_load(
+    int argi,                    /**< [in] Command-line argument index at which first plugin-specific arg appears */
+    int argc,                    /**< [in] argc from main */
+    char **argv,                 /**< [in] argv from main */
+    char const *path,            /**< [in] The file, or printf format of the files, to read */
+    json_object *main_obj,       /**< [in] The main json object */
+    json_object **data_read_obj  /**< [out] The parts read by this rank */
+)
+{
+    int rank = json_object_path_get_int(main_obj, "parallel/mpi_rank");
+    int size = json_object_path_get_int(main_obj, "parallel/mpi_size");
+    char *read_vars = strdup(json_object_path_get_string(main_obj, "clargs/read_vars"));
+    char *read_mesh = strdup(json_object_path_get_string(main_obj, "clargs/read_mesh"));
+    json_object *stats = json_object_new_object();
+    int *nparts = 0, nfiles = 0, is_sif = 0;
+
+    *data_read_obj = json_object_new_array();
+
+    /* absent, these are empty */
+    if (!strcmp(read_vars, "null"))
+        read_vars[0] = '\0';
+    if (!strcmp(read_mesh, "null"))
+        read_mesh[0] = '\0';
+
+    /* process cl args */
+    process_args(argi, argc, argv);
+
+    /* rank 0 finds the files and counts their parts for everyone */
+    if (rank == 0)
+        nfiles = scan_load_files(path, &is_sif, &nparts);
+#ifdef HAVE_MPI
+    {
+        int bcast_data[2] = {nfiles, is_sif};
+        MPI_Bcast(bcast_data, 2, MPI_INT, 0, MACSIO_MAIN_Comm);
+        nfiles = bcast_data[0];
+        is_sif = bcast_data[1];
+        if (rank != 0)
+            nparts = (int *) malloc((nfiles ? nfiles : 1) * sizeof(int));
+        if (nfiles)
+            MPI_Bcast(nparts, nfiles, MPI_INT, 0, MACSIO_MAIN_Comm);
+    }
+#endif
+
+    if (is_sif)
+    {
+        char fname[1024];
+        load_file_name(path, 0, fname, sizeof(fname));
+        load_sif(fname, rank, size, read_vars, read_mesh, *data_read_obj, stats);
     }
+    else if (nfiles)
+        load_mif(path, nfiles, nparts, rank, size, read_vars, read_mesh, *data_read_obj, stats);
+
+    log_read_stats(stats);
+    json_object_put(stats);
+    free(read_mesh);
+    free(read_vars);
+    free(nparts);
 }
 
 static int register_this_interface()
@@ -1411,6 +4473,20 @@ static int register_this_interface()
     strcpy(iface.ext, iface_ext);
     iface.dumpFunc = main_dump;
     iface.processArgsFunc = process_args;
+    iface.loadFunc = main_load;
+
+    vars_path = json_path_compile("Vars");
+    mesh_log_dims_path = json_path_compile("Mesh/LogDims");
+    global_log_origin_path = json_path_compile("GlobalLogOrigin");
+    global_log_indices_path = json_path_compile("GlobalLogIndices");
+    chunk_id_path = json_path_compile("Mesh/ChunkID");
+    data_path = json_path_compile("data");
+    name_path = json_path_compile("name");
+    centering_path = json_path_compile("centering");
+    type_path = json_path_compile("type");
+    layout_path = json_path_compile("layout");
+    components_path = json_path_compile("components");
+    subset_path = json_path_compile("subset");
 
     /* Register custom compression methods with HDF5 library */
     H5dont_atexit();
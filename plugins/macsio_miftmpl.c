@@ -33,7 +33,14 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #include <macsio_mif.h>
 #include <macsio_utils.h>
 
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #ifdef HAVE_MPI
 #include <mpi.h>
@@ -161,6 +168,15 @@ not "know" such things as how many mesh parts there are or where a given
 mesh part is located in the file set. So, we wind up writing JSON objects for each
 part individually so that we can keep track of where they all are in the fileset.
 
+With the \c --binary option, each mesh part is instead written as a compact (single line)
+JSON header followed by the raw bytes of all of the part's extarrs. In the header, each
+extarr is replaced by a small descriptor object giving its element type, dimensions, the
+offset of its bytes relative to the end of the header, its size in bytes and its CRC.
+The raw bytes of all extarrs are written with a single \c writev(2) directly from the
+arrays' own buffers. This avoids the cost (in time and in file size) of formatting every
+array element as ascii text which is otherwise many times the cost of writing the data.
+The default, text mode remains useful for debugging.
+
 Some of the aspects of this plugin code exist here only to serve as an example in
 writing a MIF plugin and are non-essential to the proper operation of this plugin.
 
@@ -179,11 +195,13 @@ pointers.
 static char const *iface_name = "miftmpl"; /**< Name of the interface this plugin uses */
 static char const *iface_ext = "json";     /**< Default file extension for files generated by this plugin */
 static int json_as_html = 0;               /**< Use HTML output instead of raw ascii */
+static int binary_mode = 0;                /**< Write JSON header plus raw extarr bytes instead of ascii */
 static int my_opt_one;                     /**< Example of a static scope, plugin-specific variable to be set in
                                                 process_args to control plugin behavior */
 static int my_opt_two;                     /**< Another example variable to control plugin behavior */
 static char *my_opt_three_string;          /**< Another example variable to control plugin behavior */
 static float my_opt_three_float;           /**< Another example variable to control plugin behavior */
+static struct json_path *chunk_id_path;    /**< Compiled path of each part's chunk ID, queried once per part */
 
 /*!
 \brief Process command-line arguments specific to this plugin
@@ -210,6 +228,11 @@ static int process_args(
         "--json_as_html", "",
             "Write files as HTML instead of raw ascii [false]",
             &json_as_html,
+        "--binary", "",
+            "Write each mesh part as a compact JSON header with descriptors (type,\n"
+            "dims, offset, nbytes and crc) for its extarrs followed by the raw bytes\n"
+            "of the extarrs instead of as pretty-printed ascii JSON [false]",
+            &binary_mode,
         "--my_opt_one", "",
             "Help message for my_opt_one which has no arguments. If present, local\n"
             "var my_opt_one will be assigned a value of 1 and a value of zero otherwise.",
@@ -273,40 +296,296 @@ static void CloseMyFile(
     fclose((FILE*) file);
 }
 
+static char const *
+extarr_type_name(json_extarr_type etype)
+{
+    switch (etype)
+    {
+        case json_extarr_type_bit01: return "bit01";
+        case json_extarr_type_byt08: return "byt08";
+        case json_extarr_type_int32: return "int32";
+        case json_extarr_type_int64: return "int64";
+        case json_extarr_type_flt32: return "flt32";
+        case json_extarr_type_flt64: return "flt64";
+        default: break;
+    }
+    return "null";
+}
+
+/*!
+\brief Build the binary mode header for a JSON object
+
+Returns a copy of \c obj in which every extarr is replaced by a descriptor
+object. The extarrs' data buffers are appended to \c iov and \c offset is
+advanced by their sizes. Primitive members are shared with \c obj.
+*/
+static json_object *
+binary_header(
+    json_object *obj,    /**< [in] The object for which a header is needed */
+    struct iovec **iov,  /**< [in/out] Array of iovecs for extarr data, grown as needed */
+    int *niov,           /**< [in/out] Number of entries in use in iov */
+    int *maxiov,         /**< [in/out] Number of entries allocated in iov */
+    int64_t *offset      /**< [in/out] Offset of the next extarr's bytes */
+)
+{
+    switch (json_object_get_type(obj))
+    {
+        case json_type_object:
+        {
+            json_object *hdr = json_object_new_object();
+            json_object_object_foreach(obj, key, val)
+                json_object_object_add(hdr, key, binary_header(val, iov, niov, maxiov, offset));
+            return hdr;
+        }
+        case json_type_array:
+        {
+            int i;
+            json_object *hdr = json_object_new_array();
+            for (i = 0; i < json_object_array_length(obj); i++)
+                json_object_array_add(hdr, binary_header(json_object_array_get_idx(obj, i),
+                    iov, niov, maxiov, offset));
+            return hdr;
+        }
+        case json_type_extarr:
+        {
+            int i;
+            int64_t nbytes = json_object_extarr_nbytes(obj);
+            json_object *hdr = json_object_new_object();
+            json_object *dims = json_object_new_array();
+
+            for (i = 0; i < json_object_extarr_ndims(obj); i++)
+                json_object_array_add(dims, json_object_new_int(json_object_extarr_dim(obj, i)));
+            json_object_object_add(hdr, "extarr_type",
+                json_object_new_string(extarr_type_name(json_object_extarr_type(obj))));
+            json_object_object_add(hdr, "extarr_dims", dims);
+            json_object_object_add(hdr, "extarr_offset", json_object_new_int64(*offset));
+            json_object_object_add(hdr, "extarr_nbytes", json_object_new_int64(nbytes));
+            json_object_object_add(hdr, "extarr_crc", json_object_new_int64(json_object_extarr_crc(obj)));
+
+            if (*niov == *maxiov)
+            {
+                *maxiov = *maxiov ? 2 * *maxiov : 16;
+                *iov = (struct iovec *) realloc(*iov, *maxiov * sizeof(struct iovec));
+            }
+            (*iov)[*niov].iov_base = (void *) json_object_extarr_data(obj);
+            (*iov)[*niov].iov_len = (size_t) nbytes;
+            (*niov)++;
+            *offset += nbytes;
+            return hdr;
+        }
+        default:
+            break;
+    }
+
+    return json_object_get(obj);
+}
+
+static json_extarr_type
+extarr_type_from_name(char const *name)
+{
+    int t;
+    for (t = json_extarr_type_bit01; t <= json_extarr_type_flt64; t++)
+    {
+        if (name && !strcmp(name, extarr_type_name((json_extarr_type) t)))
+            return (json_extarr_type) t;
+    }
+    return json_extarr_type_null;
+}
+
+/* One past the last byte of extarr data described in a binary mode header */
+static int64_t
+binary_data_end(json_object *hdr)
+{
+    int64_t end = 0, e;
+    int i;
+
+    switch (json_object_get_type(hdr))
+    {
+        case json_type_object:
+        {
+            json_object *offset_obj, *nbytes_obj;
+            struct json_object_iter iter;
+            if (json_object_object_get_ex(hdr, "extarr_offset", &offset_obj) &&
+                json_object_object_get_ex(hdr, "extarr_nbytes", &nbytes_obj))
+                return json_object_get_int64(offset_obj) + json_object_get_int64(nbytes_obj);
+            json_object_object_foreachC(hdr, iter)
+                if ((e = binary_data_end(iter.val)) > end) end = e;
+            break;
+        }
+        case json_type_array:
+            for (i = 0; i < json_object_array_length(hdr); i++)
+                if ((e = binary_data_end(json_object_array_get_idx(hdr, i))) > end) end = e;
+            break;
+        default:
+            break;
+    }
+    return end;
+}
+
+/*!
+\brief Restore the extarrs of a binary mode header
+
+The inverse of \c binary_header(). Returns a copy of \c hdr in which every extarr
+descriptor is replaced by an extarr whose buffer is mapped directly from the file
+with json_object_new_extarr_mmap_fd() rather than read and copied. Primitive
+members are shared with \c hdr.
+*/
+static json_object *
+binary_restore(
+    json_object *hdr,    /**< [in] Binary mode header of a part */
+    int fd,              /**< [in] File descriptor of the file holding the part */
+    int64_t data_offset  /**< [in] Offset in the file of the byte following the header */
+)
+{
+    switch (json_object_get_type(hdr))
+    {
+        case json_type_object:
+        {
+            json_object *obj, *offset_obj, *dims_obj = 0, *type_obj = 0;
+            if (json_object_object_get_ex(hdr, "extarr_offset", &offset_obj))
+            {
+                int i, ndims, *dims;
+                int64_t offset = data_offset + json_object_get_int64(offset_obj);
+
+                json_object_object_get_ex(hdr, "extarr_dims", &dims_obj);
+                json_object_object_get_ex(hdr, "extarr_type", &type_obj);
+                ndims = dims_obj ? json_object_array_length(dims_obj) : 0;
+                dims = (int *) malloc((ndims ? ndims : 1) * sizeof(int));
+                for (i = 0; i < ndims; i++)
+                    dims[i] = json_object_get_int(json_object_array_get_idx(dims_obj, i));
+                obj = json_object_new_extarr_mmap_fd(fd, offset,
+                    extarr_type_from_name(json_object_get_string(type_obj)), ndims, dims, 0);
+                if (!obj)
+                    MACSIO_LOG_MSG(Err, ("Unable to map extarr data at offset %lld", (long long) offset));
+                free(dims);
+                return obj;
+            }
+            obj = json_object_new_object();
+            json_object_object_foreach(hdr, key, val)
+                json_object_object_add(obj, key, binary_restore(val, fd, data_offset));
+            return obj;
+        }
+        case json_type_array:
+        {
+            int i;
+            json_object *obj = json_object_new_array();
+            for (i = 0; i < json_object_array_length(hdr); i++)
+                json_object_array_add(obj, binary_restore(json_object_array_get_idx(hdr, i),
+                    fd, data_offset));
+            return obj;
+        }
+        default:
+            break;
+    }
+
+    return json_object_get(hdr);
+}
+
+/* writev all of iov, handling IOV_MAX and short writes */
+static int
+writev_all(int fd, struct iovec *iov, int niov)
+{
+    while (niov > 0)
+    {
+        ssize_t n = writev(fd, iov, niov < IOV_MAX ? niov : IOV_MAX);
+        if (n < 0) return -1;
+        while (niov > 0 && (size_t) n >= iov->iov_len)
+        {
+            n -= iov->iov_len;
+            iov++;
+            niov--;
+        }
+        if (niov > 0)
+        {
+            iov->iov_base = (char *) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return 0;
+}
+
+/* json_object_to_json_sink() callback appending to a stdio stream */
+static int file_sink(void *data, char const *buf, size_t len)
+{
+    return fwrite(buf, 1, len, (FILE *) data) == len ? 0 : -1;
+}
+
+/*!
+\brief Write a single mesh part to a MIF file in binary mode
+
+Writes the part's binary mode header as a single line of JSON followed by the raw
+bytes of all of its extarrs. The extarr offsets in the header are relative to the
+first byte following the header's terminating new-line.
+*/
+static void write_mesh_part_binary(
+    FILE *myFile,          /**< [in] The file handle being used in a MIF dump */
+    json_object *part_obj  /**< [in] The json object representing this mesh part */
+)
+{
+    struct iovec *iov = 0;
+    int niov = 0, maxiov = 0;
+    int64_t offset = 0;
+    json_object *hdr = binary_header(part_obj, &iov, &niov, &maxiov, &offset);
+
+    json_object_to_json_sink(hdr, JSON_C_TO_STRING_PLAIN, file_sink, myFile);
+    fputc('\n', myFile);
+    json_object_put(hdr);
+
+    /* bypass stdio for the data; flushing first keeps the header ahead of it */
+    fflush(myFile);
+    if (writev_all(fileno(myFile), iov, niov) < 0)
+        MACSIO_LOG_MSG(Err, ("writev of %lld bytes of extarr data failed", (long long) offset));
+    fseeko(myFile, 0, SEEK_END);
+    free(iov);
+}
+
 /*!
 \brief Write a single mesh part to a MIF file
 
 All this method does is serialize the JSON object for the given mesh
-part to an ASCII string and then appends/writes that string at the
-end of the current file.
+part to ASCII and append it at the end of the current file.
+
+The object is streamed to the file in bounded chunks by json_object_to_json_sink()
+so the ASCII form of the whole part is never held in memory.
 
-After serializing the object to an ASCII string and writing it to the
-file, the memory for the ASCII string is released by json_object_free_printbuf().
+In binary mode, the part is written by \c write_mesh_part_binary() instead.
 
 \return A tiny JSON object holding the name of the file, the offset at
 which the JSON object for this part was written in the file and the part's ID.
+It is allocated from \c arena.
 */
 static json_object *write_mesh_part(
-    FILE *myFile,          /**< [in] The file handle being used in a MIF dump */
-    char const *fileName,  /**< [in] Name of the MIF file */
-    json_object *part_obj  /**< [in] The json object representing this mesh part */
+    FILE *myFile,             /**< [in] The file handle being used in a MIF dump */
+    char const *fileName,     /**< [in] Name of the MIF file */
+    json_object *part_obj,    /**< [in] The json object representing this mesh part */
+    struct json_arena *arena  /**< [in] The arena holding this dump's part infos */
 )
 {
-    json_object *part_info = json_object_new_object();
+    json_object *part_info;
+    struct json_arena *prev_arena;
 
 #warning SOMEHOW SHOULD INCLUDE OFFSETS TO EACH VARIABLE
-    /* Write the json mesh part object as an ascii string */
-    fprintf(myFile, "%s\n", json_object_to_json_string_ext(part_obj, JSON_C_TO_STRING_PRETTY));
-    json_object_free_printbuf(part_obj);
+    if (binary_mode)
+        write_mesh_part_binary(myFile, part_obj);
+    else
+    {
+        /* Stream the json mesh part object to the file as ascii */
+        if (json_object_to_json_sink(part_obj, JSON_C_TO_STRING_PRETTY, file_sink, myFile))
+            MACSIO_LOG_MSG(Err, ("Unable to write mesh part to \"%s\"", fileName));
+        fputc('\n', myFile);
+    }
 
     /* Form the return 'value' holding the information on where to find this part */
+    prev_arena = json_arena_use(arena);
+    part_info = json_object_new_object();
     json_object_object_add(part_info, "partid",
 #warning CHANGE NAME OF KEY IN JSON TO PartID
-        json_object_new_int(json_object_path_get_int(part_obj, "Mesh/ChunkID")));
+        json_object_new_int(json_path_get_int(part_obj, chunk_id_path)));
     json_object_object_add(part_info, "file",
         json_object_new_string(fileName));
     json_object_object_add(part_info, "offset",
         json_object_new_double((double) ftello(myFile)));
+    json_arena_use(prev_arena);
 
     return part_info;
 }
@@ -339,7 +618,16 @@ static void main_dump(
     MACSIO_MIF_ioFlags_t ioFlags = {MACSIO_MIF_WRITE, JsonGetInt(main_obj, "clargs/exercise_scr")&0x1};
     MACSIO_MIF_baton_t *bat;
     json_object *parts;
-    json_object *part_infos = json_object_new_array();
+    json_object *part_infos;
+    struct json_arena *part_info_arena = json_arena_new(0), *prev_arena;
+
+    if (!part_info_arena)
+        MACSIO_LOG_MSG(Die, ("Unable to create arena for part infos"));
+
+    /* part_infos are only needed for this dump; free them all at once at the end */
+    prev_arena = json_arena_use(part_info_arena);
+    part_infos = json_object_new_array();
+    json_arena_use(prev_arena);
 
     /* process cl args */
     process_args(argi, argc, argv);
@@ -393,7 +681,7 @@ static void main_dump(
     for (int i = 0; i < json_object_array_length(parts); i++)
     {
         json_object *this_part = json_object_array_get_idx(parts, i);
-        json_object_array_add(part_infos, write_mesh_part(myFile, fileName, this_part));
+        json_object_array_add(part_infos, write_mesh_part(myFile, fileName, this_part, part_info_arena));
     }
 
     /* Hand off the baton to the next processor. This winds up closing
@@ -422,14 +710,136 @@ static void main_dump(
 
 #warning FIX THE STRING THAT WE PRODUCE HERE SO ITS A SINGLE JSON ARRAY OBJECT
     /* This processor's work on the file is just to write its part_infos */
-    fprintf(myFile, "%s\n", json_object_to_json_string_ext(part_infos, JSON_C_TO_STRING_PRETTY));
+    json_object_to_json_sink(part_infos, JSON_C_TO_STRING_PRETTY, file_sink, myFile);
+    fputc('\n', myFile);
 
     MACSIO_MIF_HandOffBaton(bat, myFile);
 
     MACSIO_MIF_Finish(bat);
 
-    /* decriment ref-count (and free) part_infos */
-    json_object_put(part_infos);
+    /* free part_infos */
+    json_arena_free(part_info_arena);
+}
+
+/*!
+\brief Main load implementation for this plugin
+
+Reads back the mesh parts of a MIF file written by \c main_dump() with the same
+plugin options (\c --binary in particular). Parts are handed out round-robin over
+the ranks.
+
+The file is mapped read-only and its parts are parsed from the mapping. In binary
+mode, each part's header is parsed and its extarrs are then mapped in place from
+the file (see \c binary_restore()) so no extarr data is read or copied up front;
+pages are faulted in from the page cache as the data is touched.
+
+\return In \c data_read_obj, an array of the mesh parts read by this rank. The
+caller owns it.
+*/
+static void main_load(
+    int argi,                    /**< [in] Command-line argument index at which first plugin-specific arg appears */
+    int argc,                    /**< [in] argc from main */
+    char **argv,                 /**< [in] argv from main */
+    char const *path,            /**< [in] Name of the MIF file to read */
+    json_object *main_obj,       /**< [in] The main json object */
+    json_object **data_read_obj  /**< [out] The mesh parts read by this rank */
+)
+{
+    int rank = json_object_path_get_int(main_obj, "parallel/mpi_rank");
+    int size = json_object_path_get_int(main_obj, "parallel/mpi_size");
+    int fd, partn;
+    int64_t pos = 0, len;
+    struct stat st;
+    struct json_tokener *tok;
+    char const *buf;
+
+    *data_read_obj = json_object_new_array();
+
+    /* process cl args */
+    process_args(argi, argc, argv);
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        MACSIO_LOG_MSG(Err, ("Unable to open \"%s\"", path));
+        return;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        close(fd);
+        return;
+    }
+    len = (int64_t) st.st_size;
+    buf = (char const *) mmap(0, (size_t) len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == (char const *) MAP_FAILED)
+    {
+        MACSIO_LOG_MSG(Err, ("Unable to map \"%s\"", path));
+        close(fd);
+        return;
+    }
+
+    tok = json_tokener_new();
+    for (partn = 0; ; partn++)
+    {
+        json_object *part;
+        int64_t n;
+
+        while (pos < len && isspace((unsigned char) buf[pos]))
+            pos++;
+        if (pos >= len)
+            break;
+
+        /* A binary mode header is a single line and its data begins right after
+           its new-line. Parsing only up to the new-line keeps the tokener from
+           consuming data bytes that look like white space. */
+        if (binary_mode)
+        {
+            char const *nl = (char const *) memchr(buf + pos, '\n', (size_t) (len - pos));
+            n = nl ? nl - (buf + pos) : len - pos;
+        }
+        else
+            n = len - pos;
+
+        json_tokener_reset(tok);
+        part = json_tokener_parse_ex(tok, buf + pos, (int) (n < INT_MAX ? n : INT_MAX));
+        if (!part)
+        {
+            MACSIO_LOG_MSG(Err, ("Unable to parse part %d of \"%s\" at offset %lld: %s", partn, path,
+                (long long) pos, json_tokener_error_desc(json_tokener_get_error(tok))));
+            break;
+        }
+
+        if (binary_mode)
+        {
+            int64_t data_offset = pos + n + 1;
+            int64_t data_end = data_offset + binary_data_end(part);
+
+            /* mapping data past the end of the file would fault when accessed */
+            if (data_end > len)
+            {
+                MACSIO_LOG_MSG(Err, ("Part %d of \"%s\" is truncated: data ends at %lld of %lld bytes",
+                    partn, path, (long long) data_end, (long long) len));
+                json_object_put(part);
+                break;
+            }
+            if (partn % size == rank)
+                json_object_array_add(*data_read_obj, binary_restore(part, fd, data_offset));
+            pos = data_end;
+            json_object_put(part);
+        }
+        else
+        {
+            pos += tok->char_offset;
+            if (partn % size == rank)
+                json_object_array_add(*data_read_obj, part);
+            else
+                json_object_put(part);
+        }
+    }
+    json_tokener_free(tok);
+
+    munmap((void *) buf, (size_t) len);
+    close(fd);
 }
 
 /*!
@@ -453,6 +863,9 @@ static int register_this_interface()
     strcpy(iface.ext, iface_ext);
     iface.dumpFunc = main_dump;
     iface.processArgsFunc = process_args;
+    iface.loadFunc = main_load;
+
+    chunk_id_path = json_path_compile("Mesh/ChunkID");
 
     /* Register this plugin */
     if (!MACSIO_IFACE_Register(&iface))
@@ -350,6 +350,97 @@ static void CloseSiloFile(void *file, void *userData)
         DBClose(siloFile);
 }
 
+/*!
+\brief Write a var of a mesh part
+
+Scalar vars are written with DBPutQuadvar1() or DBPutUcdvar1(). Vector and tensor
+vars are written as a single multi-component Silo var. Silo takes a separate buffer
+for each component so, in the soa layout, these just point into the var's buffer
+while in the aos layout the interleaved components are first copied out. Subset
+vars have no Silo mesh var equivalent and are written as plain arrays of their
+values and, with a \c _subset suffix, their zone indices.
+*/
+static void write_mesh_var(
+    DBfile *dbfile,      /**< [in] The Silo file */
+    json_object *varobj, /**< [in] The var object */
+    int silo_var_type,   /**< [in] DB_QUADVAR or DB_UCDVAR */
+    int *dims,           /**< [in] The var's dimensions for a quad var or its length for a ucd var */
+    int ndims            /**< [in] The number of entries in dims */
+)
+{
+    char const *name = JsonGetStr(varobj, "name");
+    char const *type = JsonGetStr(varobj, "type");
+    int cent = strcmp(JsonGetStr(varobj, "centering"),"zone")?DB_NODECENT:DB_ZONECENT;
+    json_object *dataobj = JsonGetObj(varobj, "data");
+    int dtype = json_object_extarr_type(dataobj)==json_extarr_type_flt64?DB_DOUBLE:DB_INT;
+    char const *data = (char const *) json_object_extarr_data(dataobj);
+    json_object *compsobj;
+    int i, c, ncomps, nvals = 1, aos;
+    size_t size = dtype==DB_DOUBLE ? sizeof(double) : sizeof(int);
+    char **compnames, *tmp = 0;
+    void **comps;
+
+    if (!strcmp(type, "subset"))
+    {
+        char subset_name[256];
+        int n = json_object_extarr_nvals(dataobj);
+
+        snprintf(subset_name, sizeof(subset_name), "%s_subset", name);
+        DBWrite(dbfile, name, (void *) data, &n, 1, dtype);
+        DBWrite(dbfile, subset_name, (void *) json_object_extarr_data(JsonGetObj(varobj, "subset")),
+            &n, 1, DB_INT);
+        return;
+    }
+
+    if (strcmp(type, "vector") && strcmp(type, "tensor"))
+    {
+        if (silo_var_type == DB_QUADVAR)
+            DBPutQuadvar1(dbfile, name, "mesh", (void *) data, dims, ndims, 0, 0, dtype, cent, 0);
+        else
+            DBPutUcdvar1(dbfile, name, "mesh", (void *) data, dims[0], NULL, 0, dtype, cent, NULL);
+        return;
+    }
+
+    for (i = 0; i < ndims; i++)
+        nvals *= dims[i];
+    compsobj = JsonGetObj(varobj, "components");
+    ncomps = json_object_array_length(compsobj);
+    aos = !strcmp(JsonGetStr(varobj, "layout"), "aos");
+    compnames = (char **) malloc(ncomps * sizeof(char*));
+    comps = (void **) malloc(ncomps * sizeof(void*));
+    if (aos)
+        tmp = (char *) malloc(ncomps * nvals * size);
+
+    for (c = 0; c < ncomps; c++)
+    {
+        char const *compname = json_object_get_string(json_object_array_get_idx(compsobj, c));
+        compnames[c] = (char *) malloc(strlen(name) + strlen(compname) + 2);
+        sprintf(compnames[c], "%s_%s", name, compname);
+        if (aos)
+        {
+            char *dst = tmp + c * nvals * size;
+            for (i = 0; i < nvals; i++)
+                memcpy(dst + i * size, data + (i * ncomps + c) * size, size);
+            comps[c] = dst;
+        }
+        else
+            comps[c] = (void *) (data + c * nvals * size);
+    }
+
+    if (silo_var_type == DB_QUADVAR)
+        DBPutQuadvar(dbfile, name, "mesh", ncomps, (DBCAS_t) compnames, comps,
+            dims, ndims, NULL, 0, dtype, cent, NULL);
+    else
+        DBPutUcdvar(dbfile, name, "mesh", ncomps, (DBCAS_t) compnames, comps,
+            dims[0], NULL, 0, dtype, cent, NULL);
+
+    for (c = 0; c < ncomps; c++)
+        free(compnames[c]);
+    free(compnames);
+    free(comps);
+    free(tmp);
+}
+
 static void write_quad_mesh_part(DBfile *dbfile, json_object *part, int silo_mesh_type)
 {
     json_object *coordobj;
@@ -398,11 +489,8 @@ static void write_quad_mesh_part(DBfile *dbfile, json_object *part, int silo_mes
         json_object *varobj = json_object_array_get_idx(vars_array, i);
         int cent = strcmp(JsonGetStr(varobj, "centering"),"zone")?DB_NODECENT:DB_ZONECENT;
         int *d = cent==DB_NODECENT?dims:dimsz;
-        json_object *dataobj = JsonGetObj(varobj, "data");
-        int dtype = json_object_extarr_type(dataobj)==json_extarr_type_flt64?DB_DOUBLE:DB_INT;
-        
-        DBPutQuadvar1(dbfile, JsonGetStr(varobj, "name"), "mesh",
-            (void *)json_object_extarr_data(dataobj), d, ndims, 0, 0, dtype, cent, 0); 
+
+        write_mesh_var(dbfile, varobj, DB_QUADVAR, d, ndims);
     }
 }
 
@@ -511,12 +599,8 @@ static void write_ucdzoo_mesh_part(DBfile *dbfile, json_object *part, char const
         json_object *varobj = json_object_array_get_idx(vars_array, i);
         int cent = strcmp(JsonGetStr(varobj, "centering"),"zone")?DB_NODECENT:DB_ZONECENT;
         int cnt = cent==DB_NODECENT?nnodes:nzones;
-        json_object *dataobj = JsonGetObj(varobj, "data");
-        int dtype = json_object_extarr_type(dataobj)==json_extarr_type_flt64?DB_DOUBLE:DB_INT;
-        
-        DBPutUcdvar1(dbfile, JsonGetStr(varobj, "name"), "mesh",
-            (void*)json_object_extarr_data(dataobj), cnt, NULL, 0, dtype, cent, NULL);
 
+        write_mesh_var(dbfile, varobj, DB_UCDVAR, &cnt, 1);
     }
 }
 
@@ -597,6 +681,10 @@ static void WriteMultiXXXObjects(json_object *main_obj, DBfile *siloFile, int du
     int numVars = json_object_array_length(vars_array);
     for (j = 0; j < numVars; j++)
     {
+        /* subset vars are plain arrays, not mesh vars */
+        if (!strcmp(JsonGetStr(vars_array, "", j, "type"), "subset"))
+            continue;
+
         for (i = 0; i < numChunks; i++)
         {
             int rank_owning_chunk = MACSIO_DATA_GetRankOwningPart(main_obj, i);